@@ -0,0 +1,60 @@
+#!/usr/bin/env python3
+"""Compare two dice_bench JSON reports and flag regressions.
+
+Usage: compare.py BASELINE.json CURRENT.json [--threshold PERCENT] [--metric median_ns|best_ns]
+
+Results are matched on (name, rolls, players). Exits with status 1 when any
+benchmark got slower than the threshold allows, so it can gate CI.
+"""
+import argparse
+import json
+import sys
+
+
+def load(path):
+    with open(path) as f:
+        report = json.load(f)
+    return {(r["name"], r["rolls"], r["players"]): r for r in report["results"]}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("baseline")
+    parser.add_argument("current")
+    parser.add_argument("--threshold", type=float, default=10.0,
+                        help="allowed slowdown in percent (default 10)")
+    parser.add_argument("--metric", choices=["median_ns", "best_ns"], default="median_ns")
+    args = parser.parse_args()
+
+    baseline = load(args.baseline)
+    current = load(args.current)
+    regressions = 0
+
+    print(f"{'benchmark':<28} {'rolls':>10} {'players':>7} {'baseline':>12} {'current':>12} {'change':>8}")
+    for key in sorted(baseline.keys() & current.keys()):
+        before = baseline[key][args.metric]
+        after = current[key][args.metric]
+        change = (after - before) / before * 100.0 if before > 0 else 0.0
+        flag = ""
+        if change > args.threshold:
+            flag = "  REGRESSION"
+            regressions += 1
+        elif change < -args.threshold:
+            flag = "  improved"
+        name, rolls, players = key
+        print(f"{name:<28} {rolls:>10} {players:>7} {before:>12.1f} {after:>12.1f} {change:>+7.1f}%{flag}")
+
+    for key in sorted(baseline.keys() - current.keys()):
+        print(f"missing from current: {key[0]} rolls={key[1]} players={key[2]}")
+    for key in sorted(current.keys() - baseline.keys()):
+        print(f"new in current: {key[0]} rolls={key[1]} players={key[2]}")
+
+    if regressions:
+        print(f"\n{regressions} benchmark(s) regressed by more than {args.threshold:g}%")
+        return 1
+    print(f"\nNo regressions beyond {args.threshold:g}%")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,387 @@
+// Microbenchmarks for the game's hot paths. Builds against the game sources
+// with DICE_GAME_NO_MAIN defined and prints one JSON document of results.
+#include "../main.cpp"
+
+struct BenchResult {
+    string name;
+    uint64_t rolls;
+    int players;
+    int iterations;
+    double bestSeconds;
+    double medianSeconds;
+};
+
+struct BenchOptions {
+    vector<uint64_t> sizes = {100, 1000, 10000, 100000, 1000000, 10000000, 100000000};
+    vector<int> playerCounts = {2, 4};
+    int sides = 6;
+    double minSeconds = 0.25;  // per measurement, across repetitions
+    int minIterations = 3;
+    int maxIterations = 1000;
+    string filter;
+    string output;
+};
+
+const size_t ROLL_BLOCK = size_t(1) << 16;
+const string BENCH_SAVE_FILE = "dice_bench_save.dat";
+volatile size_t rankingSink;  // keeps the ranking from being optimised away
+
+// Answers every "press Enter" prompt.
+class EnterKeys : public streambuf {
+private:
+    char key = '\n';
+
+protected:
+    int_type underflow() override {
+        setg(&key, &key, &key + 1);
+        return traits_type::to_int_type(key);
+    }
+};
+
+class DiscardBuffer : public streambuf {
+protected:
+    int_type overflow(int_type ch) override { return traits_type::not_eof(ch); }
+    streamsize xsputn(const char*, streamsize count) override { return count; }
+};
+
+// Repeats one measurement until enough time has been spent. The body times
+// only the code under test and returns that duration, so any setup it needs
+// stays outside the numbers.
+BenchResult measure(const BenchOptions& options, const string& name, uint64_t rolls, int players,
+                    const function<double()>& body) {
+    vector<double> samples;
+    double total = 0.0;
+    while (static_cast<int>(samples.size()) < options.maxIterations &&
+           (static_cast<int>(samples.size()) < options.minIterations || total < options.minSeconds)) {
+        double seconds = body();
+        samples.push_back(seconds);
+        total += seconds;
+    }
+    sort(samples.begin(), samples.end());
+    return {name, rolls, players, static_cast<int>(samples.size()), samples.front(), samples[samples.size() / 2]};
+}
+
+double secondsSince(chrono::steady_clock::time_point start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// Builds players whose histories add up to the requested number of rolls.
+vector<Player> makePlayers(uint64_t rolls, int count, int sides, uint64_t seed) {
+    DiceRng rng(RngEngine::Xoshiro256, seed);
+    vector<uint8_t> block(ROLL_BLOCK);
+    vector<Player> players;
+    for (int p = 0; p < count; ++p) {
+        players.emplace_back("Player" + to_string(p + 1));
+        uint64_t share = rolls / count + (static_cast<uint64_t>(p) < rolls % count ? 1 : 0);
+        players.back().reserveHistory(share);
+        for (uint64_t done = 0; done < share; done += ROLL_BLOCK) {
+            size_t n = static_cast<size_t>(min<uint64_t>(ROLL_BLOCK, share - done));
+            rng.rollMany(block.data(), n, sides);
+            for (size_t i = 0; i < n; ++i) players.back().addToHistory(block[i]);
+        }
+        players.back().addToScore(static_cast<int>(players.back().getRollSum() % 1000));
+    }
+    return players;
+}
+
+void benchRollGeneration(const BenchOptions& options, uint64_t rolls, vector<BenchResult>& results) {
+    vector<uint8_t> block(ROLL_BLOCK);
+    for (RngEngine engine : {RngEngine::Mt19937, RngEngine::Xoshiro256, RngEngine::Pcg64, RngEngine::Philox}) {
+        DiceRng rng(engine, 1);
+        string name = string("roll_generation/") + rngEngineName(engine);
+        results.push_back(measure(options, name, rolls, 1, [&]() {
+            auto start = chrono::steady_clock::now();
+            for (uint64_t done = 0; done < rolls; done += ROLL_BLOCK) {
+                rng.rollMany(block.data(), static_cast<size_t>(min<uint64_t>(ROLL_BLOCK, rolls - done)),
+                             options.sides);
+            }
+            return secondsSince(start);
+        }));
+
+        // Same draws through the Die<Sides> kernels the game and simulator use.
+        const DieKernels& die = *dieKernels(options.sides);
+        results.push_back(measure(options, name + "/die", rolls, 1, [&]() {
+            auto start = chrono::steady_clock::now();
+            for (uint64_t done = 0; done < rolls; done += ROLL_BLOCK) {
+                die.rollMany(rng, block.data(), static_cast<size_t>(min<uint64_t>(ROLL_BLOCK, rolls - done)));
+            }
+            return secondsSince(start);
+        }));
+    }
+}
+
+void benchStatUpdates(const BenchOptions& options, uint64_t rolls, int playerCount,
+                      vector<BenchResult>& results) {
+    vector<uint8_t> block(ROLL_BLOCK);
+    DiceRng(RngEngine::Xoshiro256, 2).rollMany(block.data(), block.size(), options.sides);
+    results.push_back(measure(options, "stat_updates", rolls, playerCount, [&]() {
+        vector<Player> players;
+        for (int p = 0; p < playerCount; ++p) players.emplace_back("Player" + to_string(p + 1));
+        auto start = chrono::steady_clock::now();
+        for (uint64_t i = 0; i < rolls; ++i) {
+            players[i % playerCount].addToHistory(block[i & (ROLL_BLOCK - 1)]);
+        }
+        return secondsSince(start);
+    }));
+}
+
+// Full interactive rounds, rendering included, with animations off and the
+// frames discarded. A few rounds warm the reused buffers up first. That
+// these rounds do not touch the heap is checked by the round_allocations
+// test.
+void benchRoundLoop(const BenchOptions& options, uint64_t rolls, int playerCount,
+                    vector<BenchResult>& results) {
+    if (rolls > 100000) return;  // every turn renders full frames
+    const int WARMUP_ROUNDS = 4;
+    int rounds = static_cast<int>(max<uint64_t>(1, rolls / playerCount));
+    results.push_back(measure(options, "round_loop", rolls, playerCount, [&]() {
+        EnterKeys keys;
+        istream input(&keys);
+        DiscardBuffer discard;
+        ostream sink(&discard);
+        GameOptions gameOptions;
+        gameOptions.animationSpeed = 0.0;
+        gameOptions.reproducible = true;
+        gameOptions.hasSeed = true;
+        gameOptions.seed = rolls;
+        gameOptions.input = &input;
+        gameOptions.output = &sink;
+
+        DiceGame game(gameOptions);
+        RuleSet rules = houseRules();  // the interactive default, bonuses included
+        rules.rounds = rounds + WARMUP_ROUNDS;
+        game.configure(options.sides, rules);
+        for (int p = 0; p < playerCount; ++p) game.addPlayer("Player" + to_string(p + 1));
+        game.reserveRounds();
+        for (int i = 0; i < WARMUP_ROUNDS; ++i) game.playRound(0);
+        game.drainEvents();  // consumer threads set up on their first batch
+
+        auto start = chrono::steady_clock::now();
+        for (int i = 0; i < rounds; ++i) game.playRound(0);
+        return secondsSince(start);
+    }));
+}
+
+void benchSaveLoad(const BenchOptions& options, uint64_t rolls, const vector<Player>& players,
+                   vector<BenchResult>& results) {
+    int playerCount = static_cast<int>(players.size());
+    results.push_back(measure(options, "save_load", rolls, playerCount, [&]() {
+        auto start = chrono::steady_clock::now();
+        vector<uint8_t> bytes = encodeSaveGame(RuleSet(), 5, options.sides, players);
+        bool ok = writeFileAtomically(BENCH_SAVE_FILE, bytes);
+        MappedFile file;
+        SavedGame saved;
+        ok = ok && file.open(BENCH_SAVE_FILE) && decodeSaveGame(file.data(), file.size(), saved);
+        double seconds = secondsSince(start);
+        if (!ok || saved.players.size() != players.size()) {
+            cerr << RED << "save/load round trip failed" << RESET << "\n";
+            exit(1);
+        }
+        return seconds;
+    }));
+    remove(BENCH_SAVE_FILE.c_str());
+}
+
+void benchFrequencyAnalysis(const BenchOptions& options, uint64_t rolls, const vector<Player>& players,
+                            vector<BenchResult>& results) {
+    int playerCount = static_cast<int>(players.size());
+    results.push_back(measure(options, "frequency_analysis", rolls, playerCount, [&]() {
+        auto start = chrono::steady_clock::now();
+        GameAnalysis analysis = analyzePlayers(players, options.sides);
+        double seconds = secondsSince(start);
+        if (analysis.combined.count != rolls) {
+            cerr << RED << "frequency analysis counted " << analysis.combined.count << " rolls" << RESET << "\n";
+            exit(1);
+        }
+        return seconds;
+    }));
+}
+
+void benchFinalRanking(const BenchOptions& options, uint64_t rolls, const vector<Player>& players,
+                       vector<BenchResult>& results) {
+    int playerCount = static_cast<int>(players.size());
+    // A ranking of a handful of players is far below the clock resolution, so
+    // each sample times a batch and reports the cost of one ranking.
+    const int BATCH = 256;
+    results.push_back(measure(options, "final_ranking", rolls, playerCount, [&]() {
+        double seconds = 0.0;
+        for (int i = 0; i < BATCH; ++i) {
+            auto start = chrono::steady_clock::now();
+            rankingSink = rankPlayers(players).front();
+            seconds += secondsSince(start);
+        }
+        return seconds / BATCH;
+    }));
+}
+
+// Publishing rolls through the event bus with no-op consumers attached.
+// The consumer threads are started outside the timed region; the drain at
+// the end is inside it, so the figure covers delivery, not just the enqueue.
+void benchEventPublish(const BenchOptions& options, uint64_t rolls, vector<BenchResult>& results) {
+    if (rolls > 10000000) return;  // a ring hop per roll; the larger sizes add nothing but time
+    for (int consumers : {0, 1, 4}) {
+        string name = "event_publish/" + to_string(consumers);
+        results.push_back(measure(options, name, rolls, 1, [&]() {
+            RollEventBus bus;
+            atomic<uint64_t> delivered(0);
+            for (int c = 0; c < consumers; ++c) {
+                bus.subscribe([&delivered](const RollEvent*, size_t count) {
+                    delivered.fetch_add(count, memory_order_relaxed);
+                });
+            }
+            RollEvent event{RollEventType::Roll, 0, 1, 1, 0, chrono::steady_clock::time_point()};
+            auto start = chrono::steady_clock::now();
+            for (uint64_t i = 0; i < rolls; ++i) {
+                event.value = static_cast<uint16_t>(1 + i % 6);
+                bus.publish(event);
+            }
+            bus.drain();
+            double seconds = secondsSince(start);
+            rankingSink = delivered.load();
+            return seconds;
+        }));
+    }
+}
+
+bool selected(const BenchOptions& options, const string& name) {
+    return options.filter.empty() || name.find(options.filter) != string::npos;
+}
+
+string jsonEscape(const string& text) {
+    string escaped;
+    for (char c : text) {
+        if (c == '"' || c == '\\') escaped += '\\';
+        escaped += c;
+    }
+    return escaped;
+}
+
+void writeJson(ostream& out, const BenchOptions& options, const vector<BenchResult>& results) {
+    out << "{\n  \"benchmark\": \"dice_bench\",\n  \"sides\": " << options.sides
+        << ",\n  \"threads\": " << thread::hardware_concurrency() << ",\n  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchResult& r = results[i];
+        double perRoll = r.rolls > 0 ? r.medianSeconds * 1e9 / r.rolls : 0.0;
+        out << "    {\"name\": \"" << jsonEscape(r.name) << "\", \"rolls\": " << r.rolls
+            << ", \"players\": " << r.players << ", \"iterations\": " << r.iterations
+            << fixed << setprecision(1)
+            << ", \"best_ns\": " << r.bestSeconds * 1e9 << ", \"median_ns\": " << r.medianSeconds * 1e9
+            << setprecision(4) << ", \"ns_per_roll\": " << perRoll << "}"
+            << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    out << "  ]\n}\n";
+}
+
+bool parseList(const char* text, long long minValue, long long maxValue, vector<long long>& values) {
+    values.clear();
+    stringstream list(text);
+    string item;
+    while (getline(list, item, ',')) {
+        long long value = 0;
+        // Accept 1e6 style sizes as well as plain integers.
+        size_t e = item.find_first_of("eE");
+        if (e != string::npos) {
+            long long mantissa = 0, exponent = 0;
+            if (!parseNumber(item.substr(0, e).c_str(), 1, 9, mantissa) ||
+                !parseNumber(item.substr(e + 1).c_str(), 0, 18, exponent)) return false;
+            value = mantissa;
+            while (exponent-- > 0) value *= 10;
+            if (value < minValue || value > maxValue) return false;
+        } else if (!parseNumber(item.c_str(), minValue, maxValue, value)) {
+            return false;
+        }
+        values.push_back(value);
+    }
+    return !values.empty();
+}
+
+void printBenchUsage(const char* program) {
+    cerr << "Usage: " << program << " [--sizes 1e2,1e4,...] [--players 2,4] [--sides S]\n"
+         << "       [--min-time SECONDS] [--filter NAME] [--out FILE] [--quick]\n";
+}
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    for (int i = 1; i < argc; ++i) {
+        string flag = argv[i];
+        const char* arg = "";
+        auto nextValue = [&]() {
+            if (i + 1 >= argc) return false;
+            arg = argv[++i];
+            return true;
+        };
+        vector<long long> values;
+        long long value = 0;
+        bool ok;
+
+        if (flag == "--sizes") {
+            ok = nextValue() && parseList(arg, 1, 1000000000LL, values);
+            options.sizes.assign(values.begin(), values.end());
+        } else if (flag == "--players") {
+            ok = nextValue() && parseList(arg, 1, 255, values);
+            options.playerCounts.assign(values.begin(), values.end());
+        } else if (flag == "--sides") {
+            ok = nextValue() && parseNumber(arg, 4, 12, value);
+            options.sides = static_cast<int>(value);
+        } else if (flag == "--min-time") {
+            char* end = nullptr;
+            ok = nextValue();
+            options.minSeconds = ok ? strtod(arg, &end) : 0.0;
+            ok = ok && end != arg && *end == '\0' && options.minSeconds >= 0.0;
+        } else if (flag == "--filter") {
+            ok = nextValue();
+            options.filter = arg;
+        } else if (flag == "--out") {
+            ok = nextValue();
+            options.output = arg;
+        } else if (flag == "--quick") {
+            ok = true;
+            options.sizes = {100, 10000, 1000000};
+            options.minSeconds = 0.05;
+        } else {
+            ok = false;
+        }
+
+        if (!ok) {
+            cerr << RED << "Invalid argument: " << flag << (*arg ? string(" ") + arg : "") << RESET << "\n";
+            printBenchUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    vector<BenchResult> results;
+    for (uint64_t rolls : options.sizes) {
+        size_t first = results.size();
+        if (selected(options, "roll_generation")) benchRollGeneration(options, rolls, results);
+        if (selected(options, "event_publish")) benchEventPublish(options, rolls, results);
+        for (int playerCount : options.playerCounts) {
+            if (selected(options, "stat_updates")) benchStatUpdates(options, rolls, playerCount, results);
+            if (selected(options, "round_loop")) benchRoundLoop(options, rolls, playerCount, results);
+            bool needPlayers = selected(options, "save_load") || selected(options, "frequency_analysis") ||
+                               selected(options, "final_ranking");
+            if (!needPlayers) continue;
+            vector<Player> players = makePlayers(rolls, playerCount, options.sides, rolls);
+            if (selected(options, "save_load")) benchSaveLoad(options, rolls, players, results);
+            if (selected(options, "frequency_analysis")) benchFrequencyAnalysis(options, rolls, players, results);
+            if (selected(options, "final_ranking")) benchFinalRanking(options, rolls, players, results);
+        }
+        for (size_t i = first; i < results.size(); ++i) {
+            const BenchResult& r = results[i];
+            cerr << left << setw(32) << r.name << right << setw(11) << r.rolls << " rolls "
+                 << setw(3) << r.players << " players " << fixed << setprecision(3)
+                 << setw(12) << r.medianSeconds * 1e3 << " ms  (" << r.iterations << " runs)\n";
+        }
+    }
+
+    if (options.output.empty()) {
+        writeJson(cout, options, results);
+        return 0;
+    }
+    ofstream file(options.output, ios::trunc);
+    writeJson(file, options, results);
+    if (!file) {
+        cerr << RED << "Cannot write " << options.output << RESET << "\n";
+        return 1;
+    }
+    return 0;
+}
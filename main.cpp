@@ -13,6 +13,46 @@
 #include <map>
 #include <numeric>
 #include <random>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <cstdint>
+#include <cmath>
+#include <cstring>
+#include <cerrno>
+#include <csignal>
+#include <cctype>
+#include <cstdio>
+#include <iterator>
+#include <variant>
+#include <functional>
+#include <unordered_map>
+#include <list>
+#include <array>
+#include <string_view>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <poll.h>
+#include <termios.h>
+#include <signal.h>
+#include <pthread.h>
+#endif
+#ifdef __linux__
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#endif
 
 using namespace std;
 
@@ -33,550 +73,7511 @@ const vector<string> DICE_ART = {
     "┌───────┐\n│ ●     │\n│   ●   │\n│     ● │\n└───────┘",  // 3
     "┌───────┐\n│ ●   ● │\n│       │\n│ ●   ● │\n└───────┘",  // 4
     "┌───────┐\n│ ●   ● │\n│   ●   │\n│ ●   ● │\n└───────┘",  // 5
-    "┌───────┐\n│ ●   ● │\n│ ●   ● │\n│ ●   ● │\n└───────┘"   // 6
+    "┌───────┐\n│ ●   ● │\n│ ●   ● │\n│ ●   ● │\n└───────┘",  // 6
+    "┌───────┐\n│ ●   ● │\n│ ● ● ● │\n│ ●   ● │\n└───────┘",  // 7
+    "┌───────┐\n│ ● ● ● │\n│ ●   ● │\n│ ● ● ● │\n└───────┘",  // 8
+    "┌───────┐\n│ ● ● ● │\n│ ● ● ● │\n│ ● ● ● │\n└───────┘",  // 9
+    "┌───────┐\n│● ● ● ●│\n│ ●   ● │\n│● ● ● ●│\n└───────┘",  // 10
+    "┌───────┐\n│● ● ● ●│\n│ ● ● ● │\n│● ● ● ●│\n└───────┘",  // 11
+    "┌───────┐\n│● ● ● ●│\n│● ● ● ●│\n│● ● ● ●│\n└───────┘"   // 12
+};
+
+enum class RngEngine : uint8_t { Mt19937 = 0, Xoshiro256 = 1, Pcg64 = 2, Philox = 3 };
+
+const char* rngEngineName(RngEngine engine) {
+    switch (engine) {
+        case RngEngine::Xoshiro256: return "xoshiro256";
+        case RngEngine::Pcg64: return "pcg64";
+        case RngEngine::Philox: return "philox";
+        default: return "mt19937";
+    }
+}
+
+bool parseRngEngine(const string& name, RngEngine& engine) {
+    for (uint8_t id = 0; id <= static_cast<uint8_t>(RngEngine::Philox); ++id) {
+        if (name == rngEngineName(static_cast<RngEngine>(id))) {
+            engine = static_cast<RngEngine>(id);
+            return true;
+        }
+    }
+    return false;
+}
+
+uint64_t splitMix64(uint64_t& state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// The full 128-bit product of a and b as a high/low pair.
+void multiply64(uint64_t a, uint64_t b, uint64_t& high, uint64_t& low) {
+#ifdef __SIZEOF_INT128__
+    unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+    high = static_cast<uint64_t>(product >> 64);
+    low = static_cast<uint64_t>(product);
+#else
+    uint64_t aLo = a & 0xFFFFFFFF, aHi = a >> 32, bLo = b & 0xFFFFFFFF, bHi = b >> 32;
+    uint64_t ll = aLo * bLo, lh = aLo * bHi, hl = aHi * bLo, hh = aHi * bHi;
+    uint64_t mid = (ll >> 32) + (lh & 0xFFFFFFFF) + (hl & 0xFFFFFFFF);
+    high = hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+    low = (mid << 32) | (ll & 0xFFFFFFFF);
+#endif
+}
+
+// Every engine hands out raw 32-bit words through next32() and fill();
+// range reduction to die faces lives in DiceRng.
+class Mt19937Engine {
+private:
+    mt19937 engine;
+
+public:
+    void seed(uint64_t seed, uint64_t stream) {
+        seed_seq seq{static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32),
+                     static_cast<uint32_t>(stream), static_cast<uint32_t>(stream >> 32)};
+        engine.seed(seq);
+    }
+    uint32_t next32() { return static_cast<uint32_t>(engine()); }
+    void fill(uint32_t* out, size_t count) {
+        for (size_t i = 0; i < count; ++i) out[i] = static_cast<uint32_t>(engine());
+    }
+};
+
+class Xoshiro256Engine {
+private:
+    uint64_t state[4];
+    uint64_t spare;
+    bool hasSpare;
+
+    static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+public:
+    void seed(uint64_t seed, uint64_t stream) {
+        uint64_t mix = seed ^ splitMix64(stream);
+        for (auto& word : state) word = splitMix64(mix);
+        hasSpare = false;
+    }
+    uint64_t next64() {
+        uint64_t result = rotl(state[1] * 5, 7) * 9;
+        uint64_t t = state[1] << 17;
+        state[2] ^= state[0];
+        state[3] ^= state[1];
+        state[1] ^= state[2];
+        state[0] ^= state[3];
+        state[2] ^= t;
+        state[3] = rotl(state[3], 45);
+        return result;
+    }
+    uint32_t next32() {
+        if (hasSpare) {
+            hasSpare = false;
+            return static_cast<uint32_t>(spare >> 32);
+        }
+        spare = next64();
+        hasSpare = true;
+        return static_cast<uint32_t>(spare);
+    }
+    void fill(uint32_t* out, size_t count) {
+        size_t i = 0;
+        for (; i + 1 < count; i += 2) {
+            uint64_t word = next64();
+            out[i] = static_cast<uint32_t>(word);
+            out[i + 1] = static_cast<uint32_t>(word >> 32);
+        }
+        if (i < count) out[i] = next32();
+    }
+};
+
+// PCG-XSL-RR 128/64, the generator behind numpy's PCG64.
+class Pcg64Engine {
+private:
+    uint64_t stateHi, stateLo, incHi, incLo;
+    uint64_t spare;
+    bool hasSpare;
+
+    void step() {
+        const uint64_t multHi = 0x2360ED051FC65DA4ULL, multLo = 0x4385DF649FCCF645ULL;
+        uint64_t hi, lo;
+        multiply64(stateLo, multLo, hi, lo);
+        hi += stateLo * multHi + stateHi * multLo;
+        lo += incLo;
+        hi += incHi + (lo < incLo ? 1 : 0);
+        stateHi = hi;
+        stateLo = lo;
+    }
+
+public:
+    void seed(uint64_t seed, uint64_t stream) {
+        incHi = stream >> 63;
+        incLo = (stream << 1) | 1;
+        stateHi = stateLo = 0;
+        step();
+        uint64_t mix = seed;
+        uint64_t addHi = splitMix64(mix), addLo = seed;
+        stateLo += addLo;
+        stateHi += addHi + (stateLo < addLo ? 1 : 0);
+        step();
+        hasSpare = false;
+    }
+    uint64_t next64() {
+        step();
+        uint64_t folded = stateHi ^ stateLo;
+        unsigned rot = static_cast<unsigned>(stateHi >> 58);
+        return (folded >> rot) | (folded << ((64 - rot) & 63));
+    }
+    uint32_t next32() {
+        if (hasSpare) {
+            hasSpare = false;
+            return static_cast<uint32_t>(spare >> 32);
+        }
+        spare = next64();
+        hasSpare = true;
+        return static_cast<uint32_t>(spare);
+    }
+    void fill(uint32_t* out, size_t count) {
+        size_t i = 0;
+        for (; i + 1 < count; i += 2) {
+            uint64_t word = next64();
+            out[i] = static_cast<uint32_t>(word);
+            out[i + 1] = static_cast<uint32_t>(word >> 32);
+        }
+        if (i < count) out[i] = next32();
+    }
+};
+
+// Philox4x32-10 counter-based generator. The key is the seed and the upper
+// half of the counter is the stream, so every (seed, stream) pair is an
+// independent, reproducible sequence with no shared state between threads.
+class PhiloxEngine {
+private:
+    uint32_t key[2];
+    uint32_t counter[4];
+    uint32_t block[4];
+    unsigned used;
+
+    void generate(uint32_t* out) {
+        uint32_t c0 = counter[0], c1 = counter[1], c2 = counter[2], c3 = counter[3];
+        uint32_t k0 = key[0], k1 = key[1];
+        for (int round = 0; round < 10; ++round) {
+            uint64_t p0 = uint64_t(0xD2511F53) * c0;
+            uint64_t p1 = uint64_t(0xCD9E8D57) * c2;
+            uint32_t n0 = static_cast<uint32_t>(p1 >> 32) ^ c1 ^ k0;
+            uint32_t n2 = static_cast<uint32_t>(p0 >> 32) ^ c3 ^ k1;
+            c0 = n0;
+            c1 = static_cast<uint32_t>(p1);
+            c2 = n2;
+            c3 = static_cast<uint32_t>(p0);
+            k0 += 0x9E3779B9;
+            k1 += 0xBB67AE85;
+        }
+        out[0] = c0;
+        out[1] = c1;
+        out[2] = c2;
+        out[3] = c3;
+        if (++counter[0] == 0) counter[1]++;
+    }
+
+public:
+    void seed(uint64_t seed, uint64_t stream) {
+        key[0] = static_cast<uint32_t>(seed);
+        key[1] = static_cast<uint32_t>(seed >> 32);
+        counter[0] = counter[1] = 0;
+        counter[2] = static_cast<uint32_t>(stream);
+        counter[3] = static_cast<uint32_t>(stream >> 32);
+        used = 4;
+    }
+    uint32_t next32() {
+        if (used == 4) {
+            generate(block);
+            used = 0;
+        }
+        return block[used++];
+    }
+    void fill(uint32_t* out, size_t count) {
+        size_t i = 0;
+        while (i < count && used < 4) out[i++] = block[used++];
+        for (; i + 4 <= count; i += 4) generate(out + i);
+        while (i < count) out[i++] = next32();
+    }
+};
+
+// Draws whose low product word falls below this are biased and redrawn.
+constexpr uint32_t rejectionThreshold(uint32_t sides) {
+    return (0u - sides) % sides;
+}
+
+// Unbiased Lemire reduction of a 32-bit draw to 1..sides. Sides is either a
+// plain uint32_t or an integral_constant, in which case the threshold folds
+// to a constant.
+template <typename Engine, typename Sides>
+inline int rollWith(Engine& engine, Sides sides) {
+    uint64_t product = uint64_t(engine.next32()) * sides;
+    uint32_t low = static_cast<uint32_t>(product);
+    if (low < sides) {
+        uint32_t threshold = rejectionThreshold(sides);
+        while (low < threshold) {
+            product = uint64_t(engine.next32()) * sides;
+            low = static_cast<uint32_t>(product);
+        }
+    }
+    return static_cast<int>(product >> 32) + 1;
+}
+
+// Fills out[] with faces in blocks: raw words are generated in one go and
+// reduced with a branch-free loop; the rare draws that land in the biased
+// zone are redrawn one at a time afterwards.
+template <typename Engine, typename Sides>
+void rollManyWith(Engine& engine, uint8_t* out, size_t count, Sides sides) {
+    const uint32_t threshold = rejectionThreshold(sides);
+    const size_t BLOCK = 256;
+    uint32_t raw[BLOCK];
+
+    while (count > 0) {
+        size_t block = min(count, BLOCK);
+        engine.fill(raw, block);
+        uint32_t rejected = 0;
+        size_t i = 0;
+#ifdef __AVX2__
+        const __m256i sidesVec = _mm256_set1_epi32(static_cast<int>(uint32_t(sides)));
+        const __m256i signBit = _mm256_set1_epi32(static_cast<int>(0x80000000u));
+        const __m256i thresholdVec = _mm256_xor_si256(_mm256_set1_epi32(static_cast<int>(threshold)), signBit);
+        const __m256i one = _mm256_set1_epi32(1);
+        for (; i + 8 <= block; i += 8) {
+            __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(raw + i));
+            __m256i even = _mm256_mul_epu32(x, sidesVec);
+            __m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(x, 32), sidesVec);
+            __m256i high = _mm256_blend_epi32(_mm256_srli_epi64(even, 32), odd, 0xAA);
+            __m256i low = _mm256_blend_epi32(even, _mm256_slli_epi64(odd, 32), 0xAA);
+            __m256i biased = _mm256_cmpgt_epi32(thresholdVec, _mm256_xor_si256(low, signBit));
+            rejected |= static_cast<uint32_t>(_mm256_movemask_epi8(biased));
+            __m256i faces = _mm256_add_epi32(high, one);
+            __m256i packed = _mm256_packus_epi16(_mm256_packus_epi32(faces, faces), faces);
+            uint32_t lowHalf = static_cast<uint32_t>(_mm_cvtsi128_si32(_mm256_castsi256_si128(packed)));
+            uint32_t highHalf = static_cast<uint32_t>(_mm_cvtsi128_si32(_mm256_extracti128_si256(packed, 1)));
+            memcpy(out + i, &lowHalf, 4);
+            memcpy(out + i + 4, &highHalf, 4);
+        }
+#endif
+        for (; i < block; ++i) {
+            uint64_t product = uint64_t(raw[i]) * sides;
+            out[i] = static_cast<uint8_t>((product >> 32) + 1);
+            rejected |= static_cast<uint32_t>(static_cast<uint32_t>(product) < threshold);
+        }
+        if (rejected) {
+            for (size_t j = 0; j < block; ++j) {
+                if (static_cast<uint32_t>(uint64_t(raw[j]) * sides) < threshold) {
+                    out[j] = static_cast<uint8_t>(rollWith(engine, sides));
+                }
+            }
+        }
+        out += block;
+        count -= block;
+    }
+}
+
+class DiceRng {
+private:
+    RngEngine engine;
+    variant<Mt19937Engine, Xoshiro256Engine, Pcg64Engine, PhiloxEngine> state;
+
+public:
+    DiceRng(RngEngine rngEngine = RngEngine::Mt19937, uint64_t seed = 0, uint64_t stream = 0) {
+        select(rngEngine, seed, stream);
+    }
+
+    void select(RngEngine rngEngine, uint64_t seed, uint64_t stream = 0) {
+        engine = rngEngine;
+        switch (engine) {
+            case RngEngine::Xoshiro256: state.emplace<Xoshiro256Engine>(); break;
+            case RngEngine::Pcg64: state.emplace<Pcg64Engine>(); break;
+            case RngEngine::Philox: state.emplace<PhiloxEngine>(); break;
+            default: state.emplace<Mt19937Engine>(); break;
+        }
+        this->seed(seed, stream);
+    }
+
+    void seed(uint64_t seed, uint64_t stream = 0) {
+        visit([&](auto& generator) { generator.seed(seed, stream); }, state);
+    }
+
+    RngEngine getEngine() const { return engine; }
+
+    int roll(int sides) {
+        return visit([&](auto& generator) { return rollWith(generator, static_cast<uint32_t>(sides)); }, state);
+    }
+
+    void rollMany(uint8_t* out, size_t count, int sides) {
+        visit([&](auto& generator) { rollManyWith(generator, out, count, static_cast<uint32_t>(sides)); }, state);
+    }
+
+    // Runs fn on the concrete engine so callers can inline its draws.
+    template <typename Fn>
+    auto withEngine(Fn&& fn) {
+        return visit(forward<Fn>(fn), state);
+    }
+};
+
+// Roll values packed into 4-bit nibbles, widened to 8 bits per roll once a
+// value above 15 shows up. Keeps a per-face count table alongside.
+const int MAX_PACKED_ROLL = 255;
+const size_t HISTORY_CHUNK_WORDS = 512;  // 8192 nibble-packed rolls
+
+// A full run of a history's packed words. Chunks never change once sealed
+// and are shared by reference count, so copies of a history and timeline
+// snapshots of it point at the same rolls instead of copying them. Each
+// chunk owns the one before it and records the history as of its end.
+struct HistoryChunk {
+    shared_ptr<const HistoryChunk> previous;
+    size_t index;            // chunks before this one
+    size_t rolls;            // rolls up to the end of this chunk; short of a full chunk only for a frozen tail
+    unsigned bits;
+    vector<uint64_t> faces;  // face counts over those rolls
+    array<uint64_t, HISTORY_CHUNK_WORDS> words;
+};
+
+// Drops a reference to a chunk chain one link at a time; leaving it to each
+// chunk's destructor to release the one before would recurse per chunk.
+inline void releaseChunks(shared_ptr<const HistoryChunk>& chunk) {
+    while (chunk && chunk.use_count() == 1) {
+        shared_ptr<const HistoryChunk> previous = chunk->previous;
+        chunk = move(previous);
+    }
+    chunk.reset();
+}
+
+class RollHistory {
+private:
+    shared_ptr<const HistoryChunk> sealed;   // last full chunk, owning the ones before
+    vector<const HistoryChunk*> chunks;      // the sealed chain in order, for indexing
+    vector<uint64_t> tail;                   // words after the sealed chunks
+    vector<shared_ptr<HistoryChunk>> spare;  // blank chunks set aside by reserve(), never shared
+    vector<uint64_t> faceCounts;
+    size_t count;
+    size_t sealedCount;                      // rolls in the sealed chunks
+    unsigned bits;
+
+    unsigned rollsPerWord() const { return 64 / bits; }
+    size_t chunkRolls() const { return HISTORY_CHUNK_WORDS * rollsPerWord(); }
+
+    // Stores the tail and the history's state so far in chunk.
+    shared_ptr<HistoryChunk> fillChunk(shared_ptr<HistoryChunk> chunk) const {
+        chunk->previous = sealed;
+        chunk->index = chunks.size();
+        chunk->rolls = count;
+        chunk->bits = bits;
+        chunk->faces.assign(faceCounts.begin(), faceCounts.end());
+        copy(tail.begin(), tail.end(), chunk->words.begin());
+        fill(chunk->words.begin() + tail.size(), chunk->words.end(), 0);
+        return chunk;
+    }
+
+    void seal() {
+        shared_ptr<HistoryChunk> chunk;
+        if (spare.empty()) {
+            chunk = make_shared<HistoryChunk>();
+        } else {
+            chunk = move(spare.back());
+            spare.pop_back();
+        }
+        sealed = fillChunk(move(chunk));
+        chunks.push_back(sealed.get());
+        sealedCount = count;
+        tail.clear();
+    }
+
+    void widen() {
+        RollHistory wide;
+        wide.bits = 8;
+        for (size_t i = 0; i < count; ++i) wide.push_back((*this)[i]);
+        swap(wide);
+        spare.swap(wide.spare);
+    }
+
+public:
+    class const_iterator {
+    private:
+        const RollHistory* history;
+        size_t index;
+
+    public:
+        using iterator_category = forward_iterator_tag;
+        using value_type = int;
+        using difference_type = ptrdiff_t;
+        using pointer = const int*;
+        using reference = int;
+
+        const_iterator(const RollHistory* owner, size_t position) : history(owner), index(position) {}
+
+        int operator*() const { return (*history)[index]; }
+        const_iterator& operator++() { ++index; return *this; }
+        const_iterator operator++(int) { const_iterator old = *this; ++index; return old; }
+        bool operator==(const const_iterator& other) const { return index == other.index; }
+        bool operator!=(const const_iterator& other) const { return index != other.index; }
+    };
+
+    RollHistory() : count(0), sealedCount(0), bits(4) {}
+
+    // Copies share the sealed chunks; only the tail is copied.
+    RollHistory(const RollHistory& other)
+        : sealed(other.sealed), chunks(other.chunks), tail(other.tail), faceCounts(other.faceCounts),
+          count(other.count), sealedCount(other.sealedCount), bits(other.bits) {}
+
+    RollHistory(RollHistory&& other) noexcept : RollHistory() { swap(other); }
+
+    RollHistory& operator=(RollHistory other) noexcept {
+        swap(other);
+        return *this;
+    }
+
+    ~RollHistory() { releaseChunks(sealed); }
+
+    void swap(RollHistory& other) noexcept {
+        std::swap(sealed, other.sealed);
+        std::swap(chunks, other.chunks);
+        std::swap(tail, other.tail);
+        std::swap(spare, other.spare);
+        std::swap(faceCounts, other.faceCounts);
+        std::swap(count, other.count);
+        std::swap(sealedCount, other.sealedCount);
+        std::swap(bits, other.bits);
+    }
+
+    // Refuses a value that does not fit 8 bits rather than storing a
+    // different one.
+    bool push_back(int value) {
+        if (value < 0 || value > MAX_PACKED_ROLL) return false;
+        unsigned roll = static_cast<unsigned>(value);
+        if (roll > 15 && bits == 4) widen();
+        unsigned perWord = rollsPerWord();
+        size_t position = count - sealedCount;
+        if (position == chunkRolls()) {
+            seal();
+            position = 0;
+        }
+        if (position % perWord == 0) tail.push_back(0);
+        tail.back() |= uint64_t(roll) << (bits * (position % perWord));
+        count++;
+        if (roll >= faceCounts.size()) faceCounts.resize(roll + 1);
+        faceCounts[roll]++;
+        return true;
+    }
+
+    int operator[](size_t index) const {
+        unsigned perWord = rollsPerWord();
+        uint64_t mask = (uint64_t(1) << bits) - 1;
+        return static_cast<int>((word(index / perWord) >> (bits * (index % perWord))) & mask);
+    }
+
+    uint64_t word(size_t index) const {
+        size_t chunk = index / HISTORY_CHUNK_WORDS;
+        return chunk < chunks.size() ? chunks[chunk]->words[index % HISTORY_CHUNK_WORDS]
+                                     : tail[index - chunks.size() * HISTORY_CHUNK_WORDS];
+    }
+
+    size_t wordCount() const { return chunks.size() * HISTORY_CHUNK_WORDS + tail.size(); }
+
+    // Calls fn(words, count) for each contiguous run of packed words, in order.
+    template <typename Fn>
+    void forEachWordRun(Fn fn) const {
+        for (const HistoryChunk* chunk : chunks) fn(chunk->words.data(), HISTORY_CHUNK_WORDS);
+        if (!tail.empty()) fn(tail.data(), tail.size());
+    }
+
+    // Sets aside the chunks and index room for rolls in all, so appending
+    // up to that many never allocates.
+    void reserve(size_t rolls) {
+        size_t total = rolls > 0 ? (rolls - 1) / chunkRolls() : 0;  // chunks sealed by then
+        chunks.reserve(total);
+        tail.reserve(min(HISTORY_CHUNK_WORDS, (rolls + rollsPerWord() - 1) / rollsPerWord()));
+        faceCounts.reserve(size_t(1) << bits);
+        while (chunks.size() + spare.size() < total) {
+            shared_ptr<HistoryChunk> chunk = make_shared<HistoryChunk>();
+            chunk->faces.reserve(size_t(1) << bits);
+            spare.push_back(move(chunk));
+        }
+    }
+
+    // Adopts already packed words and rebuilds the face counts in one pass.
+    bool assignPacked(vector<uint64_t>&& packed, size_t rolls, unsigned rollBits) {
+        if ((rollBits != 4 && rollBits != 8) || packed.size() != (rolls * rollBits + 63) / 64) return false;
+        clear();
+        bits = rollBits;
+        unsigned perWord = rollsPerWord();
+        uint64_t mask = (uint64_t(1) << bits) - 1;
+        faceCounts.assign(uint64_t(1) << bits, 0);
+        for (size_t w = 0; w < packed.size(); ++w) {
+            if (tail.size() == HISTORY_CHUNK_WORDS) seal();
+            tail.push_back(packed[w]);
+            size_t inWord = min<size_t>(perWord, rolls - w * perWord);
+            for (size_t r = 0; r < inWord; ++r) faceCounts[(packed[w] >> (bits * r)) & mask]++;
+            count += inWord;
+        }
+        while (!faceCounts.empty() && faceCounts.back() == 0) faceCounts.pop_back();
+        return true;
+    }
+
+    void clear() {
+        releaseChunks(sealed);
+        chunks.clear();
+        tail.clear();
+        faceCounts.clear();
+        count = 0;
+        sealedCount = 0;
+        bits = 4;
+    }
+
+    // The sealed chunks, to share in O(1); rolls after them are not included.
+    const shared_ptr<const HistoryChunk>& sealedChunks() const { return sealed; }
+
+    // Every roll so far as a shareable chain: the sealed chunks plus, when
+    // there is a tail, a copy of it in one more chunk.
+    shared_ptr<const HistoryChunk> freeze() const {
+        return tail.empty() ? sealed : fillChunk(make_shared<HistoryChunk>());
+    }
+
+    // Becomes the rolls of a chain from sealedChunks() or freeze(). The
+    // chunks are linked in, not copied; a frozen tail becomes the tail.
+    void rebind(const shared_ptr<const HistoryChunk>& chain) {
+        shared_ptr<const HistoryChunk> last = chain;  // chain may be this history's own
+        clear();
+        if (!last) return;
+        bits = last->bits;
+        size_t perChunk = chunkRolls();
+        bool full = last->rolls == (last->index + 1) * perChunk;
+        if (!full) {
+            size_t tailRolls = last->rolls - last->index * perChunk;
+            tail.assign(last->words.begin(), last->words.begin() + (tailRolls + rollsPerWord() - 1) / rollsPerWord());
+        }
+        sealed = full ? last : last->previous;
+        chunks.resize(full ? last->index + 1 : last->index);
+        const HistoryChunk* at = sealed.get();
+        for (size_t i = chunks.size(); i-- > 0; at = at->previous.get()) chunks[i] = at;
+        count = last->rolls;
+        sealedCount = chunks.size() * perChunk;
+        faceCounts.assign(last->faces.begin(), last->faces.end());
+        while (!faceCounts.empty() && faceCounts.back() == 0) faceCounts.pop_back();
+    }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    unsigned bitsPerRoll() const { return bits; }
+    const vector<uint64_t>& getFaceCounts() const { return faceCounts; }
+    uint64_t faceCount(int face) const {
+        return face >= 0 && static_cast<size_t>(face) < faceCounts.size() ? faceCounts[face] : 0;
+    }
+
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, count); }
+};
+
+struct RollAggregates {
+    uint64_t count = 0;
+    int64_t sum = 0;
+    int best = 0;
+    int worst = 0;
+    uint64_t sumSquares = 0;
+};
+
+// Aggregates of a whole history, from its face counts alone.
+RollAggregates aggregatesOf(const RollHistory& history) {
+    RollAggregates stats;
+    const vector<uint64_t>& faces = history.getFaceCounts();
+    for (size_t face = 1; face < faces.size(); ++face) {
+        if (faces[face] == 0) continue;
+        if (stats.count == 0) stats.worst = static_cast<int>(face);
+        stats.best = static_cast<int>(face);
+        stats.count += faces[face];
+        stats.sum += static_cast<int64_t>(face * faces[face]);
+        stats.sumSquares += face * face * faces[face];
+    }
+    return stats;
+}
+
+// A player's rolls at one point of a game, as a timeline keeps them: the
+// history chunks, shared with the player rather than copied, and the
+// aggregates over every roll, including any made after those chunks.
+struct RollSnapshot {
+    shared_ptr<const HistoryChunk> chunks;
+    RollAggregates stats;
 };
 
 class Player {
 private:
     string name;
     int score;
-    vector<int> diceHistory;
+    RollHistory diceHistory;
     int wins;
     int bestRoll;
     double averageRoll;
 
+    // Running aggregates over diceHistory so every stat is O(1).
+    uint64_t rollCount;
+    int64_t rollSum;
+    int worstRoll;
+    uint64_t rollSumSquares;  // kept exact so spread comparisons never round
+
 public:
-    Player(const string& playerName) : name(playerName), score(0), wins(0), bestRoll(0), averageRoll(0.0) {}
+    Player(const string& playerName)
+        : name(playerName), score(0), wins(0), bestRoll(0), averageRoll(0.0),
+          rollCount(0), rollSum(0), worstRoll(0), rollSumSquares(0) {}
 
-    string getName() const { return name; }
+    const string& getName() const { return name; }
     int getScore() const { return score; }
-    const vector<int>& getDiceHistory() const { return diceHistory; }
+    const RollHistory& getDiceHistory() const { return diceHistory; }
     int getWins() const { return wins; }
     int getBestRoll() const { return bestRoll; }
+    int getWorstRoll() const { return worstRoll; }
     double getAverageRoll() const { return averageRoll; }
+    uint64_t getRollCount() const { return rollCount; }
+    int64_t getRollSum() const { return rollSum; }
+    uint64_t getRollSumSquares() const { return rollSumSquares; }
+
+    // Sum of squared deviations from the mean roll, from the exact sums.
+    double getRollDeviation() const {
+        return rollCount > 0 ? double(rollSumSquares) - double(rollSum) * double(rollSum) / rollCount : 0.0;
+    }
+    double getRollVariance() const { return rollCount > 0 ? getRollDeviation() / rollCount : 0.0; }
+
+    // Whether this player's rolls spread less around their mean than the
+    // other's. Compares n2 * (n1 * sq1 - sum1^2) with n1 * (n2 * sq2 - sum2^2)
+    // in exact integers, so equal spreads always compare equal.
+    bool steadierThan(const Player& other) const {
+        uint64_t high, low, otherHigh, otherLow;
+        spreadTimes(other.rollCount, high, low);
+        other.spreadTimes(rollCount, otherHigh, otherLow);
+        return high < otherHigh || (high == otherHigh && low < otherLow);
+    }
+
+    RollAggregates getAggregates() const {
+        RollAggregates stats;
+        stats.count = rollCount;
+        stats.sum = rollSum;
+        stats.best = bestRoll;
+        stats.worst = worstRoll;
+        stats.sumSquares = rollSumSquares;
+        return stats;
+    }
+
+    // Restores saved state without replaying the history roll by roll.
+    void restore(int savedScore, int savedWins, RollHistory&& history) {
+        score = savedScore;
+        wins = savedWins;
+        diceHistory = move(history);
+        setAggregates(aggregatesOf(diceHistory));
+    }
+
+    // The rolls so far in O(1): only the sealed chunks are referenced, so
+    // the rolls after them have to come from elsewhere on restore. With
+    // complete set the unsealed tail is copied into the snapshot as well.
+    RollSnapshot snapshotRolls(bool complete = false) const {
+        return {complete ? diceHistory.freeze() : diceHistory.sealedChunks(), getAggregates()};
+    }
+
+    // Puts the rolls back as they were at some point: chunks from a
+    // snapshot are linked back in, only the tail rolls made after them are
+    // appended, and stats are the aggregates at that point.
+    void restoreRolls(const shared_ptr<const HistoryChunk>& chunks, const int* tail, size_t tailCount,
+                      const RollAggregates& stats) {
+        diceHistory.rebind(chunks);
+        for (size_t i = 0; i < tailCount; ++i) diceHistory.push_back(tail[i]);
+        setAggregates(stats);
+    }
 
     void addToScore(int points) {
         score += points;
-        updateStats();
     }
 
-    void addToHistory(int diceValue) {
-        diceHistory.push_back(diceValue);
-        updateStats();
+    bool addToHistory(int diceValue) {
+        if (!diceHistory.push_back(diceValue)) return false;
+        updateStats(diceValue);
+        return true;
     }
 
     void incrementWins() { wins++; }
 
+    // Sets score and wins directly, for states rebuilt from a timeline.
+    void setStanding(int savedScore, int savedWins) {
+        score = savedScore;
+        wins = savedWins;
+    }
+
+    void reserveHistory(size_t rolls) { diceHistory.reserve(rolls); }
+
     void reset() {
         score = 0;
         diceHistory.clear();
         bestRoll = 0;
         averageRoll = 0.0;
+        rollCount = 0;
+        rollSum = 0;
+        worstRoll = 0;
+        rollSumSquares = 0;
     }
 
 private:
-    void updateStats() {
-        if (diceHistory.empty()) return;
-        
-        bestRoll = *max_element(diceHistory.begin(), diceHistory.end());
-        averageRoll = accumulate(diceHistory.begin(), diceHistory.end(), 0.0) / diceHistory.size();
+    void setAggregates(const RollAggregates& stats) {
+        rollCount = stats.count;
+        rollSum = stats.sum;
+        bestRoll = stats.best;
+        worstRoll = stats.worst;
+        rollSumSquares = stats.sumSquares;
+        averageRoll = rollCount > 0 ? double(rollSum) / rollCount : 0.0;
     }
-};
 
-class DiceGame {
-private:
-    vector<Player> players;
-    int rounds;
-    int currentRound;
-    int diceSides;
-    bool gameSaved;
-    mt19937 rng;
-
-    int rollDiceWithAnimation() {
-        cout << "\nRolling dice";
-        for (int i = 0; i < 3; ++i) {
-            cout << ".";
-            cout.flush();
-            this_thread::sleep_for(chrono::milliseconds(300));
+    void updateStats(int diceValue) {
+        rollCount++;
+        rollSum += diceValue;
+        if (rollCount == 1) {
+            bestRoll = worstRoll = diceValue;
+        } else {
+            bestRoll = max(bestRoll, diceValue);
+            worstRoll = min(worstRoll, diceValue);
         }
-        
-        uniform_int_distribution<int> dist(1, diceSides);
-        int result = dist(rng);
-        
-        cout << "\n";
-        displayDiceArt(result);
-        this_thread::sleep_for(chrono::milliseconds(800));
-        return result;
+        averageRoll = double(rollSum) / rollCount;
+        rollSumSquares += uint64_t(diceValue) * diceValue;
     }
 
-    void displayDiceArt(int value) {
-        if (value >= 1 && value <= 6) {
-            cout << DICE_ART[value] << "\n";
-        } else {
-            cout << "┌───────┐\n";
-            cout << "│ " << setw(2) << value << "   │\n";
-            cout << "└───────┘\n";
-        }
+    // (n * sumSquares - sum^2) * scale as a 128-bit high/low pair. Rolls are
+    // non-negative and fit a byte, so the high word cannot overflow for
+    // any history that fits in memory.
+    void spreadTimes(uint64_t scale, uint64_t& high, uint64_t& low) const {
+        uint64_t spreadHigh, spreadLow, squareHigh, squareLow;
+        uint64_t sum = static_cast<uint64_t>(rollSum);
+        multiply64(rollCount, rollSumSquares, spreadHigh, spreadLow);
+        multiply64(sum, sum, squareHigh, squareLow);
+        spreadHigh -= squareHigh + (spreadLow < squareLow);
+        spreadLow -= squareLow;
+
+        uint64_t carry;
+        multiply64(spreadLow, scale, carry, low);
+        high = spreadHigh * scale + carry;
     }
+};
 
-    void displayHeader(const string& title = "DICE GAME SIMULATOR") {
-        system("cls||clear");
-        cout << BOLD << CYAN << "============================================\n";
-        cout << "          " << UNDERLINE << title << RESET << BOLD << CYAN << "          \n";
-        cout << "============================================\n" << RESET;
-        
-        if (rounds > 0) {
-            cout << BOLD << "Round: " << currentRound << "/" << rounds;
-            cout << " | Dice: " << diceSides << "-sided";
-            cout << " | Players: " << players.size() << "\n\n" << RESET;
+inline int popCount64(uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(x);
+#else
+    int count = 0;
+    for (; x; x &= x - 1) count++;
+    return count;
+#endif
+}
+
+inline int countTrailingZeros64(uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(x);
+#else
+    int count = 0;
+    while (!(x & 1)) {
+        x >>= 1;
+        count++;
+    }
+    return count;
+#endif
+}
+
+// Index of the highest set bit; x must be non-zero.
+inline int highestBit64(uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return 63 - __builtin_clzll(x);
+#else
+    int bit = 0;
+    while (x >>= 1) bit++;
+    return bit;
+#endif
+}
+
+const uint64_t NIBBLE_LOW_BITS = 0x1111111111111111ULL;
+
+// One bit (the lowest of each nibble) set for every nibble of x that is zero.
+inline uint64_t zeroNibbles(uint64_t x) {
+    x |= x >> 2;
+    x |= x >> 1;
+    return ~x & NIBBLE_LOW_BITS;
+}
+
+// Regularized upper incomplete gamma Q(a, x), via the series for small x
+// and a continued fraction otherwise.
+double upperIncompleteGamma(double a, double x) {
+    if (x <= 0.0) return 1.0;
+    double logPrefix = -x + a * log(x) - lgamma(a);
+    if (x < a + 1.0) {
+        double term = 1.0 / a, sum = term;
+        for (int n = 1; n < 1000 && fabs(term) > fabs(sum) * 1e-15; ++n) {
+            term *= x / (a + n);
+            sum += term;
         }
+        return max(0.0, 1.0 - sum * exp(logPrefix));
     }
+    const double tiny = 1e-300;
+    double b = x + 1.0 - a, c = 1.0 / tiny, d = 1.0 / b, h = d;
+    for (int i = 1; i < 1000; ++i) {
+        double an = -i * (i - a);
+        b += 2.0;
+        d = an * d + b;
+        if (fabs(d) < tiny) d = tiny;
+        c = b + an / c;
+        if (fabs(c) < tiny) c = tiny;
+        d = 1.0 / d;
+        double delta = d * c;
+        h *= delta;
+        if (fabs(delta - 1.0) < 1e-15) break;
+    }
+    return exp(logPrefix) * h;
+}
 
-    void displayScores(bool showDetails = false) {
-        cout << BOLD << YELLOW << "\nCurrent Standings:\n" << RESET;
-        cout << "┌───────────────┬────────┬────────┬────────┐\n";
-        cout << "│ Player        │ Score  │ Wins   │ Best   │\n";
-        cout << "├───────────────┼────────┼────────┼────────┤\n";
-        
-        for (const auto& player : players) {
-            cout << "│ " << setw(13) << left << player.getName() << " │ "
-                 << setw(6) << right << player.getScore() << " │ "
-                 << setw(6) << right << player.getWins() << " │ "
-                 << setw(6) << right << player.getBestRoll() << " │\n";
+double chiSquarePValue(double statistic, int degreesOfFreedom) {
+    if (degreesOfFreedom <= 0) return 1.0;
+    return upperIncompleteGamma(degreesOfFreedom / 2.0, statistic / 2.0);
+}
+
+struct RollStatistics {
+    uint64_t count = 0;
+    uint64_t faces[256] = {};
+    double mean = 0.0;
+    double variance = 0.0;
+    int minRoll = 0;
+    int maxRoll = 0;
+    int mode = 0;
+    uint64_t longestStreak = 0;
+    int streakFace = 0;
+    double chiSquare = 0.0;
+    double pValue = 1.0;
+
+    // Derives everything except the streak from the histogram.
+    void finish(int sides) {
+        count = 0;
+        double sum = 0.0, sumSq = 0.0;
+        minRoll = maxRoll = mode = 0;
+        for (int face = 0; face < 256; ++face) {
+            if (faces[face] == 0) continue;
+            if (count == 0) minRoll = face;
+            maxRoll = face;
+            if (faces[face] > faces[mode]) mode = face;
+            count += faces[face];
+            sum += double(face) * faces[face];
+            sumSq += double(face) * face * faces[face];
         }
-        cout << "└───────────────┴────────┴────────┴────────┘\n";
-        
-        if (showDetails) {
-            cout << "\n" << BOLD << "Roll History:\n" << RESET;
-            for (const auto& player : players) {
-                cout << player.getName() << ": ";
-                for (int roll : player.getDiceHistory()) {
-                    cout << roll << " ";
-                }
-                cout << "(Avg: " << fixed << setprecision(1) << player.getAverageRoll() << ")\n";
+        mean = count > 0 ? sum / count : 0.0;
+        variance = count > 0 ? max(0.0, sumSq / count - mean * mean) : 0.0;
+
+        chiSquare = 0.0;
+        if (count > 0 && sides > 1) {
+            double expected = double(count) / sides;
+            for (int face = 1; face <= sides; ++face) {
+                double diff = double(faces[face]) - expected;
+                chiSquare += diff * diff / expected;
             }
         }
+        pValue = chiSquarePValue(chiSquare, sides - 1);
     }
 
-    void displayRoundResults(const vector<pair<string, int>>& roundResults) {
-        cout << BOLD << MAGENTA << "\nRound " << currentRound << " Results:\n" << RESET;
-        cout << "┌───────────────┬───────────────┐\n";
-        cout << "│ Player        │ Roll          │\n";
-        cout << "├───────────────┼───────────────┤\n";
-        
-        for (const auto& result : roundResults) {
-            cout << "│ " << setw(13) << left << result.first << " │ "
-                 << setw(13) << left << result.second << " │\n";
+    void merge(const RollStatistics& other) {
+        for (int face = 0; face < 256; ++face) faces[face] += other.faces[face];
+        if (other.longestStreak > longestStreak) {
+            longestStreak = other.longestStreak;
+            streakFace = other.streakFace;
         }
-        cout << "└───────────────┴───────────────┘\n";
     }
+};
 
-    void announceRoundWinner(const string& winner, int points) {
-        cout << BOLD << GREEN << "\n🎉 " << winner << " wins this round with " << points << "! 🎉\n" << RESET;
-        
-        auto it = find_if(players.begin(), players.end(),
-            [&winner](const Player& p) { return p.getName() == winner; });
-        if (it != players.end()) {
-            it->incrementWins();
+// Counts faces of a raw roll buffer into four interleaved sub-histograms so
+// back-to-back equal rolls do not serialize on the same counter.
+void histogramBytes(const uint8_t* rolls, size_t count, uint64_t* faces) {
+    uint32_t sub[4][256] = {};
+    size_t i = 0;
+    while (i < count) {
+        size_t stop = min(count, i + (size_t(1) << 30));
+        for (; i + 4 <= stop; i += 4) {
+            sub[0][rolls[i]]++;
+            sub[1][rolls[i + 1]]++;
+            sub[2][rolls[i + 2]]++;
+            sub[3][rolls[i + 3]]++;
+        }
+        for (; i < stop; ++i) sub[0][rolls[i]]++;
+        for (int face = 0; face < 256; ++face) {
+            faces[face] += uint64_t(sub[0][face]) + sub[1][face] + sub[2][face] + sub[3][face];
+            sub[0][face] = sub[1][face] = sub[2][face] = sub[3][face] = 0;
         }
-        
-        this_thread::sleep_for(chrono::seconds(2));
     }
+}
 
-    void saveGame() {
-    ofstream outFile("dice_game_save.dat", ios::binary);
-    if (outFile) {
-        outFile.write(reinterpret_cast<const char*>(&rounds), sizeof(rounds));
-        outFile.write(reinterpret_cast<const char*>(&currentRound), sizeof(currentRound));
-        outFile.write(reinterpret_cast<const char*>(&diceSides), sizeof(diceSides));
-        
-        size_t numPlayers = players.size();
-        outFile.write(reinterpret_cast<const char*>(&numPlayers), sizeof(numPlayers));
-        
-        for (const auto& player : players) {
-            size_t nameLength = player.getName().size();
-            outFile.write(reinterpret_cast<const char*>(&nameLength), sizeof(nameLength));
-            outFile.write(player.getName().c_str(), nameLength);
-
-            int score = player.getScore();
-            int wins = player.getWins();
-            outFile.write(reinterpret_cast<const char*>(&score), sizeof(score));
-            outFile.write(reinterpret_cast<const char*>(&wins), sizeof(wins));
-            
-            const vector<int>& history = player.getDiceHistory();
-            size_t historySize = history.size();
-            outFile.write(reinterpret_cast<const char*>(&historySize), sizeof(historySize));
-            for (int roll : history) {
-                outFile.write(reinterpret_cast<const char*>(&roll), sizeof(roll));
+// Single pass over a packed history. For nibble-packed data each 64-bit word
+// holds sixteen rolls: faces are counted with SWAR compare + popcount and
+// equal neighbours are found by comparing the word with itself shifted by
+// one roll, so the loop works a word at a time instead of a roll at a time.
+template <uint32_t FaceLimit>
+RollStatistics scanHistory(const RollHistory& history) {
+    RollStatistics stats;
+    const size_t count = history.size();
+    const size_t wordCount = history.wordCount();
+    uint64_t run = 0;  // equal neighbour pairs in the current streak
+    uint64_t lastPair = 0;
+    bool hasPair = false;
+
+    auto closeRun = [&](size_t endIndex) {
+        if (hasPair && run + 1 > stats.longestStreak) {
+            stats.longestStreak = run + 1;
+            stats.streakFace = history[endIndex];
+        }
+    };
+
+    if (history.bitsPerRoll() == 4) {
+        // A die with FaceLimit sides only needs its own faces counted; the
+        // full sixteen-face count is the fallback for anything else.
+        const uint32_t firstFace = FaceLimit < 15 ? 1 : 0;
+        uint64_t local[16] = {};
+        size_t w = 0;
+        history.forEachWordRun([&](const uint64_t* words, size_t runWords) {
+            for (size_t k = 0; k < runWords; ++k, ++w) {
+                uint64_t word = words[k];
+                for (uint32_t face = firstFace; face <= FaceLimit; ++face) {
+                    local[face] += popCount64(zeroNibbles(word ^ (NIBBLE_LOW_BITS * face)));
+                }
+
+                size_t base = w * 16;
+                size_t valid = min<size_t>(16, count - base);
+                uint64_t next = k + 1 < runWords ? words[k + 1] : w + 1 < wordCount ? history.word(w + 1) : 0;
+                uint64_t shifted = (word >> 4) | (next << 60);
+                size_t pairs = base + valid < count ? valid : valid - 1;
+                uint64_t validMask = pairs >= 16 ? ~uint64_t(0) : (uint64_t(1) << (4 * pairs)) - 1;
+                uint64_t equal = zeroNibbles(word ^ shifted) & validMask;
+                while (equal) {
+                    uint64_t pair = base + countTrailingZeros64(equal) / 4;
+                    if (hasPair && pair == lastPair + 1) {
+                        run++;
+                    } else {
+                        closeRun(lastPair);
+                        run = 1;
+                        hasPair = true;
+                    }
+                    lastPair = pair;
+                    equal &= equal - 1;
+                }
             }
+        });
+        if (FaceLimit < 15) {
+            if (accumulate(local, local + 16, uint64_t(0)) != count) return scanHistory<15>(history);
+        } else {
+            // Padding nibbles in the last word read as face 0.
+            local[0] -= wordCount * 16 - count;
         }
-        
-        gameSaved = true;
-        cout << BOLD << GREEN << "\nGame saved successfully!\n" << RESET;
+        for (int face = 0; face < 16; ++face) stats.faces[face] = local[face];
     } else {
-        cout << BOLD << RED << "\nError saving game!\n" << RESET;
+        for (size_t i = 0; i < count; ++i) {
+            int roll = history[i];
+            stats.faces[roll]++;
+            if (i > 0 && roll == history[i - 1]) {
+                if (hasPair && i - 1 == lastPair + 1) {
+                    run++;
+                } else {
+                    closeRun(lastPair);
+                    run = 1;
+                    hasPair = true;
+                }
+                lastPair = i - 1;
+            }
+        }
+    }
+    closeRun(lastPair);
+    if (stats.longestStreak == 0 && count > 0) {
+        stats.longestStreak = 1;
+        stats.streakFace = history[0];
     }
-    this_thread::sleep_for(chrono::seconds(1));
+    return stats;
 }
 
-bool loadGame() {
-    ifstream inFile("dice_game_save.dat", ios::binary);
-    if (inFile) {
-        inFile.read(reinterpret_cast<char*>(&rounds), sizeof(rounds));
-        inFile.read(reinterpret_cast<char*>(&currentRound), sizeof(currentRound));
-        inFile.read(reinterpret_cast<char*>(&diceSides), sizeof(diceSides));
-    
-        size_t numPlayers;
-        inFile.read(reinterpret_cast<char*>(&numPlayers), sizeof(numPlayers));
-        players.clear();
-        
-        for (size_t i = 0; i < numPlayers; ++i) {
-            size_t nameLength;
-            inFile.read(reinterpret_cast<char*>(&nameLength), sizeof(nameLength));
-            string name(nameLength, '\0');
-            inFile.read(&name[0], nameLength);
-            
-            Player player(name);
-        
-            int score, wins;
-            inFile.read(reinterpret_cast<char*>(&score), sizeof(score));
-            inFile.read(reinterpret_cast<char*>(&wins), sizeof(wins));
-            
-            size_t historySize;
-            inFile.read(reinterpret_cast<char*>(&historySize), sizeof(historySize));
-            for (size_t j = 0; j < historySize; ++j) {
-                int roll;
-                inFile.read(reinterpret_cast<char*>(&roll), sizeof(roll));
-                player.addToHistory(roll);
-                player.addToScore(roll);
-            }
-            
-            for (int w = 0; w < wins; ++w) {
-                player.incrementWins();
-            }
-            
-            players.push_back(player);
-        }
-        
-        gameSaved = false;
-        cout << BOLD << GREEN << "\nGame loaded successfully!\n" << RESET;
-        this_thread::sleep_for(chrono::seconds(1));
+const int MIN_DICE_SIDES = 4;
+const int MAX_DICE_SIDES = 12;
+
+// Kernels specialised for one die size. The rejection threshold and every
+// per-face loop bound are compile-time constants, so the roll and counting
+// loops carry no branches on the number of sides.
+template <uint32_t Sides>
+struct Die {
+    static_assert(Sides >= MIN_DICE_SIDES && Sides <= MAX_DICE_SIDES, "dice have 4 to 12 sides");
+    using Faces = integral_constant<uint32_t, Sides>;
+    static constexpr uint32_t REJECT_BELOW = rejectionThreshold(Sides);
+
+    static int roll(DiceRng& rng) {
+        return rng.withEngine([](auto& generator) { return rollWith(generator, Faces()); });
+    }
+
+    static void rollMany(DiceRng& rng, uint8_t* out, size_t count) {
+        rng.withEngine([&](auto& generator) { rollManyWith(generator, out, count, Faces()); });
+    }
+
+    static RollStatistics analyze(const RollHistory& history) {
+        RollStatistics stats = scanHistory<Sides>(history);
+        stats.finish(Sides);
+        return stats;
+    }
+};
+
+struct DieKernels {
+    int sides;
+    int (*roll)(DiceRng&);
+    void (*rollMany)(DiceRng&, uint8_t*, size_t);
+    RollStatistics (*analyze)(const RollHistory&);
+};
+
+template <uint32_t Sides>
+constexpr DieKernels makeDieKernels() {
+    return {static_cast<int>(Sides), &Die<Sides>::roll, &Die<Sides>::rollMany, &Die<Sides>::analyze};
+}
+
+const DieKernels DIE_KERNELS[] = {
+    makeDieKernels<4>(), makeDieKernels<5>(), makeDieKernels<6>(), makeDieKernels<7>(), makeDieKernels<8>(),
+    makeDieKernels<9>(), makeDieKernels<10>(), makeDieKernels<11>(), makeDieKernels<12>()
+};
+
+// The one place a runtime side count picks its specialisation; null for a
+// die the game does not support.
+const DieKernels* dieKernels(int sides) {
+    if (sides < MIN_DICE_SIDES || sides > MAX_DICE_SIDES) return nullptr;
+    return &DIE_KERNELS[sides - MIN_DICE_SIDES];
+}
+
+RollStatistics analyzeHistory(const RollHistory& history, int sides) {
+    if (const DieKernels* die = dieKernels(sides)) return die->analyze(history);
+    RollStatistics stats = scanHistory<15>(history);
+    stats.finish(sides);
+    return stats;
+}
+
+struct GameAnalysis {
+    vector<RollStatistics> perPlayer;
+    RollStatistics combined;
+    double seconds = 0.0;
+
+    double rollsPerSecond() const { return seconds > 0 ? combined.count / seconds : 0.0; }
+};
+
+// Runs analyzeHistory for every player, spreading large games over threads.
+GameAnalysis analyzePlayers(const vector<Player>& players, int sides) {
+    const uint64_t PARALLEL_THRESHOLD = uint64_t(1) << 20;
+    auto start = chrono::steady_clock::now();
+    GameAnalysis analysis;
+    analysis.perPlayer.resize(players.size());
+
+    uint64_t totalRolls = 0;
+    for (const auto& player : players) totalRolls += player.getRollCount();
+    unsigned workers = totalRolls < PARALLEL_THRESHOLD ? 1 :
+        static_cast<unsigned>(min<size_t>(max(1u, thread::hardware_concurrency()), players.size()));
+
+    atomic<size_t> nextPlayer(0);
+    auto worker = [&]() {
+        for (size_t i = nextPlayer++; i < players.size(); i = nextPlayer++) {
+            analysis.perPlayer[i] = analyzeHistory(players[i].getDiceHistory(), sides);
+        }
+    };
+    vector<thread> pool;
+    for (unsigned w = 1; w < workers; ++w) pool.emplace_back(worker);
+    worker();
+    for (auto& t : pool) t.join();
+
+    for (const auto& stats : analysis.perPlayer) analysis.combined.merge(stats);
+    analysis.combined.finish(sides);
+    analysis.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return analysis;
+}
+
+// Seat order for the final standings, highest score first, except that a
+// declared winner, such as the last one standing in an Elimination game,
+// leads whatever the totals. Sorting indices leaves the players, and their
+// roll histories, where they are.
+vector<size_t> rankPlayers(const vector<Player>& players, int winner = -1) {
+    vector<size_t> order(players.size());
+    iota(order.begin(), order.end(), size_t(0));
+    stable_sort(order.begin(), order.end(),
+        [&](size_t a, size_t b) {
+            return players[a].getScore() > players[b].getScore();
+        });
+    if (winner >= 0) {
+        auto at = find(order.begin(), order.end(), static_cast<size_t>(winner));
+        rotate(order.begin(), at, at + 1);
+    }
+    return order;
+}
+
+// Exact outcome probabilities. A round is won outright by the single highest
+// roll; a game is won by the single highest total. Per-round odds follow
+// from the order statistics of one die, game odds from the distribution of
+// a player's running total, convolved one die at a time.
+const int ODDS_TABLE_PLAYERS = 8;        // round odds precomputed for 2..8 players
+const int ODDS_TABLE_GAME_PLAYERS = 4;   // classic game odds for 2..4 players,
+const int ODDS_TABLE_ROUNDS = 20;        // 1..20 rounds: every interactive setup
+
+struct RoundOdds {
+    double win = 0.0;  // one given player rolls the highest value outright
+    double tie = 0.0;  // the highest roll is shared, so nobody wins the round
+};
+
+struct GameOdds {
+    double win = 0.0;  // per seat; seats are symmetric
+    double tie = 0.0;
+    double expectedRounds = 0.0;
+    vector<double> lengths;  // lengths[r]: chance the game lasts exactly r rounds
+};
+
+constexpr uint64_t integerPower(uint64_t base, int exponent) {
+    uint64_t result = 1;
+    for (int i = 0; i < exponent; ++i) result *= base;
+    return result;
+}
+
+constexpr double realPower(double base, int exponent) {
+    double result = 1.0;
+    for (int i = 0; i < exponent; ++i) result *= base;
+    return result;
+}
+
+// Out of sides^players equally likely rounds, how many a given player wins
+// outright: they roll v and everyone else rolls below it.
+struct RoundOddsTable {
+    uint64_t outcomes[ODDS_TABLE_PLAYERS + 1][MAX_DICE_SIDES + 1] = {};
+    uint64_t wins[ODDS_TABLE_PLAYERS + 1][MAX_DICE_SIDES + 1] = {};
+};
+
+constexpr RoundOddsTable buildRoundOddsTable() {
+    RoundOddsTable table;
+    for (int players = 2; players <= ODDS_TABLE_PLAYERS; ++players) {
+        for (int sides = MIN_DICE_SIDES; sides <= MAX_DICE_SIDES; ++sides) {
+            table.outcomes[players][sides] = integerPower(sides, players);
+            for (int v = 1; v <= sides; ++v) table.wins[players][sides] += integerPower(v - 1, players - 1);
+        }
+    }
+    return table;
+}
+
+constexpr RoundOddsTable ROUND_ODDS_TABLE = buildRoundOddsTable();
+
+struct ClassicOddsTable {
+    double win[ODDS_TABLE_GAME_PLAYERS + 1][MAX_DICE_SIDES + 1][ODDS_TABLE_ROUNDS + 1] = {};
+};
+
+constexpr ClassicOddsTable buildClassicOddsTable() {
+    ClassicOddsTable table;
+    const int MAX_TOTAL = MAX_DICE_SIDES * ODDS_TABLE_ROUNDS;
+    for (int sides = MIN_DICE_SIDES; sides <= MAX_DICE_SIDES; ++sides) {
+        double totals[MAX_TOTAL + 1] = {1.0};
+        for (int rounds = 1; rounds <= ODDS_TABLE_ROUNDS; ++rounds) {
+            double next[MAX_TOTAL + 1] = {};
+            for (int t = 0; t <= (rounds - 1) * sides; ++t) {
+                for (int face = 1; face <= sides; ++face) next[t + face] += totals[t] / sides;
+            }
+            for (int t = 0; t <= MAX_TOTAL; ++t) totals[t] = next[t];
+            for (int players = 2; players <= ODDS_TABLE_GAME_PLAYERS; ++players) {
+                double below = 0.0, win = 0.0;
+                for (int t = 0; t <= rounds * sides; ++t) {
+                    win += totals[t] * realPower(below, players - 1);
+                    below += totals[t];
+                }
+                table.win[players][sides][rounds] = win;
+            }
+        }
+    }
+    return table;
+}
+
+constexpr ClassicOddsTable CLASSIC_ODDS_TABLE = buildClassicOddsTable();
+
+// Distribution of the total of `dice` dice, by total, using a sliding
+// window over the previous distribution so each die costs O(totals).
+vector<double> diceTotalDistribution(int dice, int sides) {
+    vector<double> totals(1, 1.0);
+    for (int d = 0; d < dice; ++d) {
+        vector<double> next(totals.size() + sides, 0.0);
+        double window = 0.0;
+        for (size_t t = 1; t < next.size(); ++t) {
+            if (t - 1 < totals.size()) window += totals[t - 1];
+            if (t > static_cast<size_t>(sides) && t - sides - 1 < totals.size()) window -= totals[t - sides - 1];
+            next[t] = window / sides;
+        }
+        totals.swap(next);
+    }
+    return totals;
+}
+
+// Computes and caches whole-game odds. The work for a configuration is done
+// once per process; configurations too large to solve quickly report false.
+class OddsEngine {
+private:
+    static const long long MAX_CLASSIC_WORK = 100000000;  // rounds^2 * sides
+    static const int MAX_TARGET = 10000;
+    static constexpr double NEGLIGIBLE = 1e-15;
+
+    mutex lock;
+    map<array<long long, 4>, GameOdds> cache;
+
+    bool cached(const array<long long, 4>& key, GameOdds& odds, const function<bool(GameOdds&)>& compute) {
+        {
+            lock_guard<mutex> guard(lock);
+            auto found = cache.find(key);
+            if (found != cache.end()) {
+                odds = found->second;
+                return true;
+            }
+        }
+        GameOdds computed;
+        if (!compute(computed)) return false;
+        lock_guard<mutex> guard(lock);
+        odds = cache.emplace(key, move(computed)).first->second;
         return true;
-    } else {
-        cout << BOLD << RED << "\nNo saved game found!\n" << RESET;
-        this_thread::sleep_for(chrono::seconds(1));
+    }
+
+    static void finishLengths(GameOdds& odds) {
+        odds.expectedRounds = 0.0;
+        for (size_t r = 0; r < odds.lengths.size(); ++r) odds.expectedRounds += r * odds.lengths[r];
+    }
+
+public:
+    static OddsEngine& instance() {
+        static OddsEngine engine;
+        return engine;
+    }
+
+    static bool supports(int players, int sides) {
+        return players >= 2 && sides >= MIN_DICE_SIDES && sides <= MAX_DICE_SIDES;
+    }
+
+    static RoundOdds round(int players, int sides) {
+        RoundOdds odds;
+        if (!supports(players, sides)) return odds;
+        if (players <= ODDS_TABLE_PLAYERS) {
+            odds.win = double(ROUND_ODDS_TABLE.wins[players][sides]) / ROUND_ODDS_TABLE.outcomes[players][sides];
+        } else {
+            for (int v = 1; v <= sides; ++v) odds.win += pow(double(v - 1) / sides, players - 1) / sides;
+        }
+        odds.tie = max(0.0, 1.0 - players * odds.win);
+        return odds;
+    }
+
+    // Fixed number of rounds; highest total wins.
+    bool classic(int players, int sides, int rounds, GameOdds& odds) {
+        if (!supports(players, sides) || rounds < 1) return false;
+        if (players <= ODDS_TABLE_GAME_PLAYERS && rounds <= ODDS_TABLE_ROUNDS) {
+            odds = GameOdds();
+            odds.win = CLASSIC_ODDS_TABLE.win[players][sides][rounds];
+        } else if (!cached({1, players, sides, rounds}, odds, [&](GameOdds& computed) {
+            if (static_cast<long long>(rounds) * rounds * sides > MAX_CLASSIC_WORK) return false;
+            vector<double> totals = diceTotalDistribution(rounds, sides);
+            double below = 0.0;
+            for (double p : totals) {
+                computed.win += p * pow(below, players - 1);
+                below += p;
+            }
+            return true;
+        })) {
+            return false;
+        }
+        odds.tie = max(0.0, 1.0 - players * odds.win);
+        odds.expectedRounds = rounds;
+        odds.lengths.clear();
+        return true;
+    }
+
+    // Everyone rolls each round until someone's total reaches the target;
+    // the highest total at that point wins. Each player's total is tracked
+    // only while it is still below the target, which is exactly the event
+    // that the game has not ended yet.
+    bool target(int players, int sides, int targetScore, GameOdds& odds) {
+        if (!supports(players, sides) || targetScore < 1 || targetScore > MAX_TARGET) return false;
+        return cached({2, players, sides, targetScore}, odds, [&](GameOdds& computed) {
+            vector<double> below(targetScore, 0.0), after(targetScore + sides, 0.0);
+            below[0] = 1.0;
+            double running = 1.0;
+            computed.lengths.push_back(0.0);
+            while (running > NEGLIGIBLE) {
+                double window = 0.0, cumulative = 0.0, stillBelow = 0.0;
+                for (int x = 0; x < targetScore + sides; ++x) {
+                    if (x >= 1 && x - 1 < targetScore) window += below[x - 1];
+                    if (x > sides && x - sides - 1 < targetScore) window -= below[x - sides - 1];
+                    after[x] = window / sides;
+                    if (x >= targetScore) computed.win += after[x] * pow(cumulative, players - 1);
+                    else stillBelow += after[x];
+                    cumulative += after[x];
+                }
+                copy(after.begin(), after.begin() + targetScore, below.begin());
+                double next = pow(stillBelow, players);
+                computed.lengths.push_back(running - next);
+                running = next;
+            }
+            computed.tie = max(0.0, 1.0 - players * computed.win);
+            finishLengths(computed);
+            return true;
+        });
+    }
+
+    // Each round the lowest roll(s) drop out unless everyone tied; the last
+    // player left wins. The number of players left is a Markov chain.
+    bool elimination(int players, int sides, GameOdds& odds) {
+        if (!supports(players, sides)) return false;
+        return cached({3, players, sides, 0}, odds, [&](GameOdds& computed) {
+            // drop[k][j]: with k players left, exactly j share the lowest roll
+            // and at least one player rolled higher.
+            vector<vector<double>> drop(players + 1, vector<double>(players + 1, 0.0));
+            for (int k = 2; k <= players; ++k) {
+                double choose = 1.0;
+                for (int j = 1; j < k; ++j) {
+                    choose = choose * (k - j + 1) / j;
+                    for (int v = 1; v < sides; ++v) {
+                        drop[k][j] += choose * pow(1.0 / sides, j) * pow(double(sides - v) / sides, k - j);
+                    }
+                }
+            }
+            vector<double> left(players + 1, 0.0), next(players + 1);
+            left[players] = 1.0;
+            double running = 1.0;
+            computed.lengths.push_back(0.0);
+            while (running > NEGLIGIBLE) {
+                fill(next.begin(), next.end(), 0.0);
+                for (int k = 2; k <= players; ++k) {
+                    double stay = left[k];
+                    for (int j = 1; j < k; ++j) {
+                        next[k - j] += left[k] * drop[k][j];
+                        stay -= left[k] * drop[k][j];
+                    }
+                    next[k] += stay;
+                }
+                computed.lengths.push_back(next[1]);
+                running -= next[1];
+                next[1] = 0.0;
+                left.swap(next);
+            }
+            computed.win = 1.0 / players;
+            finishLengths(computed);
+            return true;
+        });
+    }
+};
+
+bool parseNumber(const char* text, long long minValue, long long maxValue, long long& value) {
+    char* end = nullptr;
+    errno = 0;
+    long long parsed = strtoll(text, &end, 10);
+    if (errno != 0 || end == text || *end != '\0' || parsed < minValue || parsed > maxValue) return false;
+    value = parsed;
+    return true;
+}
+
+// The whole unsigned 64-bit range, for seeds.
+bool parseNumber(const char* text, uint64_t& value) {
+    if (!isdigit(static_cast<unsigned char>(*text))) return false;  // strtoull would wrap a leading '-'
+    char* end = nullptr;
+    errno = 0;
+    unsigned long long parsed = strtoull(text, &end, 10);
+    if (errno != 0 || *end != '\0') return false;
+    value = parsed;
+    return true;
+}
+
+enum class GameMode { Classic = 1, Target = 2, Elimination = 3 };
+
+const char* gameModeName(GameMode mode) {
+    switch (mode) {
+        case GameMode::Target: return "Target";
+        case GameMode::Elimination: return "Elimination";
+        default: return "Classic";
+    }
+}
+
+// Lower-case name used on the command line and in rule specs.
+string gameModeKey(GameMode mode) {
+    string key = gameModeName(mode);
+    key[0] = static_cast<char>(tolower(key[0]));
+    return key;
+}
+
+bool parseGameMode(const string& name, GameMode& mode) {
+    for (int id = 1; id <= static_cast<int>(GameMode::Elimination); ++id) {
+        if (name == gameModeKey(static_cast<GameMode>(id))) {
+            mode = static_cast<GameMode>(id);
+            return true;
+        }
+    }
+    return false;
+}
+
+struct RoundOutcome {
+    int winner;       // seat of the round winner, -1 on a tie
+    int winningRoll;
+};
+
+// A game variant as data: when the game ends and what a roll is worth.
+// Every seat scores its roll each round; the bonuses below add to that and
+// at their neutral values (multipliers 1, bonuses 0) scoring is plain.
+struct RuleSet {
+    GameMode mode = GameMode::Classic;
+    int rounds = 10;            // Classic: rounds in a game
+    int target = 100;           // Target: the game ends with the round a total reaches this
+    int maxRollMultiplier = 1;  // the die's top face scores this many times its value
+    int streakMultiplier = 1;   // a round winner who also took the previous round scores this many times
+    int doublesBonus = 0;       // to each of exactly two seats showing the same face
+    int triplesBonus = 0;       // to each of three or more seats showing the same face
+
+    bool plainScoring() const {
+        return maxRollMultiplier == 1 && streakMultiplier == 1 && doublesBonus == 0 && triplesBonus == 0;
+    }
+};
+
+// The bonuses the rules screen has always promised.
+RuleSet houseRules() {
+    RuleSet rules;
+    rules.maxRollMultiplier = 5;
+    rules.streakMultiplier = 2;
+    rules.doublesBonus = 2;
+    rules.triplesBonus = 5;
+    return rules;
+}
+
+struct RuleField {
+    const char* key;
+    int RuleSet::*field;
+    long long minValue, maxValue;
+};
+
+const RuleField RULE_FIELDS[] = {
+    {"rounds", &RuleSet::rounds, 1, 100000},
+    {"target", &RuleSet::target, 1, 1000000},
+    {"max-roll", &RuleSet::maxRollMultiplier, 1, 100},
+    {"streak", &RuleSet::streakMultiplier, 1, 100},
+    {"doubles", &RuleSet::doublesBonus, 0, 1000},
+    {"triples", &RuleSet::triplesBonus, 0, 1000},
+};
+
+// Applies a comma-separated rule spec left to right. "plain" and "house"
+// reset the bonuses to that preset; key=value items set mode= or any
+// RULE_FIELDS entry, e.g. "house,mode=target,target=200,streak=3".
+bool parseRuleSpec(const string& spec, RuleSet& rules) {
+    size_t begin = 0;
+    while (begin <= spec.size()) {
+        size_t end = min(spec.find(',', begin), spec.size());
+        string item = spec.substr(begin, end - begin);
+        begin = end + 1;
+
+        size_t equals = item.find('=');
+        if (equals == string::npos) {
+            RuleSet preset;
+            if (item == "house") preset = houseRules();
+            else if (item != "plain") return false;
+            preset.mode = rules.mode;
+            preset.rounds = rules.rounds;
+            preset.target = rules.target;
+            rules = preset;
+            continue;
+        }
+
+        string key = item.substr(0, equals), value = item.substr(equals + 1);
+        if (key == "mode") {
+            if (!parseGameMode(value, rules.mode)) return false;
+            continue;
+        }
+        const RuleField* field = nullptr;
+        for (const auto& candidate : RULE_FIELDS) {
+            if (key == candidate.key) field = &candidate;
+        }
+        long long number = 0;
+        if (!field || !parseNumber(value.c_str(), field->minValue, field->maxValue, number)) return false;
+        rules.*(field->field) = static_cast<int>(number);
+    }
+    return true;
+}
+
+// Spec that parseRuleSpec() turns back into the same rules.
+string formatRuleSpec(const RuleSet& rules) {
+    string spec = "mode=" + gameModeKey(rules.mode);
+    for (const auto& field : RULE_FIELDS) {
+        spec += string(",") + field.key + "=" + to_string(rules.*(field.field));
+    }
+    return spec;
+}
+
+// What the rules carry from one round to the next.
+struct RuleState {
+    vector<char> alive;   // seats still in an Elimination game
+    int aliveCount = 0;
+    int lastWinner = -1;  // seat that took the previous round, for streaks
+
+    void reset(size_t seats) {
+        alive.assign(seats, 1);
+        aliveCount = static_cast<int>(seats);
+        lastWinner = -1;
+    }
+};
+
+// A RuleSet compiled for one die into lookup tables: points per face, the
+// bonus by how many seats show the same face, and the extra multiple a
+// streak earns. Scoring a round is then the same few lookups per seat for
+// every variant, with no per-rule branches, and the interactive game,
+// journal replay, the simulator and what-if branches all score through it.
+class CompiledRules {
+private:
+    RuleSet rules;
+    array<int, MAX_DICE_SIDES + 1> facePoints;  // [0] stays 0: a seat that did not roll
+    array<int, 4> sharedBonus;                  // by seats showing a face, 3 or more share the last
+    array<int, 2> streakExtra;                  // extra multiples of a roll, without and with a streak
+    bool bonuses;                               // false: every bonus is 0
+
+public:
+    CompiledRules(const RuleSet& ruleSet = RuleSet(), int sides = 6) : rules(ruleSet) {
+        facePoints.fill(0);
+        for (int face = 1; face <= MAX_DICE_SIDES; ++face) {
+            facePoints[face] = face == sides ? face * rules.maxRollMultiplier : face;
+        }
+        sharedBonus = {0, 0, rules.doublesBonus, rules.triplesBonus};
+        streakExtra = {0, rules.streakMultiplier - 1};
+        bonuses = rules.doublesBonus || rules.triplesBonus || rules.streakMultiplier != 1;
+    }
+
+    const RuleSet& getRules() const { return rules; }
+
+    // Whether a round can change anything beyond each roll's own points.
+    // Bulk loops skip scoreRound() when it cannot, since only the
+    // interactive game and what-if branches track round wins.
+    bool scoresRounds() const { return !rules.plainScoring() || rules.mode == GameMode::Elimination; }
+
+    // Points a roll scores the moment it is made.
+    int rollPoints(int roll) const { return facePoints[roll]; }
+
+    // Scores a complete round. rolls holds one face per seat, 0 for a seat
+    // that is out; what each seat earns on top of rollPoints() goes to
+    // bonus, which rules without bonuses never write, so it must start
+    // zeroed. Knocks out the lowest roll in Elimination (unless every seat
+    // still in tied) and records the round winner for the next streak.
+    template <typename Roll>
+    RoundOutcome scoreRound(const Roll* rolls, size_t seats, RuleState& state, int* bonus) const {
+        int best = 0, bestCount = 0, lowest = MAX_DICE_SIDES + 1, winner = -1;
+        for (size_t i = 0; i < seats; ++i) {
+            int roll = rolls[i];
+            winner = roll > best ? static_cast<int>(i) : winner;
+            bestCount = roll > best ? 1 : bestCount + (roll == best);
+            best = max(best, roll);
+            lowest = min(lowest, roll > 0 ? roll : MAX_DICE_SIDES + 1);
+        }
+
+        RoundOutcome outcome{best > 0 && bestCount == 1 ? winner : -1, best};
+        if (bonuses) {
+            uint8_t shown[MAX_DICE_SIDES + 1] = {};
+            for (size_t i = 0; i < seats; ++i) shown[rolls[i]]++;
+            int streak = outcome.winner >= 0 && outcome.winner == state.lastWinner ? outcome.winner : -1;
+            for (size_t i = 0; i < seats; ++i) {
+                int roll = rolls[i];
+                bonus[i] = sharedBonus[min<int>(shown[roll], 3)] * (roll > 0) +
+                           facePoints[roll] * streakExtra[static_cast<int>(i) == streak];
+            }
+        }
+        if (rules.mode == GameMode::Elimination && lowest < best) {
+            char* alive = state.alive.data();
+            int knockedOut = 0;
+            for (size_t i = 0; i < seats; ++i) {
+                char out = rolls[i] == lowest;
+                alive[i] &= !out;
+                knockedOut += out;
+            }
+            state.aliveCount -= knockedOut;
+        }
+        state.lastWinner = outcome.winner;
+        return outcome;
+    }
+
+    // Whether a game is over after roundsPlayed rounds.
+    bool finished(int roundsPlayed, int topScore, const RuleState& state) const {
+        switch (rules.mode) {
+            case GameMode::Target: return topScore >= rules.target;
+            case GameMode::Elimination: return state.aliveCount <= 1;
+            default: return roundsPlayed >= rules.rounds;
+        }
+    }
+
+    // Winner of a finished game: the last seat standing in Elimination,
+    // otherwise the single highest score; -1 when the top score is shared.
+    template <typename ScoreOf>
+    int gameWinner(size_t seats, const RuleState& state, ScoreOf scoreOf) const {
+        if (rules.mode == GameMode::Elimination && state.aliveCount == 1) {
+            return static_cast<int>(find(state.alive.begin(), state.alive.end(), 1) - state.alive.begin());
+        }
+        int best = -1, bestScore = numeric_limits<int>::min();
+        for (size_t i = 0; i < seats; ++i) {
+            int score = scoreOf(i);
+            if (score > bestScore) {
+                bestScore = score;
+                best = static_cast<int>(i);
+            } else if (score == bestScore) {
+                best = -1;
+            }
+        }
+        return best;
+    }
+};
+
+const string SAVE_FILE = "dice_game_save.dat";
+const uint32_t SAVE_MAGIC = 0x56534744;  // "DGSV" little-endian
+const uint16_t SAVE_VERSION = 1;
+
+struct SavedGame {
+    RuleSet rules;            // plain scoring for legacy saves
+    RuleState state;
+    int currentRound = 0;
+    int diceSides = 6;
+    uint64_t generation = 0;  // journal generation this snapshot folds in
+    RngEngine engine = RngEngine::Mt19937;
+    vector<Player> players;
+};
+
+uint64_t fnv1a64(const uint8_t* data, size_t size, uint64_t hash = 0xcbf29ce484222325ULL) {
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= data[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+bool hostIsLittleEndian() {
+    const uint16_t probe = 1;
+    return *reinterpret_cast<const uint8_t*>(&probe) == 1;
+}
+
+class SaveWriter {
+private:
+    vector<uint8_t> buffer;
+
+public:
+    void putU8(uint8_t value) { buffer.push_back(value); }
+    void putU16(uint16_t value) { putLE(value, 2); }
+    void putU32(uint32_t value) { putLE(value, 4); }
+    void putU64(uint64_t value) { putLE(value, 8); }
+    void putI32(int32_t value) { putLE(static_cast<uint32_t>(value), 4); }
+    void putI64(int64_t value) { putLE(static_cast<uint64_t>(value), 8); }
+    void putF64(double value) {
+        uint64_t raw;
+        memcpy(&raw, &value, sizeof(raw));
+        putLE(raw, 8);
+    }
+    void putBytes(const void* data, size_t size) {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        buffer.insert(buffer.end(), bytes, bytes + size);
+    }
+    void putWords(const uint64_t* words, size_t count) {
+        if (hostIsLittleEndian()) {
+            putBytes(words, count * sizeof(uint64_t));
+        } else {
+            for (size_t i = 0; i < count; ++i) putU64(words[i]);
+        }
+    }
+    void putVarint(uint64_t value) {
+        while (value >= 0x80) {
+            buffer.push_back(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        buffer.push_back(static_cast<uint8_t>(value));
+    }
+    void reserve(size_t size) { buffer.reserve(size); }
+    const uint8_t* data() const { return buffer.data(); }
+    size_t size() const { return buffer.size(); }
+    vector<uint8_t>& bytes() { return buffer; }
+
+private:
+    void putLE(uint64_t value, int width) {
+        for (int i = 0; i < width; ++i) buffer.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+};
+
+// Bounds-checked cursor over a loaded file; every read fails once the
+// data runs out instead of walking past the end.
+class SaveReader {
+private:
+    const uint8_t* data;
+    size_t size;
+    size_t offset;
+
+public:
+    SaveReader(const uint8_t* bytes, size_t length) : data(bytes), size(length), offset(0) {}
+
+    size_t position() const { return offset; }
+    size_t remaining() const { return size - offset; }
+
+    bool getU8(uint8_t& value) { uint64_t raw; if (!getLE(raw, 1)) return false; value = uint8_t(raw); return true; }
+    bool getU16(uint16_t& value) { uint64_t raw; if (!getLE(raw, 2)) return false; value = uint16_t(raw); return true; }
+    bool getU32(uint32_t& value) { uint64_t raw; if (!getLE(raw, 4)) return false; value = uint32_t(raw); return true; }
+    bool getU64(uint64_t& value) { return getLE(value, 8); }
+    bool getI32(int32_t& value) { uint32_t raw; if (!getU32(raw)) return false; value = int32_t(raw); return true; }
+    bool getI64(int64_t& value) { uint64_t raw; if (!getU64(raw)) return false; value = int64_t(raw); return true; }
+    bool getF64(double& value) {
+        uint64_t raw;
+        if (!getU64(raw)) return false;
+        memcpy(&value, &raw, sizeof(value));
+        return true;
+    }
+    bool getBytes(void* out, size_t length) {
+        if (remaining() < length) return false;
+        memcpy(out, data + offset, length);
+        offset += length;
+        return true;
+    }
+    bool getWords(vector<uint64_t>& words, size_t count) {
+        if (count > remaining() / sizeof(uint64_t)) return false;
+        words.resize(count);
+        if (hostIsLittleEndian()) return getBytes(words.data(), count * sizeof(uint64_t));
+        for (auto& word : words) getU64(word);
+        return true;
+    }
+    bool getVarint(uint64_t& value) {
+        value = 0;
+        for (int shift = 0; shift < 64 && offset < size; shift += 7) {
+            uint8_t byte = data[offset++];
+            value |= uint64_t(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) return true;
+        }
+        return false;
+    }
+    template <typename T>
+    bool getHost(T& value) { return getBytes(&value, sizeof(T)); }
+
+private:
+    bool getLE(uint64_t& value, int width) {
+        if (remaining() < static_cast<size_t>(width)) return false;
+        value = 0;
+        for (int i = 0; i < width; ++i) value |= uint64_t(data[offset + i]) << (8 * i);
+        offset += width;
+        return true;
+    }
+};
+
+// Read-only view of a whole file, memory-mapped where the platform allows.
+class MappedFile {
+private:
+    const uint8_t* mapped;
+    size_t length;
+    vector<uint8_t> fallback;
+
+public:
+    MappedFile() : mapped(nullptr), length(0) {}
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile() {
+#if defined(__unix__) || defined(__APPLE__)
+        if (mapped && fallback.empty()) munmap(const_cast<uint8_t*>(mapped), length);
+#endif
+    }
+
+    bool open(const string& path) {
+#if defined(__unix__) || defined(__APPLE__)
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat info;
+        if (fstat(fd, &info) != 0) {
+            ::close(fd);
+            return false;
+        }
+        length = static_cast<size_t>(info.st_size);
+        if (length > 0) {
+            void* view = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (view != MAP_FAILED) {
+                madvise(view, length, MADV_SEQUENTIAL);
+                mapped = static_cast<const uint8_t*>(view);
+            }
+        }
+        ::close(fd);
+        if (mapped || length == 0) return true;
+#endif
+        ifstream inFile(path, ios::binary);
+        if (!inFile) return false;
+        fallback.assign(istreambuf_iterator<char>(inFile), istreambuf_iterator<char>());
+        mapped = fallback.data();
+        length = fallback.size();
+        return true;
+    }
+
+    const uint8_t* data() const { return mapped; }
+    size_t size() const { return length; }
+};
+
+// A state with no seats, or no state at all, saves every seat as still in.
+vector<uint8_t> encodeSaveGame(const RuleSet& rules, int currentRound, int diceSides, const vector<Player>& players,
+                               uint64_t generation = 0, RngEngine engine = RngEngine::Mt19937,
+                               const RuleState* state = nullptr) {
+    SaveWriter out;
+    size_t estimate = 32;
+    for (const auto& player : players) {
+        estimate += 64 + player.getName().size() + player.getDiceHistory().wordCount() * 8;
+    }
+    out.reserve(estimate);
+
+    out.putU32(SAVE_MAGIC);
+    out.putU16(SAVE_VERSION);
+    out.putU16(0);
+    out.putI32(rules.rounds);
+    out.putI32(currentRound);
+    out.putI32(diceSides);
+    out.putU32(static_cast<uint32_t>(players.size()));
+    out.putU64(generation);
+    out.putU8(static_cast<uint8_t>(engine));
+    out.putU8(static_cast<uint8_t>(rules.mode));
+    out.putI32(rules.target);
+    out.putI32(rules.maxRollMultiplier);
+    out.putI32(rules.streakMultiplier);
+    out.putI32(rules.doublesBonus);
+    out.putI32(rules.triplesBonus);
+    out.putI32(state ? state->lastWinner : -1);
+
+    for (size_t i = 0; i < players.size(); ++i) {
+        const Player& player = players[i];
+        const string& name = player.getName();
+        out.putU32(static_cast<uint32_t>(name.size()));
+        out.putBytes(name.data(), name.size());
+        out.putI32(player.getScore());
+        out.putI32(player.getWins());
+        out.putU8(state && i < state->alive.size() ? state->alive[i] : 1);
+
+        const RollHistory& history = player.getDiceHistory();
+        out.putU8(static_cast<uint8_t>(history.bitsPerRoll()));
+        out.putU64(history.size());
+        history.forEachWordRun([&](const uint64_t* words, size_t count) { out.putWords(words, count); });
+    }
+
+    out.putU64(fnv1a64(out.data(), out.size()));
+    return move(out.bytes());
+}
+
+// Whether saved rules and the round counter are ones a game could have
+// written. currentRound is the next round to play, so a Classic game saved
+// after its last round holds rounds + 1; the other modes run past rounds.
+bool validSavedRules(const RuleSet& rules, int currentRound) {
+    for (const auto& field : RULE_FIELDS) {
+        if (rules.*(field.field) < field.minValue || rules.*(field.field) > field.maxValue) return false;
+    }
+    return currentRound >= 0 && (rules.mode != GameMode::Classic || currentRound <= rules.rounds + 1);
+}
+
+// Layout written before SAVE_VERSION 1: host byte order, one int per roll,
+// score and wins recomputed by the old loader.
+bool decodeLegacySave(const uint8_t* data, size_t size, SavedGame& game) {
+    SaveReader in(data, size);
+    int rounds, currentRound, diceSides;
+    size_t numPlayers;
+    if (!in.getHost(rounds) || !in.getHost(currentRound) || !in.getHost(diceSides) || !in.getHost(numPlayers)) {
+        return false;
+    }
+    if (numPlayers > 64 || !dieKernels(diceSides)) return false;
+
+    vector<Player> players;
+    for (size_t i = 0; i < numPlayers; ++i) {
+        size_t nameLength;
+        if (!in.getHost(nameLength) || nameLength > in.remaining()) return false;
+        string name(nameLength, '\0');
+        in.getBytes(&name[0], nameLength);
+
+        int score, wins;
+        size_t historySize;
+        if (!in.getHost(score) || !in.getHost(wins) || !in.getHost(historySize)) return false;
+        if (wins < 0 || historySize > in.remaining() / sizeof(int)) return false;
+
+        Player player(name);
+        for (size_t j = 0; j < historySize; ++j) {
+            int roll = 0;
+            in.getHost(roll);
+            if (roll < 1 || roll > diceSides || !player.addToHistory(roll)) return false;
+        }
+        player.addToScore(score);
+        for (int w = 0; w < wins; ++w) player.incrementWins();
+        players.push_back(move(player));
+    }
+
+    RuleSet rules;
+    rules.rounds = rounds;
+    if (!validSavedRules(rules, currentRound)) return false;
+
+    game.rules = rules;
+    game.state.reset(players.size());
+    game.currentRound = currentRound;
+    game.diceSides = diceSides;
+    game.players = move(players);
+    return true;
+}
+
+bool decodeSaveGame(const uint8_t* data, size_t size, SavedGame& game) {
+    SaveReader in(data, size);
+    uint32_t magic = 0;
+    if (!in.getU32(magic) || magic != SAVE_MAGIC) return decodeLegacySave(data, size, game);
+
+    if (size < 12 + sizeof(uint64_t)) return false;
+    SaveReader trailer(data + size - sizeof(uint64_t), sizeof(uint64_t));
+    uint64_t checksum;
+    trailer.getU64(checksum);
+    if (checksum != fnv1a64(data, size - sizeof(uint64_t))) return false;
+    in = SaveReader(data, size - sizeof(uint64_t));
+    in.getU32(magic);
+
+    uint16_t version, reserved;
+    int32_t rounds, currentRound, diceSides;
+    uint32_t numPlayers;
+    if (!in.getU16(version) || !in.getU16(reserved) || version != SAVE_VERSION) return false;
+    if (!in.getI32(rounds) || !in.getI32(currentRound) || !in.getI32(diceSides) || !in.getU32(numPlayers)) {
         return false;
     }
+    if (numPlayers > 64 || !dieKernels(diceSides)) return false;
+    uint64_t generation;
+    uint8_t engine, mode;
+    RuleSet rules;
+    rules.rounds = rounds;
+    int32_t lastWinner;
+    if (!in.getU64(generation) || !in.getU8(engine) || engine > static_cast<uint8_t>(RngEngine::Philox) ||
+        !in.getU8(mode) || mode < static_cast<uint8_t>(GameMode::Classic) ||
+        mode > static_cast<uint8_t>(GameMode::Elimination) || !in.getI32(rules.target) ||
+        !in.getI32(rules.maxRollMultiplier) || !in.getI32(rules.streakMultiplier) ||
+        !in.getI32(rules.doublesBonus) || !in.getI32(rules.triplesBonus) || !in.getI32(lastWinner)) {
+        return false;
+    }
+    rules.mode = static_cast<GameMode>(mode);
+    if (lastWinner < -1 || lastWinner >= static_cast<int32_t>(numPlayers)) return false;
+    if (!validSavedRules(rules, currentRound)) return false;
+    RuleState state;
+    state.reset(numPlayers);
+    state.lastWinner = lastWinner;
+
+    vector<Player> players;
+    players.reserve(numPlayers);
+    for (uint32_t i = 0; i < numPlayers; ++i) {
+        uint32_t nameLength;
+        if (!in.getU32(nameLength) || nameLength > in.remaining()) return false;
+        string name(nameLength, '\0');
+        in.getBytes(&name[0], nameLength);
+
+        int32_t score, wins;
+        uint8_t alive, bits;
+        uint64_t rolls;
+        if (!in.getI32(score) || !in.getI32(wins) || !in.getU8(alive) || alive > 1 || !in.getU8(bits) ||
+            !in.getU64(rolls)) {
+            return false;
+        }
+        if ((bits != 4 && bits != 8) || rolls > in.remaining() * (64 / bits)) return false;
+
+        vector<uint64_t> words;
+        RollHistory history;
+        if (!in.getWords(words, (rolls * bits + 63) / 64) || !history.assignPacked(move(words), rolls, bits) ||
+            history.faceCount(0) > 0 || history.getFaceCounts().size() > static_cast<size_t>(diceSides) + 1) {
+            return false;
+        }
+
+        players.emplace_back(name);
+        players.back().restore(score, wins, move(history));
+        state.alive[i] = static_cast<char>(alive);
+        state.aliveCount -= 1 - alive;
+    }
+    if (in.remaining() != 0) return false;
+
+    game.rules = rules;
+    game.state = move(state);
+    game.currentRound = currentRound;
+    game.diceSides = diceSides;
+    game.generation = generation;
+    game.engine = static_cast<RngEngine>(engine);
+    game.players = move(players);
+    return true;
+}
+
+bool syncFile(FILE* file) {
+    bool ok = fflush(file) == 0;
+#if defined(__unix__) || defined(__APPLE__)
+    ok = ok && fsync(fileno(file)) == 0;
+#endif
+    return ok;
+}
+
+// Syncs the directory holding path, so a rename into it is durable too.
+bool syncDirectoryOf(const string& path) {
+#if defined(__unix__) || defined(__APPLE__)
+    size_t slash = path.find_last_of('/');
+    string directory = slash == string::npos ? "." : slash == 0 ? "/" : path.substr(0, slash);
+    int fd = ::open(directory.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    bool ok = fsync(fd) == 0;
+    ::close(fd);
+    return ok;
+#else
+    (void)path;
+    return true;
+#endif
+}
+
+// Replaces path so that a crash leaves either the old contents or the new
+// ones: the bytes are synced to a temp file before it is renamed over path,
+// and the directory is synced after the rename.
+bool writeFileAtomically(const string& path, const vector<uint8_t>& bytes) {
+    string temp = path + ".tmp";
+    FILE* file = fopen(temp.c_str(), "wb");
+    if (!file) return false;
+    bool ok = fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size() && syncFile(file);
+    ok = fclose(file) == 0 && ok;
+#ifdef _WIN32
+    if (ok) remove(path.c_str());
+#endif
+    if (!ok || rename(temp.c_str(), path.c_str()) != 0) {
+        remove(temp.c_str());
+        return false;
+    }
+    return syncDirectoryOf(path);
+}
+
+// Latency histograms and counters for the game's hot paths. Every thread
+// records into its own block with plain relaxed stores, so recording never
+// takes a lock or contends on a cache line; readers sum the blocks. Define
+// DICE_GAME_NO_METRICS to compile the recording side out entirely.
+enum class Metric : uint8_t {
+    RollAnimation, InputWait, RenderHeader, RenderScores, RenderPresent,
+    SaveGame, LoadGame, JournalCommit, Compaction, ServerRequest, EventDelivery, Count
+};
+
+enum class Counter : uint8_t {
+    Rolls, SaveBytes, LoadBytes, FrameBytes, Events, Count
+};
+
+const size_t METRIC_COUNT = static_cast<size_t>(Metric::Count);
+const size_t COUNTER_COUNT = static_cast<size_t>(Counter::Count);
+
+struct MetricInfo {
+    const char* name;
+    const char* help;
+};
+
+const MetricInfo METRIC_INFO[METRIC_COUNT] = {
+    {"roll_animation", "Time spent showing a roll animation"},
+    {"input_wait", "Time blocked waiting for player input"},
+    {"render_header", "Time spent rendering screen headers"},
+    {"render_scores", "Time spent rendering the standings table"},
+    {"render_present", "Time spent writing frames to the terminal"},
+    {"save", "Time spent saving a game"},
+    {"load", "Time spent loading a game"},
+    {"journal_commit", "Time spent writing and syncing journal records"},
+    {"compaction", "Time spent compacting the autosave journal"},
+    {"server_request", "Time spent handling one server request"},
+    {"event_delivery", "Time from publishing a roll event until a consumer handles it"},
+};
+
+const MetricInfo COUNTER_INFO[COUNTER_COUNT] = {
+    {"rolls", "Dice rolled"},
+    {"save_bytes", "Bytes written by game saves"},
+    {"load_bytes", "Bytes read by game loads"},
+    {"frame_bytes", "Bytes written to the terminal"},
+    {"events", "Roll events handled by the event bus consumers"},
+};
+
+// HDR-style log-linear buckets: values below 32 ns get their own bucket and
+// each power of two above that is split into 16, so any recorded latency is
+// known to within 1/16 of its value.
+const unsigned HISTOGRAM_SUB_BITS = 4;
+const uint64_t HISTOGRAM_SUB_BUCKETS = uint64_t(1) << HISTOGRAM_SUB_BITS;
+const unsigned HISTOGRAM_MAX_BITS = 42;  // about 73 minutes in nanoseconds
+const size_t HISTOGRAM_BUCKETS = (HISTOGRAM_MAX_BITS - HISTOGRAM_SUB_BITS + 1) * HISTOGRAM_SUB_BUCKETS;
+
+inline size_t histogramBucket(uint64_t nanos) {
+    nanos = min(nanos, (uint64_t(1) << HISTOGRAM_MAX_BITS) - 1);
+    if (nanos < 2 * HISTOGRAM_SUB_BUCKETS) return static_cast<size_t>(nanos);
+    unsigned top = static_cast<unsigned>(highestBit64(nanos));
+    unsigned shift = top - HISTOGRAM_SUB_BITS;
+    return (shift + 1) * HISTOGRAM_SUB_BUCKETS + ((nanos >> shift) & (HISTOGRAM_SUB_BUCKETS - 1));
+}
+
+// Largest value that lands in a bucket.
+inline uint64_t histogramBucketLimit(size_t bucket) {
+    if (bucket < 2 * HISTOGRAM_SUB_BUCKETS) return bucket;
+    uint64_t shift = bucket / HISTOGRAM_SUB_BUCKETS - 1;
+    uint64_t sub = bucket % HISTOGRAM_SUB_BUCKETS;
+    return ((HISTOGRAM_SUB_BUCKETS + sub + 1) << shift) - 1;
+}
+
+struct LatencyHistogram {
+    vector<uint64_t> buckets = vector<uint64_t>(HISTOGRAM_BUCKETS, 0);
+    uint64_t count = 0;
+    uint64_t sumNanos = 0;
+    uint64_t maxNanos = 0;
+
+    double meanNanos() const { return count ? double(sumNanos) / count : 0.0; }
+
+    uint64_t percentile(double q) const {
+        if (count == 0) return 0;
+        uint64_t rank = max<uint64_t>(1, static_cast<uint64_t>(ceil(q * count)));
+        uint64_t seen = 0;
+        for (size_t b = 0; b < buckets.size(); ++b) {
+            seen += buckets[b];
+            if (seen >= rank) return min(histogramBucketLimit(b), maxNanos);
+        }
+        return maxNanos;
+    }
+};
+
+struct MetricsSnapshot {
+    LatencyHistogram latencies[METRIC_COUNT];
+    uint64_t counters[COUNTER_COUNT] = {};
+    unsigned threads = 0;
+};
+
+#ifndef DICE_GAME_NO_METRICS
+struct MetricsBlock {
+    atomic<uint64_t> counters[COUNTER_COUNT];
+    atomic<uint64_t> buckets[METRIC_COUNT][HISTOGRAM_BUCKETS];
+    atomic<uint64_t> sums[METRIC_COUNT];
+    atomic<uint64_t> maxima[METRIC_COUNT];
+};
+
+// Owns one block per thread that ever recorded anything. Blocks outlive
+// their threads so nothing is lost when a worker exits before a dump.
+class MetricsRegistry {
+private:
+    mutex lock;
+    vector<unique_ptr<MetricsBlock>> blocks;
+
+    // Only the owning thread writes a block, so a load and store is enough.
+    static void bump(atomic<uint64_t>& value, uint64_t amount) {
+        value.store(value.load(memory_order_relaxed) + amount, memory_order_relaxed);
+    }
+
+    MetricsBlock& local() {
+        thread_local MetricsBlock* block = nullptr;
+        if (!block) {
+            lock_guard<mutex> guard(lock);
+            blocks.emplace_back(new MetricsBlock());
+            block = blocks.back().get();
+        }
+        return *block;
+    }
+
+public:
+    static MetricsRegistry& instance() {
+        static MetricsRegistry registry;
+        return registry;
+    }
+
+    void record(Metric metric, uint64_t nanos) {
+        MetricsBlock& block = local();
+        size_t m = static_cast<size_t>(metric);
+        bump(block.buckets[m][histogramBucket(nanos)], 1);
+        bump(block.sums[m], nanos);
+        if (nanos > block.maxima[m].load(memory_order_relaxed)) {
+            block.maxima[m].store(nanos, memory_order_relaxed);
+        }
+    }
+
+    void count(Counter counter, uint64_t amount) {
+        bump(local().counters[static_cast<size_t>(counter)], amount);
+    }
+
+    MetricsSnapshot snapshot() {
+        MetricsSnapshot snap;
+        lock_guard<mutex> guard(lock);
+        snap.threads = static_cast<unsigned>(blocks.size());
+        for (const auto& block : blocks) {
+            for (size_t c = 0; c < COUNTER_COUNT; ++c) {
+                snap.counters[c] += block->counters[c].load(memory_order_relaxed);
+            }
+            for (size_t m = 0; m < METRIC_COUNT; ++m) {
+                LatencyHistogram& histogram = snap.latencies[m];
+                for (size_t b = 0; b < HISTOGRAM_BUCKETS; ++b) {
+                    uint64_t hits = block->buckets[m][b].load(memory_order_relaxed);
+                    histogram.buckets[b] += hits;
+                    histogram.count += hits;
+                }
+                histogram.sumNanos += block->sums[m].load(memory_order_relaxed);
+                histogram.maxNanos = max(histogram.maxNanos, block->maxima[m].load(memory_order_relaxed));
+            }
+        }
+        return snap;
+    }
+};
+
+class ScopedTimer {
+private:
+    Metric metric;
+    chrono::steady_clock::time_point start;
+
+public:
+    explicit ScopedTimer(Metric timed) : metric(timed), start(chrono::steady_clock::now()) {}
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    ~ScopedTimer() {
+        auto elapsed = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start);
+        MetricsRegistry::instance().record(metric, static_cast<uint64_t>(elapsed.count()));
+    }
+};
+
+inline void countMetric(Counter counter, uint64_t amount = 1) {
+    MetricsRegistry::instance().count(counter, amount);
+}
+
+inline void recordMetric(Metric metric, uint64_t nanos) { MetricsRegistry::instance().record(metric, nanos); }
+
+inline MetricsSnapshot snapshotMetrics() { return MetricsRegistry::instance().snapshot(); }
+const bool METRICS_ENABLED = true;
+#else
+class ScopedTimer {
+public:
+    explicit ScopedTimer(Metric) {}
+};
+
+inline void countMetric(Counter, uint64_t = 1) {}
+inline void recordMetric(Metric, uint64_t) {}
+inline MetricsSnapshot snapshotMetrics() { return MetricsSnapshot(); }
+const bool METRICS_ENABLED = false;
+#endif
+
+string formatPrometheus(const MetricsSnapshot& snap) {
+    // Prometheus wants cumulative buckets; a fixed ladder keeps the series
+    // stable between scrapes while the fine buckets feed the quantiles.
+    static const double BOUNDS[] = {1e-6, 1e-5, 1e-4, 5e-4, 1e-3, 5e-3, 0.01, 0.05, 0.1, 0.5, 1, 5, 10};
+    ostringstream text;
+    text << setprecision(9);
+    for (size_t c = 0; c < COUNTER_COUNT; ++c) {
+        string name = string("dice_game_") + COUNTER_INFO[c].name + "_total";
+        text << "# HELP " << name << " " << COUNTER_INFO[c].help << "\n"
+             << "# TYPE " << name << " counter\n"
+             << name << " " << snap.counters[c] << "\n";
+    }
+    for (size_t m = 0; m < METRIC_COUNT; ++m) {
+        const LatencyHistogram& histogram = snap.latencies[m];
+        string name = string("dice_game_") + METRIC_INFO[m].name + "_seconds";
+        text << "# HELP " << name << " " << METRIC_INFO[m].help << "\n"
+             << "# TYPE " << name << " histogram\n";
+        size_t bucket = 0;
+        uint64_t cumulative = 0;
+        for (double bound : BOUNDS) {
+            while (bucket < HISTOGRAM_BUCKETS && histogramBucketLimit(bucket) <= bound * 1e9) {
+                cumulative += histogram.buckets[bucket++];
+            }
+            text << name << "_bucket{le=\"" << bound << "\"} " << cumulative << "\n";
+        }
+        text << name << "_bucket{le=\"+Inf\"} " << histogram.count << "\n"
+             << name << "_sum " << histogram.sumNanos / 1e9 << "\n"
+             << name << "_count " << histogram.count << "\n";
+    }
+    return text.str();
+}
+
+string formatMetricsJson(const MetricsSnapshot& snap) {
+    ostringstream json;
+    json << "{\n  \"threads\": " << snap.threads << ",\n  \"counters\": {";
+    for (size_t c = 0; c < COUNTER_COUNT; ++c) {
+        json << (c ? ", " : "") << "\"" << COUNTER_INFO[c].name << "\": " << snap.counters[c];
+    }
+    json << "},\n  \"latencies_ns\": {\n";
+    for (size_t m = 0; m < METRIC_COUNT; ++m) {
+        const LatencyHistogram& histogram = snap.latencies[m];
+        json << "    \"" << METRIC_INFO[m].name << "\": {\"count\": " << histogram.count
+             << ", \"sum\": " << histogram.sumNanos << ", \"mean\": " << fixed << setprecision(1)
+             << histogram.meanNanos() << ", \"p50\": " << histogram.percentile(0.50)
+             << ", \"p90\": " << histogram.percentile(0.90) << ", \"p99\": " << histogram.percentile(0.99)
+             << ", \"max\": " << histogram.maxNanos << "}" << (m + 1 < METRIC_COUNT ? ",\n" : "\n");
+    }
+    json << "  }\n}\n";
+    return json.str();
+}
+
+// Writes a snapshot to path: JSON for a .json file, Prometheus text otherwise.
+bool dumpMetrics(const string& path) {
+    MetricsSnapshot snap = snapshotMetrics();
+    bool json = path.size() >= 5 && path.compare(path.size() - 5, 5, ".json") == 0;
+    string text = json ? formatMetricsJson(snap) : formatPrometheus(snap);
+    return writeFileAtomically(path, vector<uint8_t>(text.begin(), text.end()));
+}
+
+string metricsPath;
+
+void dumpMetricsAtExit() {
+    if (!metricsPath.empty()) dumpMetrics(metricsPath);
+}
+
+// Dumps metrics to path when the process exits and whenever it receives
+// SIGUSR1. Must run before any other thread starts so every thread inherits
+// the blocked signal and only the dumper thread ever receives it.
+void startMetricsExport(const string& path) {
+    metricsPath = path;
+    snapshotMetrics();  // construct the registry before registering the exit hook
+    atexit(dumpMetricsAtExit);
+#if defined(__unix__) || defined(__APPLE__)
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGUSR1);
+    if (pthread_sigmask(SIG_BLOCK, &signals, nullptr) != 0) return;
+    thread([signals]() {
+        int received = 0;
+        while (sigwait(&signals, &received) == 0) dumpMetrics(metricsPath);
+    }).detach();
+#endif
+}
+
+const string AUTOSAVE_FILE = "dice_game_autosave.dat";
+const string JOURNAL_FILE = "dice_game_autosave.journal";
+const uint32_t JOURNAL_MAGIC = 0x4C4A4744;  // "DGJL" little-endian
+const uint16_t JOURNAL_VERSION = 1;
+const size_t JOURNAL_HEADER_SIZE = 16;
+const size_t JOURNAL_RECORD_SIZE = 16;
+const uint8_t JOURNAL_ROLL = 1;
+const uint8_t JOURNAL_ROUND_END = 2;
+const uint8_t JOURNAL_NO_WINNER = 0xFF;
+
+// Append-only write-ahead log of rolls and round results. Records are
+// fixed-size and buffered, then written and fsynced together once a group
+// of syncInterval records has built up.
+class RollJournal {
+private:
+    FILE* file;
+    SaveWriter pending;
+    size_t pendingRecords;
+    size_t syncInterval;
+    uint32_t sequence;
+
+    void append(uint8_t type, uint8_t player, uint16_t value, uint32_t round) {
+        size_t start = pending.size();
+        pending.putU8(type);
+        pending.putU8(player);
+        pending.putU16(value);
+        pending.putU32(round);
+        pending.putU32(sequence++);
+        pending.putU32(static_cast<uint32_t>(fnv1a64(pending.data() + start, 12)));
+        if (++pendingRecords >= syncInterval) commit();
+    }
+
+public:
+    RollJournal() : file(nullptr), pendingRecords(0), syncInterval(16), sequence(0) {}
+    RollJournal(const RollJournal&) = delete;
+    RollJournal& operator=(const RollJournal&) = delete;
+    ~RollJournal() { close(); }
+
+    void setSyncInterval(size_t records) { syncInterval = max<size_t>(records, 1); }
+    bool isOpen() const { return file != nullptr; }
+
+    // Starts an empty journal that follows the snapshot with this generation.
+    // The new journal is synced under a temp name and renamed over path, so
+    // on failure the old journal stays open and on disk as it was.
+    bool start(const string& path, uint64_t generation) {
+        SaveWriter header;
+        header.putU32(JOURNAL_MAGIC);
+        header.putU16(JOURNAL_VERSION);
+        header.putU16(0);
+        header.putU64(generation);
+
+        string temp = path + ".tmp";
+        FILE* fresh = fopen(temp.c_str(), "wb");
+        if (!fresh) return false;
+        if (fwrite(header.data(), 1, header.size(), fresh) != header.size() || !syncFile(fresh) ||
+            rename(temp.c_str(), path.c_str()) != 0) {
+            fclose(fresh);
+            remove(temp.c_str());
+            return false;
+        }
+        syncDirectoryOf(path);
+        close();
+        file = fresh;
+        sequence = 0;
+        return true;
+    }
+
+    void appendRoll(size_t player, int roll, int round) {
+        if (file) append(JOURNAL_ROLL, static_cast<uint8_t>(player), static_cast<uint16_t>(roll), round);
+    }
+
+    void appendRoundEnd(int winner, int round) {
+        uint8_t player = winner < 0 ? JOURNAL_NO_WINNER : static_cast<uint8_t>(winner);
+        if (file) append(JOURNAL_ROUND_END, player, 0, round);
+    }
+
+    bool commit() {
+        if (!file) return false;
+        ScopedTimer timer(Metric::JournalCommit);
+        bool ok = true;
+        if (pending.size() > 0) {
+            ok = fwrite(pending.data(), 1, pending.size(), file) == pending.size() && syncFile(file);
+            pending.bytes().clear();
+            pendingRecords = 0;
+        }
+        return ok;
+    }
+
+    void close() {
+        if (!file) return;
+        commit();
+        fclose(file);
+        file = nullptr;
+    }
+};
+
+// Applies the journal tail on top of a snapshot, scoring each round with
+// the snapshot's rules. Only whole rounds are replayed; a torn or
+// half-written round at the end is dropped. Returns the number of rounds
+// recovered, or -1 when the journal does not belong to this snapshot.
+int replayJournal(const uint8_t* data, size_t size, SavedGame& game) {
+    SaveReader in(data, size);
+    uint32_t magic;
+    uint16_t version, reserved;
+    uint64_t generation;
+    if (!in.getU32(magic) || magic != JOURNAL_MAGIC || !in.getU16(version) || version != JOURNAL_VERSION ||
+        !in.getU16(reserved) || !in.getU64(generation) || generation != game.generation) {
+        return -1;
+    }
+
+    CompiledRules rules(game.rules, game.diceSides);
+    vector<int> roundRolls(game.players.size()), bonus(game.players.size());
+    int recovered = 0;
+    uint32_t expected = 0;
+    while (in.remaining() >= JOURNAL_RECORD_SIZE) {
+        const uint8_t* record = data + in.position();
+        uint8_t type = 0, player = 0;
+        uint16_t value = 0;
+        uint32_t round = 0, sequence = 0, check = 0;
+        in.getU8(type);
+        in.getU8(player);
+        in.getU16(value);
+        in.getU32(round);
+        in.getU32(sequence);
+        in.getU32(check);
+        if (check != static_cast<uint32_t>(fnv1a64(record, 12)) || sequence != expected++) break;
+
+        if (type == JOURNAL_ROLL && player < game.players.size() && value >= 1 && value <= game.diceSides) {
+            roundRolls[player] = value;
+        } else if (type == JOURNAL_ROUND_END) {
+            RoundOutcome outcome = rules.scoreRound(roundRolls.data(), roundRolls.size(), game.state, bonus.data());
+            for (size_t i = 0; i < game.players.size(); ++i) {
+                if (roundRolls[i] > 0) game.players[i].addToHistory(roundRolls[i]);
+                game.players[i].addToScore(rules.rollPoints(roundRolls[i]) + bonus[i]);
+            }
+            if (outcome.winner >= 0) game.players[outcome.winner].incrementWins();
+            fill(roundRolls.begin(), roundRolls.end(), 0);
+            game.currentRound = static_cast<int>(round) + 1;
+            recovered++;
+        } else {
+            break;
+        }
+    }
+    return recovered;
+}
+
+const string CAREER_FILE = "dice_game_careers.db";
+const string CAREER_WAL_FILE = "dice_game_careers.wal";
+const uint32_t CAREER_MAGIC = 0x53434744;      // "DGCS" little-endian
+const uint32_t CAREER_WAL_MAGIC = 0x57434744;  // "DGCW" little-endian
+const uint16_t CAREER_VERSION = 1;
+const size_t CAREER_PAGE_SIZE = 4096;
+const size_t CAREER_CACHE_PAGES = 256;
+
+inline uint16_t loadLE16(const uint8_t* p) { return static_cast<uint16_t>(p[0] | (p[1] << 8)); }
+
+inline uint32_t loadLE32(const uint8_t* p) {
+    return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+}
+
+inline uint64_t loadLE64(const uint8_t* p) { return uint64_t(loadLE32(p)) | (uint64_t(loadLE32(p + 4)) << 32); }
+
+inline void storeLE16(uint8_t* p, uint16_t value) {
+    p[0] = static_cast<uint8_t>(value);
+    p[1] = static_cast<uint8_t>(value >> 8);
+}
+
+inline void storeLE32(uint8_t* p, uint32_t value) {
+    for (int i = 0; i < 4; ++i) p[i] = static_cast<uint8_t>(value >> (8 * i));
+}
+
+inline void storeLE64(uint8_t* p, uint64_t value) {
+    storeLE32(p, static_cast<uint32_t>(value));
+    storeLE32(p + 4, static_cast<uint32_t>(value >> 32));
+}
+
+// Fixed-size pages of one file behind an LRU cache. Writes stay in the
+// cache until commit(), which logs every dirty page to a write-ahead file,
+// syncs it, and only then updates the pages in place. open() redoes a
+// complete log left behind by a crash and discards a torn one, so a batch
+// of changes lands whole or not at all.
+class PageStore {
+private:
+    struct Frame {
+        vector<uint8_t> data;
+        bool dirty;
+        list<uint32_t>::iterator recent;
+    };
+
+    FILE* file;
+    string walPath;
+    uint32_t pageCount;
+    uint32_t committedPages;
+    size_t capacity;
+    unordered_map<uint32_t, Frame> frames;
+    list<uint32_t> recency;  // most recently used first
+    uint64_t hits, misses;
+
+    // Drops least recently used clean pages; dirty pages stay pinned until commit.
+    void evict() {
+        auto it = recency.end();
+        while (frames.size() >= capacity && it != recency.begin()) {
+            --it;
+            auto found = frames.find(*it);
+            if (found->second.dirty) continue;
+            frames.erase(found);
+            it = recency.erase(it);
+        }
+    }
+
+    Frame& frame(uint32_t page) {
+        auto found = frames.find(page);
+        if (found != frames.end()) {
+            hits++;
+            recency.splice(recency.begin(), recency, found->second.recent);
+            return found->second;
+        }
+        misses++;
+        evict();
+        Frame& slot = frames[page];
+        slot.data.assign(CAREER_PAGE_SIZE, 0);
+        slot.dirty = false;
+        if (page < committedPages && fseek(file, long(page) * long(CAREER_PAGE_SIZE), SEEK_SET) == 0) {
+            if (fread(slot.data.data(), 1, CAREER_PAGE_SIZE, file) != CAREER_PAGE_SIZE) {
+                fill(slot.data.begin(), slot.data.end(), 0);
+            }
+        }
+        recency.push_front(page);
+        slot.recent = recency.begin();
+        return slot;
+    }
+
+    bool writePage(uint32_t page, const uint8_t* data) {
+        return fseek(file, long(page) * long(CAREER_PAGE_SIZE), SEEK_SET) == 0 &&
+               fwrite(data, 1, CAREER_PAGE_SIZE, file) == CAREER_PAGE_SIZE;
+    }
+
+    // Redoes a complete write-ahead log and removes it. A log whose trailer
+    // does not verify never reached its sync, so the file is still intact.
+    bool recover() {
+        ifstream log(walPath, ios::binary);
+        if (!log) return true;
+        vector<uint8_t> bytes((istreambuf_iterator<char>(log)), istreambuf_iterator<char>());
+        log.close();
+
+        const size_t header = 16, frameSize = 4 + CAREER_PAGE_SIZE;
+        bool complete = bytes.size() >= header + sizeof(uint64_t) && loadLE32(bytes.data()) == CAREER_WAL_MAGIC &&
+                        loadLE16(bytes.data() + 4) == CAREER_VERSION;
+        size_t count = complete ? loadLE32(bytes.data() + 12) : 0;
+        complete = complete && bytes.size() == header + count * frameSize + sizeof(uint64_t) &&
+                   loadLE64(bytes.data() + bytes.size() - 8) == fnv1a64(bytes.data(), bytes.size() - 8);
+        if (complete) {
+            for (size_t i = 0; i < count; ++i) {
+                const uint8_t* entry = bytes.data() + header + i * frameSize;
+                if (!writePage(loadLE32(entry), entry + 4)) return false;
+            }
+            if (!syncFile(file)) return false;
+        }
+        remove(walPath.c_str());
+        return true;
+    }
+
+public:
+    PageStore() : file(nullptr), pageCount(0), committedPages(0), capacity(CAREER_CACHE_PAGES), hits(0), misses(0) {}
+    PageStore(const PageStore&) = delete;
+    PageStore& operator=(const PageStore&) = delete;
+    ~PageStore() { close(); }
+
+    bool open(const string& path, const string& logPath) {
+        close();
+        walPath = logPath;
+        file = fopen(path.c_str(), "r+b");
+        if (!file) file = fopen(path.c_str(), "w+b");
+        if (!file || !recover() || fseek(file, 0, SEEK_END) != 0) {
+            close();
+            return false;
+        }
+        committedPages = pageCount = static_cast<uint32_t>(ftell(file) / long(CAREER_PAGE_SIZE));
+        return true;
+    }
+
+    void close() {
+        rollback();
+        frames.clear();
+        recency.clear();
+        if (file) fclose(file);
+        file = nullptr;
+    }
+
+    bool isOpen() const { return file != nullptr; }
+    uint32_t size() const { return pageCount; }
+    uint64_t cacheHits() const { return hits; }
+    uint64_t cacheMisses() const { return misses; }
+
+    void read(uint32_t page, uint8_t* out) { memcpy(out, frame(page).data.data(), CAREER_PAGE_SIZE); }
+
+    void write(uint32_t page, const uint8_t* data) {
+        Frame& target = frame(page);
+        memcpy(target.data.data(), data, CAREER_PAGE_SIZE);
+        target.dirty = true;
+    }
+
+    // Appends a zeroed page; it reaches the file with the next commit.
+    uint32_t allocate() {
+        uint32_t page = pageCount++;
+        frame(page).dirty = true;
+        return page;
+    }
+
+    bool commit() {
+        if (!file) return false;
+        vector<uint32_t> dirty;
+        for (const auto& entry : frames) {
+            if (entry.second.dirty) dirty.push_back(entry.first);
+        }
+        if (dirty.empty()) return true;
+        sort(dirty.begin(), dirty.end());
+
+        SaveWriter wal;
+        wal.putU32(CAREER_WAL_MAGIC);
+        wal.putU16(CAREER_VERSION);
+        wal.putU16(0);
+        wal.putU32(pageCount);
+        wal.putU32(static_cast<uint32_t>(dirty.size()));
+        for (uint32_t page : dirty) {
+            wal.putU32(page);
+            wal.putBytes(frames[page].data.data(), CAREER_PAGE_SIZE);
+        }
+        wal.putU64(fnv1a64(wal.data(), wal.size()));
+
+        FILE* log = fopen(walPath.c_str(), "wb");
+        bool ok = log && fwrite(wal.data(), 1, wal.size(), log) == wal.size() && syncFile(log);
+        if (log) fclose(log);
+        if (!ok) {
+            remove(walPath.c_str());
+            rollback();
+            return false;
+        }
+
+        // From here on the log is durable; a failure is repaired by the next open().
+        for (uint32_t page : dirty) ok = ok && writePage(page, frames[page].data.data());
+        ok = ok && syncFile(file);
+        if (ok) remove(walPath.c_str());
+        for (uint32_t page : dirty) frames[page].dirty = false;
+        committedPages = pageCount;
+        return ok;
+    }
+
+    // Forgets every change since the last commit.
+    void rollback() {
+        for (auto it = frames.begin(); it != frames.end();) {
+            if (it->second.dirty) {
+                recency.erase(it->second.recent);
+                it = frames.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        pageCount = committedPages;
+    }
+};
+
+struct BTreeKey {
+    uint64_t high;
+    uint64_t low;
+
+    bool operator<(const BTreeKey& other) const {
+        return high != other.high ? high < other.high : low < other.low;
+    }
+    bool operator==(const BTreeKey& other) const { return high == other.high && low == other.low; }
+};
+
+// B+tree of 16-byte keys and fixed-size values stored in PageStore pages.
+// Leaves are chained left to right for range scans. erase() leaves nodes
+// underfull instead of rebalancing; career data only ever shrinks when a
+// rank key moves, so the tree stays close to full anyway.
+class BTree {
+private:
+    static const uint8_t LEAF = 1;
+    static const uint8_t BRANCH = 2;
+    static const size_t NODE_HEADER = 8;  // type, reserved, count, link
+    static const size_t KEY_SIZE = 16;
+
+    PageStore* pages;
+    uint32_t root;
+    size_t valueSize;
+
+    typedef vector<uint8_t> Node;
+
+    static uint8_t nodeType(const Node& node) { return node[0]; }
+    static size_t nodeCount(const Node& node) { return loadLE16(&node[2]); }
+    // Right sibling of a leaf, or the leftmost child of a branch.
+    static uint32_t nodeLink(const Node& node) { return loadLE32(&node[4]); }
+
+    size_t entrySize(const Node& node) const { return KEY_SIZE + (nodeType(node) == LEAF ? valueSize : 4); }
+    size_t capacity(const Node& node) const { return (CAREER_PAGE_SIZE - NODE_HEADER) / entrySize(node); }
+    uint8_t* entry(Node& node, size_t index) const { return &node[NODE_HEADER + index * entrySize(node)]; }
+    const uint8_t* entry(const Node& node, size_t index) const {
+        return &node[NODE_HEADER + index * entrySize(node)];
+    }
+
+    static BTreeKey keyAt(const uint8_t* entry) { return {loadLE64(entry), loadLE64(entry + 8)}; }
+    static void setKey(uint8_t* entry, const BTreeKey& key) {
+        storeLE64(entry, key.high);
+        storeLE64(entry + 8, key.low);
+    }
+
+    Node makeNode(uint8_t type, uint32_t link) const {
+        Node node(CAREER_PAGE_SIZE, 0);
+        node[0] = type;
+        storeLE32(&node[4], link);
+        return node;
+    }
+
+    // First entry whose key is not less than key.
+    size_t lowerBound(const Node& node, const BTreeKey& key) const {
+        size_t low = 0, high = nodeCount(node);
+        while (low < high) {
+            size_t mid = (low + high) / 2;
+            if (keyAt(entry(node, mid)) < key) low = mid + 1;
+            else high = mid;
+        }
+        return low;
+    }
+
+    // Child of a branch that covers key.
+    uint32_t childFor(const Node& node, const BTreeKey& key, size_t& slot) const {
+        size_t low = 0, high = nodeCount(node);
+        while (low < high) {
+            size_t mid = (low + high) / 2;
+            if (key < keyAt(entry(node, mid))) high = mid;
+            else low = mid + 1;
+        }
+        slot = low;
+        return low == 0 ? nodeLink(node) : loadLE32(entry(node, low - 1) + KEY_SIZE);
+    }
+
+    uint32_t findLeaf(const BTreeKey& key, Node& node) const {
+        uint32_t page = root;
+        pages->read(page, node.data());
+        while (nodeType(node) == BRANCH) {
+            size_t slot;
+            page = childFor(node, key, slot);
+            pages->read(page, node.data());
+        }
+        return page;
+    }
+
+    // Inserts an entry at index, splitting the node when it is full. On a
+    // split the new right node's page and first key are returned for the parent.
+    bool insertEntry(uint32_t page, Node& node, size_t index, const uint8_t* data,
+                     BTreeKey& splitKey, uint32_t& splitPage) {
+        size_t count = nodeCount(node), width = entrySize(node);
+        if (count < capacity(node)) {
+            uint8_t* at = entry(node, index);
+            memmove(at + width, at, (count - index) * width);
+            memcpy(at, data, width);
+            storeLE16(&node[2], static_cast<uint16_t>(count + 1));
+            pages->write(page, node.data());
+            return false;
+        }
+
+        vector<uint8_t> all(entry(node, 0), entry(node, 0) + count * width);
+        all.insert(all.begin() + index * width, data, data + width);
+        size_t total = count + 1, half = total / 2;
+        bool leaf = nodeType(node) == LEAF;
+
+        splitPage = pages->allocate();
+        splitKey = keyAt(&all[half * width]);
+        Node right = makeNode(nodeType(node), leaf ? nodeLink(node) : loadLE32(&all[half * width] + KEY_SIZE));
+        // A branch hands its middle key up rather than keeping a copy.
+        size_t rightStart = leaf ? half : half + 1;
+        memcpy(entry(right, 0), &all[rightStart * width], (total - rightStart) * width);
+        storeLE16(&right[2], static_cast<uint16_t>(total - rightStart));
+
+        memcpy(entry(node, 0), all.data(), half * width);
+        memset(entry(node, half), 0, CAREER_PAGE_SIZE - NODE_HEADER - half * width);
+        storeLE16(&node[2], static_cast<uint16_t>(half));
+        if (leaf) storeLE32(&node[4], splitPage);
+
+        pages->write(page, node.data());
+        pages->write(splitPage, right.data());
+        return true;
+    }
+
+    bool insert(uint32_t page, const BTreeKey& key, const uint8_t* value, BTreeKey& splitKey, uint32_t& splitPage) {
+        Node node(CAREER_PAGE_SIZE);
+        pages->read(page, node.data());
+        if (nodeType(node) == LEAF) {
+            size_t index = lowerBound(node, key);
+            if (index < nodeCount(node) && keyAt(entry(node, index)) == key) {
+                if (valueSize > 0) memcpy(entry(node, index) + KEY_SIZE, value, valueSize);
+                pages->write(page, node.data());
+                return false;
+            }
+            vector<uint8_t> data(KEY_SIZE + valueSize);
+            setKey(data.data(), key);
+            if (valueSize > 0) memcpy(data.data() + KEY_SIZE, value, valueSize);
+            return insertEntry(page, node, index, data.data(), splitKey, splitPage);
+        }
+
+        size_t slot;
+        uint32_t child = childFor(node, key, slot);
+        BTreeKey childKey;
+        uint32_t childPage;
+        if (!insert(child, key, value, childKey, childPage)) return false;
+        uint8_t data[KEY_SIZE + 4];
+        setKey(data, childKey);
+        storeLE32(data + KEY_SIZE, childPage);
+        return insertEntry(page, node, slot, data, splitKey, splitPage);
+    }
+
+public:
+    BTree() : pages(nullptr), root(0), valueSize(0) {}
+    BTree(PageStore& store, uint32_t rootPage, size_t bytes) : pages(&store), root(rootPage), valueSize(bytes) {}
+
+    uint32_t getRoot() const { return root; }
+
+    void put(const BTreeKey& key, const uint8_t* value) {
+        if (root == 0) {
+            root = pages->allocate();
+            Node leaf = makeNode(LEAF, 0);
+            pages->write(root, leaf.data());
+        }
+        BTreeKey splitKey;
+        uint32_t splitPage;
+        if (!insert(root, key, value, splitKey, splitPage)) return;
+        uint32_t newRoot = pages->allocate();
+        Node branch = makeNode(BRANCH, root);
+        setKey(entry(branch, 0), splitKey);
+        storeLE32(entry(branch, 0) + KEY_SIZE, splitPage);
+        storeLE16(&branch[2], 1);
+        pages->write(newRoot, branch.data());
+        root = newRoot;
+    }
+
+    bool find(const BTreeKey& key, uint8_t* value) const {
+        if (root == 0) return false;
+        Node node(CAREER_PAGE_SIZE);
+        findLeaf(key, node);
+        size_t index = lowerBound(node, key);
+        if (index >= nodeCount(node) || !(keyAt(entry(node, index)) == key)) return false;
+        if (value && valueSize > 0) memcpy(value, entry(node, index) + KEY_SIZE, valueSize);
+        return true;
+    }
+
+    bool erase(const BTreeKey& key) {
+        if (root == 0) return false;
+        Node node(CAREER_PAGE_SIZE);
+        uint32_t page = findLeaf(key, node);
+        size_t index = lowerBound(node, key), count = nodeCount(node), width = entrySize(node);
+        if (index >= count || !(keyAt(entry(node, index)) == key)) return false;
+        uint8_t* at = entry(node, index);
+        memmove(at, at + width, (count - index - 1) * width);
+        memset(entry(node, count - 1), 0, width);
+        storeLE16(&node[2], static_cast<uint16_t>(count - 1));
+        pages->write(page, node.data());
+        return true;
+    }
+
+    // Calls visit(key, value) for each entry from the first key >= from, in
+    // key order, until it returns false.
+    template <typename Visit>
+    void scan(const BTreeKey& from, Visit&& visit) const {
+        if (root == 0) return;
+        Node node(CAREER_PAGE_SIZE);
+        findLeaf(from, node);
+        size_t index = lowerBound(node, from);
+        while (true) {
+            for (; index < nodeCount(node); ++index) {
+                const uint8_t* at = entry(node, index);
+                if (!visit(keyAt(at), at + KEY_SIZE)) return;
+            }
+            uint32_t next = nodeLink(node);
+            if (next == 0) return;
+            pages->read(next, node.data());
+            index = 0;
+        }
+    }
+};
+
+const size_t CAREER_NAME_BYTES = 40;  // longest name a career can be kept under
+const size_t CAREER_RECORD_SIZE = 192;
+const size_t CAREER_RIVAL_SIZE = 16;
+
+struct CareerRecord {
+    uint64_t id = 0;
+    string name;
+    uint64_t games = 0;
+    uint64_t wins = 0;
+    uint64_t ties = 0;
+    uint64_t rolls = 0;
+    uint64_t rollSum = 0;
+    uint32_t bestRoll = 0;
+    uint64_t faces[MAX_DICE_SIDES + 1] = {};
+
+    double winRate() const { return games > 0 ? double(wins) / games : 0.0; }
+    double averageRoll() const { return rolls > 0 ? double(rollSum) / rolls : 0.0; }
+
+    void encode(uint8_t* out) const {
+        memset(out, 0, CAREER_RECORD_SIZE);
+        storeLE64(out, id);
+        memcpy(out + 8, name.data(), name.size());
+        storeLE64(out + 48, games);
+        storeLE64(out + 56, wins);
+        storeLE64(out + 64, ties);
+        storeLE64(out + 72, rolls);
+        storeLE64(out + 80, rollSum);
+        storeLE32(out + 88, bestRoll);
+        for (int face = 1; face <= MAX_DICE_SIDES; ++face) storeLE64(out + 96 + 8 * (face - 1), faces[face]);
+    }
+
+    void decode(const uint8_t* in) {
+        id = loadLE64(in);
+        const char* text = reinterpret_cast<const char*>(in + 8);
+        name.assign(text, strnlen(text, CAREER_NAME_BYTES));
+        games = loadLE64(in + 48);
+        wins = loadLE64(in + 56);
+        ties = loadLE64(in + 64);
+        rolls = loadLE64(in + 72);
+        rollSum = loadLE64(in + 80);
+        bestRoll = loadLE32(in + 88);
+        faces[0] = 0;
+        for (int face = 1; face <= MAX_DICE_SIDES; ++face) faces[face] = loadLE64(in + 96 + 8 * (face - 1));
+    }
+};
+
+// Results of one player against one opponent, from the player's side.
+struct HeadToHead {
+    uint32_t wins = 0;
+    uint32_t losses = 0;
+    uint32_t ties = 0;
+    uint32_t games = 0;
+};
+
+// Career statistics for every player who has finished a game, kept on disk
+// across sessions. Four B+trees share one page file:
+//   records  (id, 0)          -> CareerRecord
+//   names    (hash(name), id) -> nothing; the hash prefix narrows a lookup
+//   ranks    (~rank, id)      -> nothing; in-order scan is best win rate first
+//   rivals   (id, opponent)   -> HeadToHead, stored for both sides
+// so lookups, leaderboards and rivalries cost O(log n) page reads instead of
+// a scan of every player.
+class CareerStore {
+private:
+    PageStore pages;
+    BTree records, names, ranks, rivals;
+    uint64_t nextId;
+    uint64_t playerCount;
+
+    static BTreeKey nameKey(const string& name, uint64_t id) {
+        return {fnv1a64(reinterpret_cast<const uint8_t*>(name.data()), name.size()), id};
+    }
+
+    // Win rate in the top 40 bits and games played below, inverted so the
+    // best record sorts first; ties on both fall back to the older id.
+    static BTreeKey rankKey(const CareerRecord& record) {
+        uint64_t rate = static_cast<uint64_t>(record.winRate() * double((uint64_t(1) << 40) - 1));
+        uint64_t games = min<uint64_t>(record.games, (uint64_t(1) << 24) - 1);
+        return {~((rate << 24) | games), record.id};
+    }
+
+    bool fetch(uint64_t id, CareerRecord& record) const {
+        uint8_t data[CAREER_RECORD_SIZE];
+        if (!records.find({id, 0}, data)) return false;
+        record.decode(data);
+        return true;
+    }
+
+    void store(const CareerRecord& before, const CareerRecord& after) {
+        uint8_t data[CAREER_RECORD_SIZE];
+        after.encode(data);
+        records.put({after.id, 0}, data);
+        if (before.games > 0) ranks.erase(rankKey(before));
+        ranks.put(rankKey(after), nullptr);
+    }
+
+    void writeHeader() {
+        uint8_t header[CAREER_PAGE_SIZE] = {};
+        storeLE32(header, CAREER_MAGIC);
+        storeLE16(header + 4, CAREER_VERSION);
+        storeLE32(header + 8, records.getRoot());
+        storeLE32(header + 12, names.getRoot());
+        storeLE32(header + 16, ranks.getRoot());
+        storeLE32(header + 20, rivals.getRoot());
+        storeLE64(header + 24, nextId);
+        storeLE64(header + 32, playerCount);
+        pages.write(0, header);
+    }
+
+public:
+    CareerStore() : nextId(1), playerCount(0) {}
+
+    bool open(const string& path = CAREER_FILE, const string& walPath = CAREER_WAL_FILE) {
+        if (!pages.open(path, walPath)) return false;
+        uint8_t header[CAREER_PAGE_SIZE];
+        uint32_t roots[4] = {0, 0, 0, 0};
+        nextId = 1;
+        playerCount = 0;
+        if (pages.size() == 0) {
+            pages.allocate();
+        } else {
+            pages.read(0, header);
+            if (loadLE32(header) != CAREER_MAGIC || loadLE16(header + 4) != CAREER_VERSION) {
+                pages.close();
+                return false;
+            }
+            for (int i = 0; i < 4; ++i) roots[i] = loadLE32(header + 8 + 4 * i);
+            nextId = loadLE64(header + 24);
+            playerCount = loadLE64(header + 32);
+        }
+        records = BTree(pages, roots[0], CAREER_RECORD_SIZE);
+        names = BTree(pages, roots[1], 0);
+        ranks = BTree(pages, roots[2], 0);
+        rivals = BTree(pages, roots[3], CAREER_RIVAL_SIZE);
+        if (pages.size() > 1) return true;
+        writeHeader();
+        return pages.commit();
+    }
+
+    bool isOpen() const { return pages.isOpen(); }
+    uint64_t size() const { return playerCount; }
+    uint64_t cacheHits() const { return pages.cacheHits(); }
+    uint64_t cacheMisses() const { return pages.cacheMisses(); }
+
+    bool lookup(const string& name, CareerRecord& record) const {
+        if (!isOpen() || name.size() > CAREER_NAME_BYTES) return false;
+        BTreeKey first = nameKey(name, 0);
+        bool found = false;
+        names.scan(first, [&](const BTreeKey& key, const uint8_t*) {
+            if (key.high != first.high) return false;
+            found = fetch(key.low, record) && record.name == name;
+            return !found;
+        });
+        return found;
+    }
+
+    // Folds one finished game into every player's career and commits all of
+    // it as a single batch. winner is the seat the rules declared the
+    // winner; with none, everyone sharing the top score is credited a tie.
+    // Names are kept whole, so a game with a name too long for a record is
+    // refused rather than filed under a cut-down name.
+    bool recordGame(const vector<Player>& players, int winner) {
+        if (!isOpen() || players.empty()) return false;
+        for (const auto& player : players) {
+            if (player.getName().size() > CAREER_NAME_BYTES) return false;
+        }
+        int topScore = players[0].getScore();
+        for (const auto& player : players) topScore = max(topScore, player.getScore());
+
+        vector<uint64_t> ids;
+        for (size_t seat = 0; seat < players.size(); ++seat) {
+            const Player& player = players[seat];
+            CareerRecord before, after;
+            if (!lookup(player.getName(), before)) {
+                before = CareerRecord();
+                before.id = nextId++;
+                before.name = player.getName();
+                names.put(nameKey(before.name, before.id), nullptr);
+                playerCount++;
+            }
+            after = before;
+            after.games++;
+            if (winner >= 0 ? seat == static_cast<size_t>(winner) : player.getScore() == topScore) {
+                (winner >= 0 ? after.wins : after.ties)++;
+            }
+            after.rolls += player.getRollCount();
+            after.rollSum += static_cast<uint64_t>(max<int64_t>(player.getRollSum(), 0));
+            after.bestRoll = max<uint32_t>(after.bestRoll, static_cast<uint32_t>(max(player.getBestRoll(), 0)));
+            for (int face = 1; face <= MAX_DICE_SIDES; ++face) {
+                after.faces[face] += player.getDiceHistory().faceCount(face);
+            }
+            store(before, after);
+            ids.push_back(after.id);
+        }
+
+        // Head-to-head results follow the final standings. Players share a
+        // place when the standings cannot tell them apart: level on score,
+        // with neither of them the declared winner.
+        vector<size_t> order = rankPlayers(players, winner), place(players.size());
+        for (size_t p = 0; p < order.size(); ++p) {
+            size_t seat = order[p], above = p > 0 ? order[p - 1] : seat;
+            bool level = p > 0 && static_cast<int>(above) != winner &&
+                         players[above].getScore() == players[seat].getScore();
+            place[seat] = level ? place[above] : p;
+        }
+        for (size_t i = 0; i < players.size(); ++i) {
+            for (size_t j = 0; j < players.size(); ++j) {
+                if (ids[i] == ids[j]) continue;
+                uint8_t data[CAREER_RIVAL_SIZE] = {};
+                rivals.find({ids[i], ids[j]}, data);
+                size_t field = place[i] < place[j] ? 0 : place[i] > place[j] ? 4 : 8;
+                storeLE32(data + field, loadLE32(data + field) + 1);
+                storeLE32(data + 12, loadLE32(data + 12) + 1);
+                rivals.put({ids[i], ids[j]}, data);
+            }
+        }
+        writeHeader();
+        return pages.commit();
+    }
+
+    // The best win rates among players with at least minGames games.
+    vector<CareerRecord> topWinRates(size_t count, uint64_t minGames = 1) const {
+        vector<CareerRecord> leaders;
+        if (!isOpen() || count == 0) return leaders;
+        ranks.scan({0, 0}, [&](const BTreeKey& key, const uint8_t*) {
+            CareerRecord record;
+            if (fetch(key.low, record) && record.games >= minGames) leaders.push_back(record);
+            return leaders.size() < count;
+        });
+        return leaders;
+    }
+
+    // Everyone this player has met, most games played first.
+    vector<pair<CareerRecord, HeadToHead>> rivalsOf(const CareerRecord& record, size_t count) const {
+        vector<pair<CareerRecord, HeadToHead>> result;
+        if (!isOpen()) return result;
+        rivals.scan({record.id, 0}, [&](const BTreeKey& key, const uint8_t* data) {
+            if (key.high != record.id) return false;
+            pair<CareerRecord, HeadToHead> rival;
+            if (!fetch(key.low, rival.first)) return true;
+            rival.second.wins = loadLE32(data);
+            rival.second.losses = loadLE32(data + 4);
+            rival.second.ties = loadLE32(data + 8);
+            rival.second.games = loadLE32(data + 12);
+            result.push_back(rival);
+            return true;
+        });
+        stable_sort(result.begin(), result.end(), [](const auto& a, const auto& b) {
+            return a.second.games > b.second.games;
+        });
+        if (result.size() > count) result.resize(count);
+        return result;
+    }
+};
+
+void printCareerLeaders(ostream& out, const CareerStore& careers, size_t count) {
+    vector<CareerRecord> leaders = careers.topWinRates(count);
+    if (leaders.empty()) {
+        out << "No finished games recorded yet.\n";
+        return;
+    }
+    out << BOLD << left << setw(6) << "Rank" << setw(22) << "Player" << right << setw(8) << "Games"
+        << setw(8) << "Wins" << setw(8) << "Ties" << setw(9) << "Win %" << setw(8) << "Best" << RESET << "\n";
+    for (size_t i = 0; i < leaders.size(); ++i) {
+        const CareerRecord& record = leaders[i];
+        out << left << setw(6) << (i + 1) << setw(22) << record.name.substr(0, 21) << right << setw(8)
+            << record.games << setw(8) << record.wins << setw(8) << record.ties << setw(8) << fixed
+            << setprecision(1) << record.winRate() * 100.0 << "%" << setw(8) << record.bestRoll << "\n";
+    }
+}
+
+void printCareerRecord(ostream& out, const CareerStore& careers, const CareerRecord& record) {
+    out << BOLD << record.name << RESET << "\n";
+    out << "Games: " << record.games << "  Wins: " << record.wins << "  Ties: " << record.ties
+        << "  Win rate: " << fixed << setprecision(1) << record.winRate() * 100.0 << "%\n";
+    out << "Rolls: " << record.rolls << "  Average: " << setprecision(2) << record.averageRoll()
+        << "  Best: " << record.bestRoll << "\n";
+    out << "Faces:";
+    for (int face = 1; face <= MAX_DICE_SIDES; ++face) {
+        if (record.faces[face] > 0) out << " " << face << "x" << record.faces[face];
+    }
+    out << "\n";
+
+    auto rivals = careers.rivalsOf(record, 5);
+    if (rivals.empty()) return;
+    out << "\n" << BOLD << left << setw(22) << "Rival" << right << setw(8) << "Games" << setw(8) << "Won"
+        << setw(8) << "Lost" << setw(8) << "Tied" << RESET << "\n";
+    for (const auto& rival : rivals) {
+        out << left << setw(22) << rival.first.name.substr(0, 21) << right << setw(8) << rival.second.games
+            << setw(8) << rival.second.wins << setw(8) << rival.second.losses << setw(8) << rival.second.ties << "\n";
+    }
+}
+
+const uint32_t ROLL_EXPORT_MAGIC = 0x58524744;  // "DGRX" little-endian
+const uint32_t ROLL_CHUNK_MAGIC = 0x4B434744;   // "DGCK" little-endian
+const uint16_t ROLL_EXPORT_VERSION = 1;
+const size_t ROLL_EXPORT_HEADER_SIZE = 8;
+const size_t ROLL_CHUNK_FOOTER_SIZE = 80;
+const size_t ROLL_EXPORT_CHUNK = 65536;  // rolls per chunk
+
+struct RollRecord {
+    uint64_t game;
+    uint32_t round;
+    uint8_t player;
+    uint8_t face;
+    uint64_t timestamp;  // nanoseconds since the export was opened
+};
+
+// Summary written after each chunk's columns, so a reader can skip the
+// chunk without decoding it.
+struct RollChunkFooter {
+    uint32_t count = 0;
+    uint8_t playerBits = 0;
+    uint8_t minPlayer = 0, maxPlayer = 0;
+    uint8_t minFace = 0, maxFace = 0;
+    uint32_t minRound = 0, maxRound = 0;
+    uint32_t gameBytes = 0, roundBytes = 0, timeBytes = 0;
+    uint64_t minGame = 0, maxGame = 0;
+    uint64_t minTime = 0, maxTime = 0;
+    uint64_t checksum = 0;
+    uint32_t payloadSize = 0;
+
+    void encode(uint8_t* out) const {
+        memset(out, 0, ROLL_CHUNK_FOOTER_SIZE);
+        storeLE32(out, count);
+        out[4] = playerBits;
+        out[5] = minPlayer;
+        out[6] = maxPlayer;
+        out[7] = minFace;
+        out[8] = maxFace;
+        storeLE32(out + 12, minRound);
+        storeLE32(out + 16, maxRound);
+        storeLE32(out + 20, gameBytes);
+        storeLE32(out + 24, roundBytes);
+        storeLE32(out + 28, timeBytes);
+        storeLE64(out + 32, minGame);
+        storeLE64(out + 40, maxGame);
+        storeLE64(out + 48, minTime);
+        storeLE64(out + 56, maxTime);
+        storeLE64(out + 64, checksum);
+        storeLE32(out + 72, payloadSize);
+        storeLE32(out + 76, ROLL_CHUNK_MAGIC);
+    }
+
+    bool decode(const uint8_t* in) {
+        if (loadLE32(in + 76) != ROLL_CHUNK_MAGIC) return false;
+        count = loadLE32(in);
+        playerBits = in[4];
+        minPlayer = in[5];
+        maxPlayer = in[6];
+        minFace = in[7];
+        maxFace = in[8];
+        minRound = loadLE32(in + 12);
+        maxRound = loadLE32(in + 16);
+        gameBytes = loadLE32(in + 20);
+        roundBytes = loadLE32(in + 24);
+        timeBytes = loadLE32(in + 28);
+        minGame = loadLE64(in + 32);
+        maxGame = loadLE64(in + 40);
+        minTime = loadLE64(in + 48);
+        maxTime = loadLE64(in + 56);
+        checksum = loadLE64(in + 64);
+        payloadSize = loadLE32(in + 72);
+        return playerBits <= 8 && count <= ROLL_EXPORT_CHUNK;
+    }
+};
+
+// Decoded chunk, one vector per field; capacity is kept between chunks.
+struct RollColumns {
+    vector<uint64_t> games;
+    vector<uint32_t> rounds;
+    vector<uint8_t> players;
+    vector<uint8_t> faces;
+    vector<uint64_t> times;
+
+    size_t size() const { return faces.size(); }
+};
+
+inline uint64_t zigzagEncode(int64_t value) { return (uint64_t(value) << 1) ^ uint64_t(value >> 63); }
+inline int64_t zigzagDecode(uint64_t value) { return int64_t(value >> 1) ^ -int64_t(value & 1); }
+
+// Run-length encodes a column of ids as (delta from the previous run,
+// run length, repeat) triples, the repeat folding consecutive runs that
+// share both delta and length. A classic game is one run of its game id,
+// and its rounds 1..R of equal length collapse into a single triple.
+template <typename Value>
+void putIdRuns(SaveWriter& out, const RollRecord* rolls, size_t count, Value value) {
+    uint64_t previous = 0;
+    size_t i = 0;
+    while (i < count) {
+        uint64_t current = value(rolls[i]);
+        size_t length = 1;
+        while (i + length < count && value(rolls[i + length]) == current) length++;
+        int64_t delta = int64_t(current - previous);
+
+        // Fold following runs with the same delta and length into this one.
+        size_t repeat = 1, next = i + length;
+        while (next + length <= count) {
+            uint64_t expected = current + uint64_t(delta) * repeat;
+            bool same = true;
+            for (size_t k = 0; k < length && same; ++k) same = value(rolls[next + k]) == expected;
+            if (!same || (next + length < count && value(rolls[next + length]) == expected)) break;
+            repeat++;
+            next += length;
+        }
+
+        out.putVarint(zigzagEncode(delta));
+        out.putVarint(length);
+        out.putVarint(repeat);
+        previous = current + uint64_t(delta) * (repeat - 1);
+        i = next;
+    }
+}
+
+template <typename T>
+bool getIdRuns(SaveReader& in, size_t count, vector<T>& column) {
+    column.clear();
+    uint64_t previous = 0;
+    while (column.size() < count) {
+        uint64_t delta, length, repeat;
+        if (!in.getVarint(delta) || !in.getVarint(length) || !in.getVarint(repeat)) return false;
+        if (length == 0 || repeat == 0 || length > count - column.size() ||
+            repeat > (count - column.size()) / length) {
+            return false;
+        }
+        for (uint64_t r = 0; r < repeat; ++r) {
+            previous += uint64_t(zigzagDecode(delta));
+            column.insert(column.end(), length, static_cast<T>(previous));
+        }
+    }
+    return true;
+}
+
+// Encodes up to ROLL_EXPORT_CHUNK rolls as one chunk:
+//   u32 payload size | game runs | round runs | time runs | players | faces | footer
+// Players are bit-packed at the chunk's narrowest width and faces at four bits.
+void encodeRollChunk(const RollRecord* rolls, size_t count, SaveWriter& out) {
+    RollChunkFooter footer;
+    footer.count = static_cast<uint32_t>(count);
+    footer.minGame = footer.maxGame = rolls[0].game;
+    footer.minRound = footer.maxRound = rolls[0].round;
+    footer.minPlayer = footer.maxPlayer = rolls[0].player;
+    footer.minFace = footer.maxFace = rolls[0].face;
+    footer.minTime = footer.maxTime = rolls[0].timestamp;
+    for (size_t i = 1; i < count; ++i) {
+        const RollRecord& roll = rolls[i];
+        footer.minGame = min(footer.minGame, roll.game);
+        footer.maxGame = max(footer.maxGame, roll.game);
+        footer.minRound = min(footer.minRound, roll.round);
+        footer.maxRound = max(footer.maxRound, roll.round);
+        footer.minPlayer = min(footer.minPlayer, roll.player);
+        footer.maxPlayer = max(footer.maxPlayer, roll.player);
+        footer.minFace = min(footer.minFace, roll.face);
+        footer.maxFace = max(footer.maxFace, roll.face);
+        footer.minTime = min(footer.minTime, roll.timestamp);
+        footer.maxTime = max(footer.maxTime, roll.timestamp);
+    }
+    footer.playerBits = footer.maxPlayer == 0 ? 0 : static_cast<uint8_t>(highestBit64(footer.maxPlayer) + 1);
+
+    size_t start = out.size();
+    out.putU32(0);  // payload size, patched below
+    size_t payload = out.size();
+    putIdRuns(out, rolls, count, [](const RollRecord& roll) { return roll.game; });
+    footer.gameBytes = static_cast<uint32_t>(out.size() - payload);
+    putIdRuns(out, rolls, count, [](const RollRecord& roll) { return uint64_t(roll.round); });
+    footer.roundBytes = static_cast<uint32_t>(out.size() - payload - footer.gameBytes);
+    putIdRuns(out, rolls, count, [](const RollRecord& roll) { return roll.timestamp; });
+    footer.timeBytes = static_cast<uint32_t>(out.size() - payload - footer.gameBytes - footer.roundBytes);
+
+    vector<uint8_t>& bytes = out.bytes();
+    size_t players = bytes.size();
+    bytes.resize(players + (count * footer.playerBits + 7) / 8, 0);
+    for (size_t i = 0, bit = 0; footer.playerBits > 0 && i < count; ++i, bit += footer.playerBits) {
+        uint32_t packed = uint32_t(rolls[i].player) << (bit % 8);
+        bytes[players + bit / 8] |= static_cast<uint8_t>(packed);
+        if ((bit % 8) + footer.playerBits > 8) bytes[players + bit / 8 + 1] |= static_cast<uint8_t>(packed >> 8);
+    }
+    size_t faces = bytes.size();
+    bytes.resize(faces + (count + 1) / 2, 0);
+    for (size_t i = 0; i < count; ++i) {
+        bytes[faces + i / 2] |= static_cast<uint8_t>((rolls[i].face & 0x0F) << (4 * (i % 2)));
+    }
+
+    footer.payloadSize = static_cast<uint32_t>(bytes.size() - payload);
+    footer.checksum = fnv1a64(bytes.data() + payload, footer.payloadSize);
+    storeLE32(bytes.data() + start, footer.payloadSize);
+    bytes.resize(bytes.size() + ROLL_CHUNK_FOOTER_SIZE);
+    footer.encode(bytes.data() + bytes.size() - ROLL_CHUNK_FOOTER_SIZE);
+}
+
+bool decodeRollChunk(const uint8_t* payload, const RollChunkFooter& footer, RollColumns& columns) {
+    size_t count = footer.count;
+    size_t playerBytes = (count * footer.playerBits + 7) / 8, faceBytes = (count + 1) / 2;
+    if (uint64_t(footer.gameBytes) + footer.roundBytes + footer.timeBytes + playerBytes + faceBytes !=
+            footer.payloadSize ||
+        fnv1a64(payload, footer.payloadSize) != footer.checksum) {
+        return false;
+    }
+
+    SaveReader games(payload, footer.gameBytes);
+    SaveReader rounds(payload + footer.gameBytes, footer.roundBytes);
+    SaveReader times(payload + footer.gameBytes + footer.roundBytes, footer.timeBytes);
+    if (!getIdRuns(games, count, columns.games) || !getIdRuns(rounds, count, columns.rounds) ||
+        !getIdRuns(times, count, columns.times)) {
+        return false;
+    }
+
+    const uint8_t* packed = payload + footer.gameBytes + footer.roundBytes + footer.timeBytes;
+    columns.players.assign(count, 0);
+    uint32_t mask = (1u << footer.playerBits) - 1;
+    for (size_t i = 0, bit = 0; footer.playerBits > 0 && i < count; ++i, bit += footer.playerBits) {
+        uint32_t window = packed[bit / 8];
+        if ((bit % 8) + footer.playerBits > 8) window |= uint32_t(packed[bit / 8 + 1]) << 8;
+        columns.players[i] = static_cast<uint8_t>((window >> (bit % 8)) & mask);
+    }
+    packed += playerBytes;
+    columns.faces.resize(count);
+    for (size_t i = 0; i < count; ++i) columns.faces[i] = (packed[i / 2] >> (4 * (i % 2))) & 0x0F;
+    return true;
+}
+
+// Streams rolls to an export file: chunked columnar binary, or CSV when
+// the path ends in ".csv". append() buffers a chunk for a single writer;
+// write() takes whole batches from any thread and encodes them outside
+// the file lock.
+class RollExporter {
+private:
+    FILE* file;
+    bool csv;
+    bool failed;
+    mutex lock;
+    vector<RollRecord> pending;
+    uint64_t written;
+    chrono::steady_clock::time_point opened;
+
+    void emit(const uint8_t* data, size_t size) {
+        lock_guard<mutex> guard(lock);
+        if (fwrite(data, 1, size, file) != size) failed = true;
+    }
+
+public:
+    RollExporter() : file(nullptr), csv(false), failed(false), written(0) {}
+    RollExporter(const RollExporter&) = delete;
+    RollExporter& operator=(const RollExporter&) = delete;
+    ~RollExporter() { close(); }
+
+    bool open(const string& path) {
+        close();
+        file = fopen(path.c_str(), "wb");
+        if (!file) return false;
+        csv = path.size() >= 4 && path.compare(path.size() - 4, 4, ".csv") == 0;
+        failed = false;
+        written = 0;
+        opened = chrono::steady_clock::now();
+        if (csv) {
+            const char* header = "game,round,player,face,timestamp_ns\n";
+            emit(reinterpret_cast<const uint8_t*>(header), strlen(header));
+        } else {
+            uint8_t header[ROLL_EXPORT_HEADER_SIZE] = {};
+            storeLE32(header, ROLL_EXPORT_MAGIC);
+            storeLE16(header + 4, ROLL_EXPORT_VERSION);
+            emit(header, sizeof(header));
+        }
+        return !failed;
+    }
+
+    bool isOpen() const { return file != nullptr; }
+    uint64_t rollsWritten() const { return written; }
+
+    uint64_t elapsedNanos(chrono::steady_clock::time_point at = chrono::steady_clock::now()) const {
+        return static_cast<uint64_t>(chrono::duration_cast<chrono::nanoseconds>(at - opened).count());
+    }
+
+    void append(const RollRecord& roll) {
+        if (!file) return;
+        pending.push_back(roll);
+        if (pending.size() >= ROLL_EXPORT_CHUNK) flush();
+    }
+
+    void write(const RollRecord* rolls, size_t count) {
+        if (!file) return;
+        for (size_t first = 0; first < count; first += ROLL_EXPORT_CHUNK) {
+            size_t size = min(ROLL_EXPORT_CHUNK, count - first);
+            if (csv) {
+                string text;
+                for (size_t i = first; i < first + size; ++i) {
+                    const RollRecord& roll = rolls[i];
+                    text += to_string(roll.game) + ',' + to_string(roll.round) + ',' + to_string(roll.player) +
+                            ',' + to_string(roll.face) + ',' + to_string(roll.timestamp) + '\n';
+                }
+                emit(reinterpret_cast<const uint8_t*>(text.data()), text.size());
+            } else {
+                SaveWriter chunk;
+                encodeRollChunk(rolls + first, size, chunk);
+                emit(chunk.data(), chunk.size());
+            }
+        }
+        lock_guard<mutex> guard(lock);
+        written += count;
+    }
+
+    void flush() {
+        write(pending.data(), pending.size());
+        pending.clear();
+    }
+
+    bool close() {
+        if (!file) return !failed;
+        flush();
+        if (fclose(file) != 0) failed = true;
+        file = nullptr;
+        return !failed;
+    }
+};
+
+// Walks a binary export one chunk at a time. nextChunk() reads only the
+// footer; readColumns() then decodes that chunk if the caller wants it.
+// Memory use is one chunk regardless of file size.
+class RollExportReader {
+private:
+    FILE* file;
+    long next;
+    long payloadAt;
+    RollChunkFooter current;
+    vector<uint8_t> payload;
+
+public:
+    RollExportReader() : file(nullptr), next(0), payloadAt(0) {}
+    RollExportReader(const RollExportReader&) = delete;
+    RollExportReader& operator=(const RollExportReader&) = delete;
+    ~RollExportReader() { close(); }
+
+    bool open(const string& path) {
+        close();
+        file = fopen(path.c_str(), "rb");
+        uint8_t header[ROLL_EXPORT_HEADER_SIZE];
+        if (!file || fread(header, 1, sizeof(header), file) != sizeof(header) ||
+            loadLE32(header) != ROLL_EXPORT_MAGIC || loadLE16(header + 4) != ROLL_EXPORT_VERSION) {
+            close();
+            return false;
+        }
+        next = ROLL_EXPORT_HEADER_SIZE;
+        return true;
+    }
+
+    void close() {
+        if (file) fclose(file);
+        file = nullptr;
+    }
+
+    // False at the end of the file or at the first damaged chunk.
+    bool nextChunk(RollChunkFooter& footer) {
+        uint8_t size[4], trailer[ROLL_CHUNK_FOOTER_SIZE];
+        if (!file || fseek(file, next, SEEK_SET) != 0 || fread(size, 1, 4, file) != 4) return false;
+        payloadAt = next + 4;
+        if (fseek(file, long(loadLE32(size)), SEEK_CUR) != 0 ||
+            fread(trailer, 1, sizeof(trailer), file) != sizeof(trailer) || !current.decode(trailer) ||
+            current.payloadSize != loadLE32(size)) {
+            return false;
+        }
+        next = payloadAt + long(current.payloadSize) + long(ROLL_CHUNK_FOOTER_SIZE);
+        footer = current;
+        return true;
+    }
+
+    bool readColumns(RollColumns& columns) {
+        payload.resize(current.payloadSize);
+        return file && fseek(file, payloadAt, SEEK_SET) == 0 &&
+               fread(payload.data(), 1, payload.size(), file) == payload.size() &&
+               decodeRollChunk(payload.data(), current, columns);
+    }
+};
+
+struct RollExportSummary {
+    uint64_t rolls = 0;
+    uint64_t chunks = 0;
+    uint64_t skipped = 0;
+    uint64_t minGame = numeric_limits<uint64_t>::max();
+    uint64_t maxGame = 0;
+    uint64_t faces[16] = {};
+    vector<uint64_t> playerRolls;
+    vector<uint64_t> playerSums;
+    bool complete = true;  // false when a damaged chunk ended the scan early
+};
+
+// Aggregates every roll whose game id lies in [firstGame, lastGame],
+// skipping chunks whose footer range misses it.
+bool scanRollExport(const string& path, uint64_t firstGame, uint64_t lastGame, RollExportSummary& summary) {
+    RollExportReader reader;
+    if (!reader.open(path)) return false;
+    RollChunkFooter footer;
+    RollColumns columns;
+    while (reader.nextChunk(footer)) {
+        summary.chunks++;
+        if (footer.maxGame < firstGame || footer.minGame > lastGame) {
+            summary.skipped++;
+            continue;
+        }
+        if (!reader.readColumns(columns)) {
+            summary.complete = false;
+            return true;
+        }
+        if (summary.playerRolls.size() <= footer.maxPlayer) {
+            summary.playerRolls.resize(footer.maxPlayer + 1);
+            summary.playerSums.resize(footer.maxPlayer + 1);
+        }
+        bool whole = footer.minGame >= firstGame && footer.maxGame <= lastGame;
+        for (size_t i = 0; i < columns.size(); ++i) {
+            uint64_t game = columns.games[i];
+            if (!whole && (game < firstGame || game > lastGame)) continue;
+            summary.minGame = min(summary.minGame, game);
+            summary.maxGame = max(summary.maxGame, game);
+            summary.faces[columns.faces[i]]++;
+            summary.playerRolls[columns.players[i]]++;
+            summary.playerSums[columns.players[i]] += columns.faces[i];
+            summary.rolls++;
+        }
+    }
+    return true;
+}
+
+void printRollExportSummary(const string& path, const RollExportSummary& summary, double seconds) {
+    cout << BOLD << "Roll export: " << path << RESET << "\n";
+    cout << "Chunks: " << summary.chunks << " (" << summary.skipped << " skipped by footer)\n";
+    cout << "Rolls:  " << summary.rolls;
+    if (summary.rolls > 0) cout << " from games " << summary.minGame << "-" << summary.maxGame;
+    cout << "\n";
+    if (!summary.complete) cout << RED << "Stopped at a damaged chunk; totals are partial." << RESET << "\n";
+    if (summary.rolls == 0) return;
+
+    cout << "\n" << BOLD << left << setw(8) << "Face" << right << setw(14) << "Rolls" << setw(10) << "Share"
+         << RESET << "\n";
+    for (int face = 0; face < 16; ++face) {
+        if (summary.faces[face] == 0) continue;
+        cout << left << setw(8) << face << right << setw(14) << summary.faces[face] << setw(9) << fixed
+             << setprecision(3) << 100.0 * summary.faces[face] / summary.rolls << "%\n";
+    }
+    cout << "\n" << BOLD << left << setw(8) << "Seat" << right << setw(14) << "Rolls" << setw(10) << "Mean"
+         << RESET << "\n";
+    for (size_t seat = 0; seat < summary.playerRolls.size(); ++seat) {
+        if (summary.playerRolls[seat] == 0) continue;
+        cout << left << setw(8) << seat + 1 << right << setw(14) << summary.playerRolls[seat] << setw(10)
+             << setprecision(4) << double(summary.playerSums[seat]) / summary.playerRolls[seat] << "\n";
+    }
+    if (seconds > 0) {
+        cout << "\nScanned in " << setprecision(2) << seconds << " s ("
+             << setprecision(1) << summary.rolls / seconds / 1e6 << " M rolls/s)\n";
+    }
+}
+
+enum class RollEventType : uint8_t { Roll, RoundEnd };
+
+struct RollEvent {
+    RollEventType type;
+    uint8_t player;  // seat that rolled, or the round winner (JOURNAL_NO_WINNER on a tie)
+    uint16_t value;  // face rolled
+    uint32_t round;
+    uint64_t game;
+    chrono::steady_clock::time_point at;
+};
+
+// Bounded single-producer broadcast ring in the style of the LMAX
+// Disruptor: every consumer reads every event through its own cursor, and
+// the producer only stalls once the slowest consumer is a whole ring
+// behind. The producer caches that gate and rechecks the cursors at most
+// once per ring of events, so publishing costs the same however many
+// consumers are attached. Both sides spin briefly and then sleep on a
+// condition variable; the sleeper counts keep locks off the busy path.
+template <typename Event>
+class BroadcastRing {
+public:
+    struct alignas(64) Cursor {
+        atomic<uint64_t> next{0};  // first sequence not yet handled
+    };
+
+private:
+    vector<Event> slots;
+    uint64_t mask;
+    alignas(64) atomic<uint64_t> published;
+    uint64_t gate;  // producer's cached view of the slowest cursor
+    vector<unique_ptr<Cursor>> cursors;
+    atomic<bool> closed;
+    mutex lock;
+    condition_variable consumerWake, producerWake;
+    atomic<int> sleepingConsumers, sleepingProducers;
+
+    uint64_t slowest() const {
+        uint64_t low = published.load();
+        for (const auto& cursor : cursors) low = min(low, cursor->next.load());
+        return low;
+    }
+
+    // The seq_cst sleeper count and the seq_cst cursor stores order each
+    // other, so a waker either sees the sleeper or the sleeper sees the
+    // new sequence before it waits.
+    template <typename Ready>
+    void await(Ready ready, condition_variable& wake, atomic<int>& sleepers) {
+        for (int spin = 0; spin < 64; ++spin) {
+            if (ready()) return;
+            this_thread::yield();
+        }
+        unique_lock<mutex> guard(lock);
+        sleepers.fetch_add(1);
+        wake.wait(guard, ready);
+        sleepers.fetch_sub(1);
+    }
+
+    void wakeAll(condition_variable& wake, atomic<int>& sleepers) {
+        if (sleepers.load() == 0) return;
+        lock_guard<mutex> guard(lock);
+        wake.notify_all();
+    }
+
+public:
+    explicit BroadcastRing(size_t capacity)
+        : published(0), gate(0), closed(false), sleepingConsumers(0), sleepingProducers(0) {
+        size_t size = 1;
+        while (size < capacity) size <<= 1;
+        slots.resize(size);
+        mask = size - 1;
+    }
+
+    // Registers a consumer starting at the next event. Call from the
+    // producer thread; the cursor stays valid for the ring's lifetime.
+    Cursor& addConsumer() {
+        cursors.emplace_back(new Cursor());
+        cursors.back()->next.store(published.load());
+        return *cursors.back();
+    }
+
+    void publish(const Event& event) {
+        uint64_t sequence = published.load(memory_order_relaxed);
+        if (sequence - gate >= slots.size()) {
+            await([&]() {
+                gate = slowest();
+                return sequence - gate < slots.size();
+            }, producerWake, sleepingProducers);
+        }
+        slots[sequence & mask] = event;
+        published.store(sequence + 1);
+        wakeAll(consumerWake, sleepingConsumers);
+    }
+
+    // Blocks until every consumer has handled everything published so far.
+    void drain() {
+        uint64_t target = published.load(memory_order_relaxed);
+        await([&]() { return slowest() >= target; }, producerWake, sleepingProducers);
+    }
+
+    // Waits for events and passes everything available to
+    // handle(events, count) as at most two contiguous batches. Returns
+    // false once the ring is closed and this consumer has caught up.
+    template <typename Handle>
+    bool consume(Cursor& cursor, Handle&& handle) {
+        uint64_t from = cursor.next.load(memory_order_relaxed), to = from;
+        await([&]() {
+            to = published.load();
+            return to > from || closed.load();
+        }, consumerWake, sleepingConsumers);
+        if (to == from) return false;
+        while (from < to) {
+            size_t start = static_cast<size_t>(from & mask);
+            size_t count = static_cast<size_t>(min<uint64_t>(to - from, slots.size() - start));
+            handle(&slots[start], count);
+            from += count;
+        }
+        cursor.next.store(to);
+        wakeAll(producerWake, sleepingProducers);
+        return true;
+    }
+
+    void close() {
+        closed.store(true);
+        lock_guard<mutex> guard(lock);
+        consumerWake.notify_all();
+    }
+};
+
+// Fans roll events out to consumers that each run on their own thread, so
+// journaling, export and metrics never hold up the next roll.
+class RollEventBus {
+private:
+    BroadcastRing<RollEvent> ring;
+    vector<thread> workers;
+
+public:
+    explicit RollEventBus(size_t capacity = 4096) : ring(capacity) {}
+    RollEventBus(const RollEventBus&) = delete;
+    RollEventBus& operator=(const RollEventBus&) = delete;
+    ~RollEventBus() { stop(); }
+
+    // Attaches handler(events, count); call before the first publish.
+    void subscribe(function<void(const RollEvent*, size_t)> handler) {
+        BroadcastRing<RollEvent>::Cursor& cursor = ring.addConsumer();
+        workers.emplace_back([this, &cursor, handler]() {
+            while (ring.consume(cursor, handler)) {}
+        });
+    }
+
+    void publish(const RollEvent& event) { ring.publish(event); }
+    void drain() { ring.drain(); }
+
+    // Lets the consumers finish what was published, then joins them.
+    void stop() {
+        if (workers.empty()) return;
+        ring.close();
+        for (auto& worker : workers) worker.join();
+        workers.clear();
+    }
+};
+
+uint64_t randomSeed() {
+    random_device device;
+    return (uint64_t(device()) << 32) | device();
+}
+
+// std::streambuf that appends into a string whose capacity survives clear().
+class FrameBuffer : public streambuf {
+private:
+    string text;
+
+protected:
+    int_type overflow(int_type ch) override {
+        if (ch != traits_type::eof()) text.push_back(static_cast<char>(ch));
+        return ch;
+    }
+    streamsize xsputn(const char* data, streamsize count) override {
+        text.append(data, static_cast<size_t>(count));
+        return count;
+    }
+
+public:
+    const string& str() const { return text; }
+    void clear() { text.clear(); }
+    size_t capacity() const { return text.capacity(); }
+    void reserve(size_t size) { text.reserve(size); }
+};
+
+volatile sig_atomic_t terminalResized = 1;
+
+#if defined(__unix__) || defined(__APPLE__)
+extern "C" void onTerminalResize(int) { terminalResized = 1; }
+#endif
+
+// Off-screen frame renderer. Everything the game prints goes into a frame
+// buffer; present() then sends only the lines that differ from what is on
+// screen, positioned with ANSI cursor moves, in a single write. When stdout
+// is not a terminal, or in plain mode, frames are streamed instead, and
+// plain mode also drops colors and box drawing for log-friendly output.
+class TerminalRenderer {
+private:
+    FrameBuffer buffer;
+    ostream frame;
+    vector<string> screen;   // lines currently shown, in diff mode
+    string output;
+    string style, line;      // diff scratch: SGR attributes at the start of a line, and the line
+    size_t streamed;         // bytes of the frame already sent, in stream mode
+    bool diffMode;
+    bool plain;
+    bool cleared;
+    int rows;
+    ostream* sink;
+
+    void writeAll(const string& bytes) {
+        countMetric(Counter::FrameBytes, bytes.size());
+        if (sink) {
+            sink->write(bytes.data(), static_cast<streamsize>(bytes.size()));
+            return;
+        }
+#if defined(__unix__) || defined(__APPLE__)
+        size_t sent = 0;
+        while (sent < bytes.size()) {
+            ssize_t n = ::write(STDOUT_FILENO, bytes.data() + sent, bytes.size() - sent);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                return;
+            }
+            sent += static_cast<size_t>(n);
+        }
+#else
+        fwrite(bytes.data(), 1, bytes.size(), stdout);
+        fflush(stdout);
+#endif
+    }
+
+    void refreshSize() {
+        if (!terminalResized) return;
+        terminalResized = 0;
+        rows = 24;
+#if defined(__unix__) || defined(__APPLE__)
+        struct winsize size;
+        if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) == 0 && size.ws_row > 0) rows = size.ws_row;
+#endif
+    }
+
+    void appendPlain(const char* data, size_t size) {
+        static const pair<const char*, const char*> BOX_GLYPHS[] = {
+            {"┌", "+"}, {"┐", "+"}, {"└", "+"}, {"┘", "+"}, {"├", "+"}, {"┤", "+"},
+            {"┬", "+"}, {"┴", "+"}, {"┼", "+"}, {"─", "-"}, {"│", "|"}, {"●", "o"}
+        };
+        for (size_t i = 0; i < size;) {
+            if (data[i] == '\033' && i + 1 < size && data[i + 1] == '[') {
+                i += 2;
+                while (i < size && !isalpha(static_cast<unsigned char>(data[i]))) i++;
+                i++;
+                continue;
+            }
+            bool replaced = false;
+            if (static_cast<unsigned char>(data[i]) == 0xE2) {
+                for (const auto& glyph : BOX_GLYPHS) {
+                    size_t length = strlen(glyph.first);
+                    if (i + length <= size && memcmp(data + i, glyph.first, length) == 0) {
+                        output += glyph.second;
+                        i += length;
+                        replaced = true;
+                        break;
+                    }
+                }
+            }
+            if (!replaced) output += data[i++];
+        }
+    }
+
+    // Replays the SGR escapes in text[begin, end) onto style.
+    static void trackStyle(const string& text, size_t begin, size_t end, string& style) {
+        for (size_t i = text.find("\033[", begin); i < end; i = text.find("\033[", i + 1)) {
+            size_t stop = text.find('m', i);
+            if (stop >= end) break;
+            if (stop == i + 3 && text[i + 2] == '0') {
+                style.clear();
+            } else {
+                style.append(text, i, stop - i + 1);
+            }
+        }
+    }
+
+    void presentStream() {
+        const string& text = buffer.str();
+        if (streamed >= text.size()) return;
+        output.clear();
+        if (plain) {
+            appendPlain(text.data() + streamed, text.size() - streamed);
+        } else {
+            output.append(text, streamed, string::npos);
+        }
+        streamed = text.size();
+        writeAll(output);
+    }
+
+    void presentDiff() {
+        refreshSize();
+        const string& text = buffer.str();
+        output.clear();
+
+        size_t lineCount = static_cast<size_t>(count(text.begin(), text.end(), '\n')) + 1;
+        bool fullRedraw = !cleared || lineCount > static_cast<size_t>(rows);
+        if (fullRedraw) {
+            // Too tall to address by row: let the terminal scroll.
+            output += "\033[H\033[2J";
+            output += text;
+            screen.clear();
+            cleared = lineCount <= static_cast<size_t>(rows);
+        } else {
+            size_t start = 0, row = 0;
+            style.clear();
+            while (true) {
+                size_t end = text.find('\n', start);
+                bool last = end == string::npos;
+                size_t length = (last ? text.size() : end) - start;
+                line.assign(style);
+                line.append(text, start, length);
+                // The cursor line is always rewritten so the cursor ends up after it.
+                if (last || row >= screen.size() || screen[row] != line) {
+                    char cursor[32];
+                    int written = snprintf(cursor, sizeof(cursor), "\033[%zu;1H\033[0m", row + 1);
+                    output.append(cursor, static_cast<size_t>(written));
+                    output += line;
+                    output += last ? "\033[J" : "\033[K";
+                    if (row < screen.size()) screen[row] = line;
+                    else screen.push_back(line);
+                }
+                trackStyle(text, start, start + length, style);
+                if (last) break;
+                start = end + 1;
+                row++;
+            }
+            screen.resize(row);  // the cursor line may get input echoed into it
+        }
+        writeAll(output);
+    }
+
+public:
+    TerminalRenderer() : frame(&buffer), streamed(0), plain(false), cleared(false), rows(24), sink(nullptr) {
+#if defined(__unix__) || defined(__APPLE__)
+        diffMode = isatty(STDOUT_FILENO) != 0;
+        if (diffMode) signal(SIGWINCH, onTerminalResize);
+#else
+        diffMode = false;
+#endif
+    }
+
+    ~TerminalRenderer() {
+        present();
+        if (diffMode) writeAll("\n");
+    }
+
+    void setPlain(bool enabled) {
+        plain = enabled;
+        if (plain) diffMode = false;
+    }
+
+    // Sends frames to a stream instead of the terminal, e.g. a transcript.
+    void setSink(ostream* output) {
+        sink = output;
+        if (sink) diffMode = false;
+    }
+
+    bool isPlain() const { return plain; }
+    ostream& stream() { return frame; }
+
+    void beginFrame() {
+        // Keep room for half as much again as the last frame, so frames that
+        // grow a little from round to round, as scores widen, reuse their
+        // buffers instead of reallocating.
+        size_t size = buffer.str().size();
+        if (buffer.capacity() < size + size / 2) buffer.reserve(2 * size);
+        if (output.capacity() < size + size / 2) output.reserve(2 * size);
+        if (!diffMode) {
+            presentStream();
+            if (streamed > 0) writeAll("\n");
+            streamed = 0;
+        }
+        buffer.clear();
+    }
+
+    void present() {
+        ScopedTimer timer(Metric::RenderPresent);
+        frame.flush();
+        if (diffMode) {
+            presentDiff();
+        } else {
+            presentStream();
+        }
+    }
+};
+
+// Hashed timer wheel with 10 ms ticks. Timers further out than one turn of
+// the wheel stay in their slot until their deadline tick comes around.
+class TimerWheel {
+private:
+    static const size_t SLOTS = 256;
+    static constexpr chrono::milliseconds TICK{10};
+
+    struct Timer {
+        uint64_t id;
+        uint64_t deadline;
+        function<void()> callback;
+    };
+
+    vector<vector<Timer>> slots;
+    vector<Timer> due;
+    chrono::steady_clock::time_point origin;
+    uint64_t currentTick;
+    uint64_t nextId;
+    size_t pending;
+
+    uint64_t tickAt(chrono::steady_clock::time_point time) const {
+        return static_cast<uint64_t>((time - origin) / TICK);
+    }
+
+public:
+    TimerWheel() : slots(SLOTS), origin(chrono::steady_clock::now()), currentTick(0), nextId(1), pending(0) {}
+
+    uint64_t schedule(chrono::milliseconds delay, function<void()> callback) {
+        uint64_t deadline = tickAt(chrono::steady_clock::now() + delay);
+        // Round up so a timer never fires before its delay has passed.
+        if (origin + deadline * TICK < chrono::steady_clock::now() + delay) deadline++;
+        deadline = max(deadline, currentTick + 1);
+        slots[deadline % SLOTS].push_back(Timer{nextId, deadline, move(callback)});
+        pending++;
+        return nextId++;
+    }
+
+    void cancelAll() {
+        for (auto& slot : slots) slot.clear();
+        pending = 0;
+    }
+
+    bool empty() const { return pending == 0; }
+
+    // Milliseconds until the next tick that has a timer due, or -1 if none.
+    // Rounded up: a wait cut short by truncation would wake before the tick
+    // and spin until it arrives.
+    int millisecondsUntilNext() const {
+        if (pending == 0) return -1;
+        for (uint64_t tick = currentTick + 1; tick <= currentTick + SLOTS; ++tick) {
+            for (const auto& timer : slots[tick % SLOTS]) {
+                if (timer.deadline == tick) {
+                    auto wait = origin + tick * TICK - chrono::steady_clock::now();
+                    return static_cast<int>(max<int64_t>(0, chrono::ceil<chrono::milliseconds>(wait).count()));
+                }
+            }
+        }
+        return static_cast<int>(SLOTS * TICK.count());
+    }
+
+    void advance() {
+        uint64_t now = tickAt(chrono::steady_clock::now());
+        while (currentTick < now) {
+            currentTick++;
+            auto& slot = slots[currentTick % SLOTS];
+            for (size_t i = 0; i < slot.size();) {
+                if (slot[i].deadline <= currentTick) {
+                    due.push_back(move(slot[i]));
+                    slot[i] = move(slot.back());
+                    slot.pop_back();
+                    pending--;
+                } else {
+                    ++i;
+                }
+            }
+            sort(due.begin(), due.end(), [](const Timer& a, const Timer& b) { return a.id < b.id; });
+            for (auto& timer : due) timer.callback();
+            due.clear();
+        }
+    }
+};
+
+constexpr chrono::milliseconds TimerWheel::TICK;
+
+// Puts a terminal stdin into unbuffered, no-echo mode for its lifetime so
+// single keypresses can be picked up while timers are running.
+class RawKeyboard {
+private:
+#if defined(__unix__) || defined(__APPLE__)
+    termios saved;
+#endif
+    bool active;
+
+public:
+    RawKeyboard() : active(false) {
+#if defined(__unix__) || defined(__APPLE__)
+        if (isatty(STDIN_FILENO) && tcgetattr(STDIN_FILENO, &saved) == 0) {
+            termios raw = saved;
+            raw.c_lflag &= ~(ICANON | ECHO);
+            raw.c_cc[VMIN] = 0;
+            raw.c_cc[VTIME] = 0;
+            active = tcsetattr(STDIN_FILENO, TCSANOW, &raw) == 0;
+        }
+#endif
+    }
+
+    ~RawKeyboard() {
+#if defined(__unix__) || defined(__APPLE__)
+        if (active) tcsetattr(STDIN_FILENO, TCSANOW, &saved);
+#endif
+    }
+
+    bool isActive() const { return active; }
+};
+
+// Single-threaded loop multiplexing timers with terminal input. Animation
+// frames are timers; a keypress while they are pending ends the wait early.
+class EventLoop {
+private:
+    TimerWheel timers;
+    bool interactiveInput;
+
+    // Waits up to timeoutMs (-1 = forever) for stdin; true if readable.
+    bool pollInput(int timeoutMs) {
+#if defined(__unix__) || defined(__APPLE__)
+        pollfd input{STDIN_FILENO, POLLIN, 0};
+        int ready = poll(&input, 1, timeoutMs);
+        return ready > 0;
+#else
+        if (timeoutMs > 0) this_thread::sleep_for(chrono::milliseconds(timeoutMs));
+        return false;
+#endif
+    }
+
+public:
+    EventLoop() {
+#if defined(__unix__) || defined(__APPLE__)
+        interactiveInput = isatty(STDIN_FILENO) != 0;
+#else
+        interactiveInput = false;
+#endif
+    }
+
+    uint64_t schedule(chrono::milliseconds delay, function<void()> callback) {
+        return timers.schedule(delay, move(callback));
+    }
+
+    void cancelAll() { timers.cancelAll(); }
+
+    void setInteractiveInput(bool enabled) { interactiveInput = interactiveInput && enabled; }
+
+    // Runs pending timers until they are all done. Returns false if a key
+    // was pressed first; the remaining timers are then left for the caller.
+    bool runTimers() {
+        RawKeyboard keyboard;
+        while (true) {
+            timers.advance();
+            if (timers.empty()) return true;
+            int timeout = timers.millisecondsUntilNext();
+            if (keyboard.isActive()) {
+#if defined(__unix__) || defined(__APPLE__)
+                if (pollInput(timeout)) {
+                    char key;
+                    while (::read(STDIN_FILENO, &key, 1) == 1) {}
+                    return false;
+                }
+#endif
+            } else if (timeout > 0) {
+                this_thread::sleep_for(chrono::milliseconds(timeout));
+            }
+        }
+    }
+
+    // Keeps servicing timers until a line of input is ready to be read.
+    void waitForInput() {
+        if (!interactiveInput) return;
+        while (true) {
+            timers.advance();
+            if (pollInput(timers.millisecondsUntilNext())) return;
+        }
+    }
+};
+
+struct AnimationStep {
+    string_view text;
+    chrono::milliseconds hold;
+};
+
+const string TRACE_HEADER = "DICETRACE 1";
+
+// Recorded session: the engine and seed, every byte of input the game read
+// and every die value it drew, in order. Replaying feeds the input back and
+// checks each draw against the recording.
+class SessionTrace {
+private:
+    ofstream recording;
+    string pendingInput;
+    string replayInput;
+    vector<int> draws;
+    size_t nextDraw;
+    size_t firstMismatch;
+    uint64_t mismatches;
+
+    static string escape(const string& text) {
+        string escaped;
+        for (char c : text) {
+            if (c == '\\') escaped += "\\\\";
+            else if (c == '\n') escaped += "\\n";
+            else if (c == '\r') escaped += "\\r";
+            else if (c == '\t') escaped += "\\t";
+            else escaped += c;
+        }
+        return escaped;
+    }
+
+    static string unescape(const string& text) {
+        string plain;
+        for (size_t i = 0; i < text.size(); ++i) {
+            if (text[i] != '\\' || i + 1 == text.size()) {
+                plain += text[i];
+                continue;
+            }
+            char c = text[++i];
+            plain += c == 'n' ? '\n' : c == 'r' ? '\r' : c == 't' ? '\t' : c;
+        }
+        return plain;
+    }
+
+    void flushInput() {
+        if (pendingInput.empty()) return;
+        recording << "input " << escape(pendingInput) << "\n";
+        pendingInput.clear();
+    }
+
+public:
+    SessionTrace() : nextDraw(0), firstMismatch(0), mismatches(0) {}
+
+    ~SessionTrace() {
+        if (recording.is_open()) flushInput();
+    }
+
+    bool startRecording(const string& path, RngEngine engine, uint64_t seed, const RuleSet& rules) {
+        recording.open(path, ios::trunc);
+        if (!recording) return false;
+        recording << TRACE_HEADER << "\nengine " << rngEngineName(engine) << "\nseed " << seed
+                  << "\nrules " << formatRuleSpec(rules) << "\n";
+        return true;
+    }
+
+    // Traces recorded before rules were configurable replay with plain ones.
+    // A line that does not parse fails the load rather than replaying a
+    // different game.
+    bool load(const string& path, RngEngine& engine, uint64_t& seed, RuleSet& rules) {
+        ifstream trace(path);
+        string line;
+        if (!getline(trace, line) || line != TRACE_HEADER) return false;
+        bool hasEngine = false, hasSeed = false;
+        rules = RuleSet();
+        while (getline(trace, line)) {
+            size_t space = line.find(' ');
+            string key = line.substr(0, space);
+            string value = space == string::npos ? "" : line.substr(space + 1);
+            long long draw = 0;
+            if (key == "engine") {
+                if (!parseRngEngine(value, engine)) return false;
+                hasEngine = true;
+            } else if (key == "seed") {
+                if (!parseNumber(value.c_str(), seed)) return false;
+                hasSeed = true;
+            } else if (key == "rules") {
+                if (!parseRuleSpec(value, rules)) return false;
+            } else if (key == "input") {
+                replayInput += unescape(value);
+            } else if (key == "draw") {
+                if (!parseNumber(value.c_str(), 1, MAX_PACKED_ROLL, draw)) return false;
+                draws.push_back(static_cast<int>(draw));
+            } else {
+                return false;
+            }
+        }
+        return hasEngine && hasSeed;
+    }
+
+    const string& getReplayInput() const { return replayInput; }
+    size_t getDrawCount() const { return nextDraw; }
+    uint64_t getMismatches() const { return mismatches; }
+    size_t getFirstMismatch() const { return firstMismatch; }
+    bool drawsExhausted() const { return nextDraw == draws.size(); }
+
+    void recordInput(char c) {
+        pendingInput += c;
+        if (c == '\n') flushInput();
+    }
+
+    void onDraw(int value) {
+        if (recording.is_open()) {
+            flushInput();
+            recording << "draw " << value << "\n";
+            return;
+        }
+        if (nextDraw >= draws.size() || draws[nextDraw] != value) {
+            if (mismatches++ == 0) firstMismatch = nextDraw;
+        }
+        nextDraw++;
+    }
+};
+
+// Passes input through from another stream buffer while copying every
+// consumed byte into a trace.
+class RecordingStreambuf : public streambuf {
+private:
+    streambuf* source;
+    SessionTrace& trace;
+    char current;
+
+protected:
+    int_type underflow() override {
+        int_type c = source->sbumpc();
+        if (c == traits_type::eof()) return c;
+        current = traits_type::to_char_type(c);
+        trace.recordInput(current);
+        setg(&current, &current, &current + 1);
+        return c;
+    }
+
+public:
+    RecordingStreambuf(streambuf* input, SessionTrace& sessionTrace) : source(input), trace(sessionTrace) {}
+};
+
+struct GameOptions {
+    RngEngine rngEngine = RngEngine::Mt19937;
+    int journalSyncInterval = 16;
+    int compactInterval = 20;
+    bool plainOutput = false;
+    double animationSpeed = 1.0;  // 0 disables animations
+    bool hasSeed = false;
+    uint64_t seed = 0;
+    istream* input = &cin;
+    ostream* output = nullptr;    // renderer sink, stdout when null
+    SessionTrace* trace = nullptr;
+    bool reproducible = false;    // no autosave, recovery prompt or timing output
+    RollExporter* exporter = nullptr;  // receives every roll when set
+    RuleSet rules = houseRules();      // scoring for new games; setup picks the mode
+};
+
+// One seat's standing after a round, and the roll it made in that round.
+struct TimelineEntry {
+    int score;
+    int wins;
+    int roll;    // 0 for the root, which no round produced, and for a seat that is out
+    bool alive;  // still in an Elimination game
+};
+
+// A completed round in a game's timeline. Nodes are immutable once written
+// and only point at their parent, so a snapshot costs one node per round
+// however long the history, and every branch shares the rounds before its
+// fork.
+struct TimelineNode {
+    const TimelineNode* parent;  // null for the root
+    int round;                   // rounds completed at this point
+    int winner;                  // seat that took the round, -1 on a tie; at the root, the previous round's
+    TimelineEntry* entries;      // one per seat
+    RollSnapshot* rolls;         // one per seat, or null in a timeline that keeps no rolls
+};
+
+// Arena of timeline nodes for a fixed number of seats, plus the game's
+// current head. Nodes live until clear() or start(), which keep the blocks
+// for reuse, so appending after reserve() never allocates. Nodes from
+// another timeline may be used as parents while that timeline outlives
+// them; that is how the what-if runner forks thousands of branches off a
+// single base game.
+//
+// A timeline that keeps rolls snapshots every seat's roll history with each
+// node. The snapshot shares the history's sealed chunks, so it costs a
+// reference, and restoring a node relinks those chunks and appends the few
+// rolls made since they were sealed, which the path to the node holds.
+class GameTimeline {
+private:
+    struct Block {
+        unique_ptr<TimelineNode[]> nodes;
+        unique_ptr<TimelineEntry[]> entries;
+        unique_ptr<RollSnapshot[]> rolls;
+        size_t capacity;
+    };
+
+    static constexpr size_t MIN_BLOCK_NODES = 64;
+
+    size_t seats;
+    bool keepRolls;
+    vector<Block> blocks;
+    size_t block;              // block being filled
+    size_t used;               // nodes taken from it
+    const TimelineNode* head;
+    vector<const TimelineNode*> branches;  // heads left behind by rewinds
+
+    size_t available() const {
+        size_t room = block < blocks.size() ? blocks[block].capacity - used : 0;
+        for (size_t b = block + 1; b < blocks.size(); ++b) room += blocks[b].capacity;
+        return room;
+    }
+
+    // Lets go of the history chunks the written nodes hold.
+    void releaseRolls() {
+        if (!keepRolls) return;
+        for (size_t b = 0; b <= block && b < blocks.size(); ++b) {
+            size_t nodes = b < block ? blocks[b].capacity : used;
+            for (size_t i = 0; i < nodes * seats; ++i) releaseChunks(blocks[b].rolls[i].chunks);
+        }
+    }
+
+public:
+    explicit GameTimeline(size_t seatCount = 0, bool keepPlayerRolls = false)
+        : seats(seatCount), keepRolls(keepPlayerRolls), block(0), used(0), head(nullptr) {}
+
+    GameTimeline(const GameTimeline&) = delete;
+    GameTimeline& operator=(const GameTimeline&) = delete;
+
+    ~GameTimeline() { releaseRolls(); }
+
+    // Drops every node but keeps the blocks, unless the seat count changes.
+    void clear(size_t seatCount) {
+        releaseRolls();
+        if (seatCount != seats) blocks.clear();
+        seats = seatCount;
+        block = 0;
+        used = 0;
+        head = nullptr;
+        branches.clear();
+    }
+
+    void clear() { clear(seats); }
+
+    // Makes room for count more nodes in one block.
+    void reserve(size_t count) {
+        if (available() >= count) return;
+        size_t capacity = max(count, MIN_BLOCK_NODES);
+        size_t slots = capacity * max<size_t>(seats, 1);
+        blocks.push_back({unique_ptr<TimelineNode[]>(new TimelineNode[capacity]),
+                          unique_ptr<TimelineEntry[]>(new TimelineEntry[slots]),
+                          unique_ptr<RollSnapshot[]>(keepRolls ? new RollSnapshot[slots] : nullptr), capacity});
+    }
+
+    // A node after parent, with its entries left for the caller to fill.
+    TimelineNode* extend(const TimelineNode* parent, int winner) {
+        while (block < blocks.size() && used == blocks[block].capacity) {
+            block++;
+            used = 0;
+        }
+        if (block == blocks.size()) reserve(blocks.empty() ? MIN_BLOCK_NODES : 2 * blocks.back().capacity);
+        Block& current = blocks[block];
+        TimelineNode* node = &current.nodes[used];
+        node->parent = parent;
+        node->round = parent ? parent->round + 1 : 0;
+        node->winner = winner;
+        node->entries = &current.entries[used * seats];
+        node->rolls = keepRolls ? &current.rolls[used * seats] : nullptr;
+        used++;
+        return node;
+    }
+
+    // Roots the timeline at the players' current state. The root snapshots
+    // every roll so far, so restoring never reads past it.
+    void start(const vector<Player>& players, int completedRounds, const RuleState& state) {
+        clear(players.size());
+        TimelineNode* root = extend(nullptr, state.lastWinner);
+        root->round = completedRounds;
+        for (size_t i = 0; i < seats; ++i) {
+            root->entries[i] = {players[i].getScore(), players[i].getWins(), 0, state.alive[i] != 0};
+            if (keepRolls) root->rolls[i] = players[i].snapshotRolls(true);
+        }
+        head = root;
+    }
+
+    bool started() const { return head != nullptr; }
+    size_t getSeats() const { return seats; }
+    const TimelineNode* getHead() const { return head; }
+    const TimelineNode* getRoot() const {
+        const TimelineNode* node = head;
+        while (node && node->parent) node = node->parent;
+        return node;
+    }
+    const vector<const TimelineNode*>& getBranches() const { return branches; }
+
+    void record(const vector<Player>& players, const vector<int>& rolls, int winner, const RuleState& state) {
+        TimelineNode* node = extend(head, winner);
+        for (size_t i = 0; i < seats; ++i) {
+            node->entries[i] = {players[i].getScore(), players[i].getWins(), rolls[i], state.alive[i] != 0};
+            if (keepRolls) node->rolls[i] = players[i].snapshotRolls();
+        }
+        head = node;
+    }
+
+    // The rules state a game had at node.
+    void restoreState(const TimelineNode* node, RuleState& state) const {
+        state.alive.resize(seats);
+        state.aliveCount = 0;
+        for (size_t i = 0; i < seats; ++i) {
+            state.alive[i] = node->entries[i].alive;
+            state.aliveCount += node->entries[i].alive;
+        }
+        state.lastWinner = node->winner;
+    }
+
+    // Seat with the single highest score at node, or -1 on a tie.
+    int leader(const TimelineNode* node) const {
+        int best = -1, bestScore = numeric_limits<int>::min();
+        for (size_t i = 0; i < seats; ++i) {
+            if (node->entries[i].score > bestScore) {
+                bestScore = node->entries[i].score;
+                best = static_cast<int>(i);
+            } else if (node->entries[i].score == bestScore) {
+                best = -1;
+            }
+        }
+        return best;
+    }
+
+    // The node on node's path that completed the given round, if any.
+    static const TimelineNode* ancestor(const TimelineNode* node, int round) {
+        while (node && node->round > round) node = node->parent;
+        return node && node->round == round ? node : nullptr;
+    }
+
+    // Moves the head back to the end of an earlier round; the old head is
+    // kept as a branch. Returns the new head, or null if that round is not
+    // on the current path.
+    const TimelineNode* rewind(int round) {
+        const TimelineNode* node = ancestor(head, round);
+        if (!node) return nullptr;
+        if (node != head) branches.push_back(head);
+        head = node;
+        return node;
+    }
+
+    // Puts the players, histories included, back as they were at any node
+    // of a timeline that keeps rolls. Each history is relinked to the
+    // node's chunks, and the rolls made since those were sealed are read
+    // off the path and appended; nothing before them is copied or replayed.
+    // Chunks sealed before the timeline started give way to the root's
+    // snapshot, which holds every roll up to it.
+    void restorePlayers(const TimelineNode* node, vector<Player>& players) const {
+        vector<int> tail;
+        for (size_t i = 0; i < seats; ++i) {
+            const RollSnapshot& snapshot = node->rolls[i];
+            size_t missing = snapshot.stats.count - (snapshot.chunks ? snapshot.chunks->rolls : 0);
+            const TimelineNode* at = node;
+            tail.clear();
+            for (; missing > 0 && at->parent; at = at->parent) {
+                if (at->entries[i].roll > 0) {
+                    tail.push_back(at->entries[i].roll);
+                    missing--;
+                }
+            }
+            reverse(tail.begin(), tail.end());
+            const auto& chunks = missing > 0 ? at->rolls[i].chunks : snapshot.chunks;
+            players[i].restoreRolls(chunks, tail.data(), tail.size(), snapshot.stats);
+            players[i].setStanding(node->entries[i].score, node->entries[i].wins);
+        }
+    }
+};
+
+const int ELIMINATION_RESERVE_ROUNDS = 64;
+
+// Game state and round rules with no terminal attached. DiceGame layers the
+// interactive UI on top; the server hosts bare sessions behind its protocol.
+class GameSession {
+protected:
+    vector<Player> players;
+    CompiledRules rules;
+    RuleState ruleState;
+    int currentRound;
+    int diceSides;
+    const DieKernels* die;
+    DiceRng rng;
+    vector<int> roundRolls;  // this round's rolls, 0 for a seat that has not rolled or is out
+    vector<int> roundBonus;
+    size_t nextSeat;
+    bool finished;
+    bool rewindable;  // keeps a timeline with every seat's rolls, for rewinds
+    GameTimeline timeline;
+
+    // Picks the specialised kernels once, so rolling never branches on sides.
+    void setDiceSides(int sides) {
+        diceSides = sides;
+        die = dieKernels(sides);
+        rules = CompiledRules(rules.getRules(), sides);
+    }
+
+    // Switches rules with every seat in play and no streak running.
+    void setRules(const RuleSet& ruleSet) {
+        RuleState fresh;
+        fresh.reset(players.size());
+        restoreRules(ruleSet, fresh);
+    }
+
+    // Resumes a game under its rules, e.g. from a save.
+    void restoreRules(const RuleSet& ruleSet, const RuleState& state) {
+        rules = CompiledRules(ruleSet, diceSides);
+        ruleState = state;
+        fill(roundBonus.begin(), roundBonus.end(), 0);
+        updateFinished();
+    }
+
+    void updateFinished() {
+        int topScore = 0;
+        for (const auto& player : players) topScore = max(topScore, player.getScore());
+        finished = rules.finished(currentRound - 1, topScore, ruleState);
+    }
+
+public:
+    GameSession(RngEngine engine = RngEngine::Mt19937, uint64_t seed = 0, uint64_t stream = 0,
+                bool keepTimeline = true)
+        : currentRound(0), diceSides(6), die(dieKernels(6)), rng(engine, seed, stream), nextSeat(0),
+          finished(false), rewindable(keepTimeline), timeline(0, keepTimeline) {}
+
+    void configure(int sides, const RuleSet& ruleSet) {
+        players.clear();
+        setDiceSides(sides);
+        currentRound = 1;
+        nextSeat = 0;
+        setRules(ruleSet);
+        timeline.clear();
+    }
+
+    // A classic game of the given length with plain scoring.
+    void configure(int sides, int roundCount) {
+        RuleSet classic;
+        classic.rounds = roundCount;
+        configure(sides, classic);
+    }
+
+    size_t addPlayer(const string& name) {
+        players.emplace_back(name);
+        ruleState.alive.push_back(1);
+        ruleState.aliveCount++;
+        updateFinished();
+        return players.size() - 1;
+    }
+
+    const vector<Player>& getPlayers() const { return players; }
+    const RuleSet& getRules() const { return rules.getRules(); }
+    int getRounds() const { return rules.getRules().rounds; }
+    int getCurrentRound() const { return currentRound; }
+    int getDiceSides() const { return diceSides; }
+    size_t getNextSeat() const { return nextSeat; }
+    bool isFinished() const { return finished; }
+    bool isInGame(size_t seat) const { return ruleState.alive[seat] != 0; }
+    int getAliveCount() const { return ruleState.aliveCount; }
+
+    // Winner of a finished game, -1 when it ended level.
+    int gameWinner() const {
+        return rules.gameWinner(players.size(), ruleState, [&](size_t i) { return players[i].getScore(); });
+    }
+
+    // Rolls for one seat and books the result; the round is complete once
+    // every seat has rolled.
+    int rollFor(size_t seat) {
+        if (rewindable && !timeline.started()) restartTimeline();
+        int roll = die->roll(rng);
+        countMetric(Counter::Rolls);
+        players[seat].addToScore(rules.rollPoints(roll));
+        players[seat].addToHistory(roll);
+        roundRolls.resize(players.size());
+        roundRolls[seat] = roll;
+        nextSeat = seat + 1;
+        return roll;
+    }
+
+    bool roundComplete() const { return nextSeat >= players.size(); }
+
+    // Sizes the round buffers, roll histories and timeline for the rest of
+    // the game, so playing its rounds never has to grow them. A Target game
+    // gains at least a point a round; an Elimination game has no bound, so
+    // it gets room for more rounds than all but freak games last.
+    void reserveRounds() {
+        roundRolls.resize(players.size());
+        roundBonus.resize(players.size());
+        const RuleSet& ruleSet = rules.getRules();
+        int left = ELIMINATION_RESERVE_ROUNDS;
+        if (ruleSet.mode == GameMode::Classic) {
+            left = ruleSet.rounds - currentRound + 1;
+        } else if (ruleSet.mode == GameMode::Target) {
+            left = ruleSet.target;
+            for (const auto& player : players) left = min(left, ruleSet.target - player.getScore());
+        }
+        size_t remaining = finished ? 0 : static_cast<size_t>(max(left, 0));
+        for (auto& player : players) player.reserveHistory(player.getRollCount() + remaining);
+        if (!rewindable) return;
+        if (!timeline.started()) restartTimeline();
+        timeline.reserve(remaining);
+    }
+
+    RoundOutcome resolveRound() {
+        roundRolls.resize(players.size());
+        roundBonus.resize(players.size());
+        RoundOutcome outcome = rules.scoreRound(roundRolls.data(), players.size(), ruleState, roundBonus.data());
+        for (size_t i = 0; i < players.size(); ++i) players[i].addToScore(roundBonus[i]);
+        if (outcome.winner >= 0) players[outcome.winner].incrementWins();
+        if (rewindable) timeline.record(players, roundRolls, outcome.winner, ruleState);
+        fill(roundRolls.begin(), roundRolls.end(), 0);
+        currentRound++;
+        nextSeat = 0;
+        updateFinished();
+        return outcome;
+    }
+
+    // Points the last resolved round added to a seat beyond its roll.
+    int getRoundBonus(size_t seat) const { return roundBonus[seat]; }
+
+    const GameTimeline& getTimeline() const { return timeline; }
+
+    // Roots the timeline at the current state, forgetting earlier rounds.
+    void restartTimeline() { timeline.start(players, currentRound - 1, ruleState); }
+
+    // Returns to the start of an earlier round on the current path. Rounds
+    // played from there grow a new branch; the abandoned one stays in the
+    // timeline.
+    bool rewindTo(int round) {
+        const TimelineNode* node = timeline.rewind(round - 1);
+        if (!node) return false;
+        timeline.restorePlayers(node, players);
+        timeline.restoreState(node, ruleState);
+        currentRound = round;
+        nextSeat = 0;
+        updateFinished();
+        return true;
+    }
+};
+
+class DiceGame : public GameSession {
+private:
+    bool gameSaved;
+    RollJournal journal;
+    uint64_t journalGeneration;
+    int compactInterval;
+    int roundsSinceCompaction;
+    TerminalRenderer terminal;
+    ostream& out;
+    EventLoop events;
+    double animationSpeed;
+    istream& in;
+    SessionTrace* trace;
+    bool persistent;
+    bool reproducible;
+    bool hasFixedSeed;
+    uint64_t fixedSeed;
+    CareerStore careers;
+    RollExporter* exporter;
+    uint64_t gamesStarted;
+    RuleSet scoring;      // bonuses new games are set up with
+    const AnimationStep* animationSteps;  // steps of the animation in progress
+    size_t animationShown;
+    string headerTitle;  // composed titles, reused so a round does not allocate
+    RollEventBus rollEvents;  // last member: its consumers stop before the state they touch
+
+    uint64_t sessionSeed() const {
+        return hasFixedSeed ? fixedSeed : randomSeed();
+    }
+
+    chrono::milliseconds scaled(chrono::milliseconds duration) const {
+        if (animationSpeed <= 0.0) return chrono::milliseconds(0);
+        return chrono::milliseconds(static_cast<int64_t>(duration.count() / animationSpeed));
+    }
+
+    // Plays steps as scheduled frames: each step's text is drawn, then held
+    // for its speed-scaled duration. Any keypress skips to the last frame.
+    // The steps live in members so each timer only captures this and an
+    // index, which std::function keeps inline.
+    void animate(const AnimationStep* steps, size_t count) {
+        chrono::milliseconds total(0);
+        for (size_t i = 0; i < count; ++i) total += scaled(steps[i].hold);
+        if (total.count() == 0) {
+            for (size_t i = 0; i < count; ++i) out << steps[i].text;
+            terminal.present();
+            return;
+        }
+
+        animationSteps = steps;
+        animationShown = 0;
+        chrono::milliseconds at(0);
+        for (size_t i = 0; i < count; ++i) {
+            events.schedule(at, [this, i]() {
+                out << animationSteps[i].text;
+                animationShown = i + 1;
+                terminal.present();
+            });
+            at += scaled(steps[i].hold);
+        }
+        events.schedule(at, []() {});
+        if (!events.runTimers()) {
+            events.cancelAll();
+            for (; animationShown < count; ++animationShown) out << steps[animationShown].text;
+            terminal.present();
+        }
+        animationSteps = nullptr;
+    }
+
+    template <size_t N>
+    void animate(const AnimationStep (&steps)[N]) {
+        animate(steps, N);
+    }
+
+    void pause(chrono::milliseconds duration) {
+        const AnimationStep step[] = {{"", duration}};
+        animate(step);
+    }
+
+    void awaitInput() {
+        terminal.present();
+        ScopedTimer waiting(Metric::InputWait);
+        events.waitForInput();
+    }
+
+    // Reads a menu choice; false once input has ended.
+    bool readChoice(int& choice) {
+        awaitInput();
+        if (in >> choice) return true;
+        if (in.eof()) return false;
+        in.clear();
+        in.ignore(numeric_limits<streamsize>::max(), '\n');
+        choice = 0;
+        return true;
+    }
+
+    void waitForEnter() {
+        awaitInput();
+        in.ignore();
+        in.get();
+    }
+
+    template <typename T>
+    void readInRange(T& value, T low, T high, const char* error) {
+        awaitInput();
+        while (!(in >> value) || value < low || value > high) {
+            if (in.eof()) {
+                value = low;
+                return;
+            }
+            in.clear();
+            in.ignore(numeric_limits<streamsize>::max(), '\n');
+            out << RED << error << " Enter " << low << "-" << high << ": " << RESET;
+            awaitInput();
+        }
+    }
+
+    void showRollAnimation(int result) {
+        ScopedTimer timer(Metric::RollAnimation);
+        const AnimationStep steps[] = {
+            {"\nRolling dice.", chrono::milliseconds(300)},
+            {".", chrono::milliseconds(300)},
+            {".", chrono::milliseconds(300)},
+            {"\n", chrono::milliseconds(0)},
+            {DICE_ART[result], chrono::milliseconds(0)},
+            {"\n", chrono::milliseconds(800)}
+        };
+        animate(steps);
+    }
+
+    void displayDiceArt(int value) {
+        out << DICE_ART[value] << "\n";
+    }
+
+    void displayHeader(string_view title = "DICE GAME SIMULATOR") {
+        ScopedTimer timer(Metric::RenderHeader);
+        terminal.beginFrame();
+        out << BOLD << CYAN << "============================================\n";
+        out << "          " << UNDERLINE << title << RESET << BOLD << CYAN << "          \n";
+        out << "============================================\n" << RESET;
+        
+        if (!players.empty()) {
+            const RuleSet& ruleSet = getRules();
+            out << BOLD << "Round: " << currentRound;
+            if (ruleSet.mode == GameMode::Classic) out << "/" << ruleSet.rounds;
+            if (ruleSet.mode == GameMode::Target) out << " | Target: " << ruleSet.target;
+            if (ruleSet.mode == GameMode::Elimination) out << " | Still in: " << getAliveCount();
+            out << " | Dice: " << diceSides << "-sided";
+            out << " | Players: " << players.size() << "\n\n" << RESET;
+        }
+    }
+
+    void displayScores(bool showDetails = false) {
+        ScopedTimer timer(Metric::RenderScores);
+        out << BOLD << YELLOW << "\nCurrent Standings:\n" << RESET;
+        out << "┌───────────────┬────────┬────────┬────────┐\n";
+        out << "│ Player        │ Score  │ Wins   │ Best   │\n";
+        out << "├───────────────┼────────┼────────┼────────┤\n";
+        
+        for (const auto& player : players) {
+            out << "│ " << setw(13) << left << player.getName() << " │ "
+                 << setw(6) << right << player.getScore() << " │ "
+                 << setw(6) << right << player.getWins() << " │ "
+                 << setw(6) << right << player.getBestRoll() << " │\n";
+        }
+        out << "└───────────────┴────────┴────────┴────────┘\n";
+        
+        if (showDetails) {
+            out << "\n" << BOLD << "Roll History:\n" << RESET;
+            for (const auto& player : players) {
+                out << player.getName() << ": ";
+                for (int roll : player.getDiceHistory()) {
+                    out << roll << " ";
+                }
+                out << "(Avg: " << fixed << setprecision(1) << player.getAverageRoll() << ")\n";
+            }
+        }
+    }
+
+    void announceRoundWinner(size_t seat, int points) {
+        out << BOLD << GREEN << "\n🎉 " << players[seat].getName() << " wins this round with " << points << "! 🎉\n" << RESET;
+        pause(chrono::seconds(2));
+    }
+
+    // Bonus points and knock-outs from the round just resolved; rolled
+    // marks the seats that were still in when it started.
+    void announceRoundRules(uint64_t rolled) {
+        for (size_t i = 0; i < players.size(); ++i) {
+            if (getRoundBonus(i) > 0) {
+                out << YELLOW << "\n✨ " << players[i].getName() << " earns " << getRoundBonus(i) << " bonus points!" << RESET;
+            }
+            if ((rolled >> i & 1) && !isInGame(i)) {
+                out << BOLD << RED << "\n💀 " << players[i].getName() << " rolled lowest and is eliminated!" << RESET;
+            }
+        }
+    }
+
+    void describeBranch(const TimelineNode* node) {
+        int seat = timeline.leader(node);
+        out << " after round " << node->round << ": ";
+        if (seat < 0) {
+            out << "tied at the top";
+        } else {
+            out << players[seat].getName() << " leads with " << node->entries[seat].score;
+        }
+        out << "\n";
+    }
+
+    void showBranches() {
+        const auto& branches = timeline.getBranches();
+        if (branches.empty()) return;
+        out << BOLD << YELLOW << "\nWhat-if Branches:\n" << RESET;
+        for (size_t i = 0; i < branches.size(); ++i) {
+            out << "Branch " << i + 1;
+            describeBranch(branches[i]);
+        }
+        out << "This game";
+        describeBranch(timeline.getHead());
+    }
+
+    // Goes back to the start of an earlier round. Play continues from there
+    // on a new branch, and the abandoned rounds are kept for comparison.
+    void rewindGame() {
+        displayHeader("REWIND");
+        int first = timeline.getRoot()->round + 1, last = currentRound - 1;
+        showBranches();
+        if (last < first) {
+            out << YELLOW << "\nNo earlier round to go back to yet.\n" << RESET;
+            pause(chrono::seconds(1));
+            return;
+        }
+        out << "\nRewind to the start of round (" << first << "-" << last << "): ";
+        int round;
+        readInRange(round, first, last, "Invalid round!");
+        rewindTo(round);
+        reserveRounds();
+        compactJournal();
+        out << BOLD << GREEN << "\nBack at round " << round << ". Rounds from here form a new branch.\n" << RESET;
+        pause(chrono::seconds(1));
+    }
+
+    void saveGame() {
+        rollEvents.drain();  // a save is a barrier: the journal and export have seen every roll
+        bool saved;
+        {
+            ScopedTimer timer(Metric::SaveGame);
+            vector<uint8_t> bytes = encodeSaveGame(getRules(), currentRound, diceSides, players, 0, rng.getEngine(),
+                                                   &ruleState);
+            saved = writeFileAtomically(SAVE_FILE, bytes);
+            if (saved) countMetric(Counter::SaveBytes, bytes.size());
+        }
+        if (saved) {
+            gameSaved = true;
+            out << BOLD << GREEN << "\nGame saved successfully!\n" << RESET;
+        } else {
+            out << BOLD << RED << "\nError saving game!\n" << RESET;
+        }
+        pause(chrono::seconds(1));
+    }
+
+    bool loadGame() {
+        MappedFile file;
+        SavedGame saved;
+        bool opened, decoded = false;
+        {
+            ScopedTimer timer(Metric::LoadGame);
+            opened = file.open(SAVE_FILE);
+            if (opened) decoded = decodeSaveGame(file.data(), file.size(), saved);
+            if (decoded) countMetric(Counter::LoadBytes, file.size());
+        }
+        if (!opened) {
+            out << BOLD << RED << "\nNo saved game found!\n" << RESET;
+            pause(chrono::seconds(1));
+            return false;
+        }
+
+        if (!decoded) {
+            out << BOLD << RED << "\nSaved game is corrupted or unsupported!\n" << RESET;
+            pause(chrono::seconds(1));
+            return false;
+        }
+
+        currentRound = saved.currentRound;
+        setDiceSides(saved.diceSides);
+        players = move(saved.players);
+        restoreRules(saved.rules, saved.state);
+        rng.select(saved.engine, sessionSeed());
+        gameSaved = false;
+        out << BOLD << GREEN << "\nGame loaded successfully!\n" << RESET;
+        pause(chrono::seconds(1));
+        compactJournal();
+        return true;
+    }
+
+    // Folds everything journaled so far into a fresh autosave snapshot and
+    // restarts the journal behind it. The snapshot is durably in place
+    // before the journal is reset, so a crash in between leaves a newer
+    // snapshot whose generation no longer matches the stale journal. If
+    // either step fails the old journal keeps logging, and the next
+    // compaction tries again.
+    void compactJournal() {
+        if (!persistent) return;
+        rollEvents.drain();
+        ScopedTimer timer(Metric::Compaction);
+        journal.commit();
+        roundsSinceCompaction = 0;
+        uint64_t next = journalGeneration + 1;
+        vector<uint8_t> bytes = encodeSaveGame(getRules(), currentRound, diceSides, players, next, rng.getEngine(),
+                                               &ruleState);
+        if (writeFileAtomically(AUTOSAVE_FILE, bytes) && journal.start(JOURNAL_FILE, next)) {
+            journalGeneration = next;
+        } else {
+            out << RED << "Could not write the autosave; the previous journal is kept.\n" << RESET;
+        }
+    }
+
+    void discardAutosave() {
+        if (!persistent) return;
+        rollEvents.drain();
+        journal.close();
+        remove(JOURNAL_FILE.c_str());
+        remove(AUTOSAVE_FILE.c_str());
+    }
+
+    bool recoverAutosave() {
+        MappedFile snapshot;
+        SavedGame saved;
+        if (!snapshot.open(AUTOSAVE_FILE) || !decodeSaveGame(snapshot.data(), snapshot.size(), saved)) {
+            return false;
+        }
+        int recovered = 0;
+        MappedFile tail;
+        if (tail.open(JOURNAL_FILE)) {
+            recovered = max(0, replayJournal(tail.data(), tail.size(), saved));
+        }
+
+        currentRound = saved.currentRound;
+        setDiceSides(saved.diceSides);
+        journalGeneration = saved.generation;
+        players = move(saved.players);
+        restoreRules(saved.rules, saved.state);
+        rng.select(saved.engine, sessionSeed());
+        gameSaved = false;
+        out << BOLD << GREEN << "\nRecovered unfinished game (" << recovered
+             << " round(s) from journal).\n" << RESET;
+        pause(chrono::seconds(1));
+        compactJournal();
+        return true;
+    }
+
+    void showGameRules() {
+        displayHeader("GAME RULES");
+        
+        out << BOLD << YELLOW << "🌟 Game Modes 🌟\n" << RESET;
+        out << "1. " << BOLD << "Classic Mode:" << RESET << " Highest total after the set rounds wins\n";
+        out << "2. " << BOLD << "Target Mode:" << RESET << " First to reach target score wins\n";
+        out << "3. " << BOLD << "Elimination:" << RESET << " Lowest roll each round is out; last one in wins\n\n";
+        
+        out << BOLD << YELLOW << "🎲 Dice Mechanics 🎲\n" << RESET;
+        out << "- Dice can have 4-12 sides\n";
+        out << "- The single highest roll takes the round\n\n";
+        
+        // The game in progress keeps the rules it was set up with.
+        const RuleSet& ruleSet = players.empty() ? scoring : getRules();
+        out << BOLD << YELLOW << "🏆 Scoring System 🏆\n" << RESET;
+        out << "- Every roll scores its face value\n";
+        if (ruleSet.maxRollMultiplier > 1) {
+            out << "- " << ruleSet.maxRollMultiplier << "x points for rolling the maximum possible value\n";
+        }
+        if (ruleSet.streakMultiplier > 1) {
+            out << "- " << ruleSet.streakMultiplier << "x points for the winning roll on back-to-back wins\n";
+        }
+        if (ruleSet.doublesBonus > 0) {
+            out << "- +" << ruleSet.doublesBonus << " each when two players roll the same face (doubles)\n";
+        }
+        if (ruleSet.triplesBonus > 0) {
+            out << "- +" << ruleSet.triplesBonus << " each when three or more roll the same face (triples)\n";
+        }
+        out << "\n";
+        
+        out << "Press Enter to continue...";
+        waitForEnter();
+    }
+
+public:
+    DiceGame(const GameOptions& options = GameOptions())
+        : gameSaved(false), journalGeneration(0),
+          compactInterval(options.compactInterval), roundsSinceCompaction(0), out(terminal.stream()),
+          animationSpeed(options.animationSpeed), in(*options.input), trace(options.trace),
+          persistent(!options.reproducible), reproducible(options.reproducible),
+          hasFixedSeed(options.hasSeed), fixedSeed(options.seed), exporter(options.exporter), gamesStarted(0),
+          scoring(options.rules), animationSteps(nullptr), animationShown(0) {
+        terminal.setPlain(options.plainOutput);
+        terminal.setSink(options.output);
+        events.setInteractiveInput(options.input == &std::cin);
+        rng.select(options.rngEngine, sessionSeed());
+        journal.setSyncInterval(options.journalSyncInterval);
+        if (persistent) careers.open();
+
+        if (persistent) {
+            rollEvents.subscribe([this](const RollEvent* batch, size_t count) {
+                for (size_t i = 0; i < count; ++i) {
+                    const RollEvent& event = batch[i];
+                    if (event.type == RollEventType::Roll) journal.appendRoll(event.player, event.value, event.round);
+                    else journal.appendRoundEnd(event.player == JOURNAL_NO_WINNER ? -1 : event.player, event.round);
+                }
+            });
+        }
+        if (exporter) {
+            rollEvents.subscribe([this](const RollEvent* batch, size_t count) {
+                for (size_t i = 0; i < count; ++i) {
+                    const RollEvent& event = batch[i];
+                    if (event.type != RollEventType::Roll) continue;
+                    exporter->append({event.game, event.round, event.player, static_cast<uint8_t>(event.value),
+                                      exporter->elapsedNanos(event.at)});
+                }
+            });
+        }
+        if (METRICS_ENABLED) {
+            rollEvents.subscribe([](const RollEvent* batch, size_t count) {
+                auto now = chrono::steady_clock::now();
+                for (size_t i = 0; i < count; ++i) {
+                    auto lag = chrono::duration_cast<chrono::nanoseconds>(now - batch[i].at);
+                    recordMetric(Metric::EventDelivery, static_cast<uint64_t>(lag.count()));
+                }
+                countMetric(Counter::Events, count);
+            });
+        }
+    }
+
+    void setupGame() {
+        displayHeader("GAME SETUP");
+        
+        out << BOLD << "Select Game Mode:\n" << RESET;
+        out << "1. Classic Mode (Highest roll wins)\n";
+        out << "2. Target Score Mode\n";
+        out << "3. Elimination Mode\n";
+        out << "Enter choice: ";
+        
+        int mode;
+        readInRange(mode, 1, 3, "Invalid choice!");
+        
+        int numPlayers;
+        out << "\n" << BOLD << "Number of Players (2-4): " << RESET;
+        readInRange(numPlayers, 2, 4, "Invalid input!");
+        
+        in.ignore();
+        players.clear();
+        for (int i = 0; i < numPlayers; ++i) {
+            out << "Player " << i+1 << " name: ";
+            awaitInput();
+            string name;
+            getline(in, name);
+            while (name.size() > CAREER_NAME_BYTES) {
+                out << RED << "Name too long! Use at most " << CAREER_NAME_BYTES << " bytes: " << RESET;
+                awaitInput();
+                getline(in, name);
+            }
+            if (name.empty()) name = "Player " + to_string(i+1);
+            players.emplace_back(name);
+        }
+        
+        out << "\n" << BOLD << "Dice Sides (4-12): " << RESET;
+        int sides;
+        readInRange(sides, MIN_DICE_SIDES, MAX_DICE_SIDES, "Invalid input!");
+        setDiceSides(sides);
+        
+        RuleSet ruleSet = scoring;
+        ruleSet.mode = static_cast<GameMode>(mode);
+        if (ruleSet.mode == GameMode::Target) {
+            out << "\n" << BOLD << "Target Score (50-500): " << RESET;
+            readInRange(ruleSet.target, 50, 500, "Invalid input!");
+        } else if (ruleSet.mode == GameMode::Classic) {
+            out << "\n" << BOLD << "Number of Rounds (3-20): " << RESET;
+            readInRange(ruleSet.rounds, 3, 20, "Invalid input!");
+        }
+        
+        currentRound = 1;
+        setRules(ruleSet);
+        compactJournal();
+    }
+
+    void playGame() {
+        uint64_t game = gamesStarted++;
+        restartTimeline();
+        reserveRounds();
+        while (!isFinished()) {
+            headerTitle.assign("ROUND ").append(to_string(currentRound));
+            displayHeader(headerTitle);
+            displayScores();
+            
+            out << BOLD << "\nRound Options:\n" << RESET;
+            out << "1. Play Round\n";
+            out << "2. Save Game\n";
+            out << "3. Show Statistics\n";
+            out << "4. Main Menu\n";
+            out << "5. Show Metrics\n";
+            out << "6. Rewind to Earlier Round\n";
+            out << "Enter choice: ";
+            
+            int choice;
+            if (!readChoice(choice)) return;
+            
+            switch (choice) {
+                case 1:
+                    playRound(game);
+                    break;
+                case 2:
+                    saveGame();
+                    break;
+                case 3:
+                    showStatistics();
+                    break;
+                case 4:
+                    rollEvents.drain();
+                    journal.commit();
+                    return;
+                case 5:
+                    showMetrics();
+                    break;
+                case 6:
+                    rewindGame();
+                    break;
+                default:
+                    out << RED << "Invalid choice!\n" << RESET;
+                    pause(chrono::seconds(1));
+            }
+        }
+        
+        discardAutosave();
+        if (persistent && careers.isOpen() && !careers.recordGame(players, gameWinner())) {
+            out << RED << "Could not update career stats.\n" << RESET;
+        }
+        showFinalResults();
+    }
+
+    // One round: every seat takes its turn, then the round is scored. Once
+    // reserveRounds() has run this does no heap allocation; players are
+    // referred to by seat and titles are composed in a reused buffer.
+    void playRound(uint64_t game) {
+        uint64_t rolled = 0;
+        for (size_t i = 0; i < players.size(); ++i) {
+            if (!isInGame(i)) continue;
+            rolled |= uint64_t(1) << i;
+            const Player& player = players[i];
+            headerTitle.assign(player.getName()).append("'s Turn");
+            displayHeader(headerTitle);
+            displayScores();
+            
+            out << BOLD << player.getName() << ", ready to roll? (Press Enter)" << RESET;
+            waitForEnter();
+            
+            int roll = rollFor(i);
+            if (trace) trace->onDraw(roll);
+            rollEvents.publish({RollEventType::Roll, static_cast<uint8_t>(i), static_cast<uint16_t>(roll),
+                                static_cast<uint32_t>(currentRound), game, chrono::steady_clock::now()});
+            showRollAnimation(roll);
+        }
+        
+        int round = currentRound;
+        RoundOutcome outcome = resolveRound();
+        uint8_t winner = outcome.winner < 0 ? JOURNAL_NO_WINNER : static_cast<uint8_t>(outcome.winner);
+        rollEvents.publish({RollEventType::RoundEnd, winner, 0, static_cast<uint32_t>(round), game,
+                            chrono::steady_clock::now()});
+        
+        announceRoundRules(rolled);
+        if (outcome.winner < 0) {
+            out << BOLD << YELLOW << "\nThis round is a tie!\n" << RESET;
+        } else {
+            announceRoundWinner(static_cast<size_t>(outcome.winner), outcome.winningRoll);
+        }
+        
+        if (++roundsSinceCompaction >= compactInterval) {
+            compactJournal();
+        }
+    }
+
+    // Waits until every consumer has seen the rolls published so far.
+    void drainEvents() { rollEvents.drain(); }
+
+    void showStatistics() {
+        displayHeader("GAME STATISTICS");
+        
+        if (players.empty()) {
+            out << RED << "No game data available.\n" << RESET;
+        } else {
+            out << BOLD << YELLOW << "Player Stats:\n" << RESET;
+            displayScores(true);
+        
+            out << BOLD << YELLOW << "\nGame Analysis:\n" << RESET;
+            
+            GameAnalysis analysis = analyzePlayers(players, diceSides);
+            const RollStatistics& all = analysis.combined;
+            
+            if (all.count > 0) {
+                out << "Most frequent roll: " << all.mode 
+                     << " (rolled " << all.faces[all.mode] << " times)\n";
+                out << "Mean roll: " << fixed << setprecision(2) << all.mean
+                     << " | Variance: " << all.variance
+                     << " | Range: " << all.minRoll << "-" << all.maxRoll << "\n";
+                out << "Longest streak: " << all.longestStreak << " x " << all.streakFace << "\n";
+                out << "Fairness (chi-square vs uniform): " << all.chiSquare
+                     << " (p = " << setprecision(3) << all.pValue << ")\n";
+                if (!reproducible) {
+                    out << "Analyzed " << all.count << " rolls at " << setprecision(0)
+                         << analysis.rollsPerSecond() << " rolls/s\n";
+                }
+            }
+            
+            showExactOdds();
+
+            auto luckiest = max_element(players.begin(), players.end(),
+                [](const Player& a, const Player& b) {
+                    return a.getAverageRoll() < b.getAverageRoll();
+                });
+            
+            out << "Luckiest player: " << luckiest->getName() 
+                 << " (avg " << fixed << setprecision(1) << luckiest->getAverageRoll() << ")\n";
+        }
+        
+        out << "\nPress Enter to continue...";
+        waitForEnter();
+    }
+
+    static string formatNanos(double nanos) {
+        ostringstream text;
+        text << fixed << setprecision(1);
+        if (nanos < 1e3) text << nanos << " ns";
+        else if (nanos < 1e6) text << nanos / 1e3 << " us";
+        else if (nanos < 1e9) text << nanos / 1e6 << " ms";
+        else text << nanos / 1e9 << " s";
+        return text.str();
+    }
+
+    void showMetrics() {
+        rollEvents.drain();  // count every event already published
+        displayHeader("METRICS");
+
+        if (!METRICS_ENABLED) {
+            out << RED << "Metrics were compiled out of this build.\n" << RESET;
+        } else if (reproducible) {
+            out << YELLOW << "Timings are not shown in recorded or replayed sessions.\n" << RESET;
+        } else {
+            MetricsSnapshot snap = snapshotMetrics();
+            out << BOLD << YELLOW << "Hot paths:\n" << RESET;
+            out << "┌────────────────┬────────┬──────────┬──────────┬──────────┬──────────┐\n";
+            out << "│ Path           │ Count  │ Mean     │ p50      │ p99      │ Max      │\n";
+            out << "├────────────────┼────────┼──────────┼──────────┼──────────┼──────────┤\n";
+            for (size_t m = 0; m < METRIC_COUNT; ++m) {
+                const LatencyHistogram& histogram = snap.latencies[m];
+                if (histogram.count == 0) continue;
+                out << "│ " << setw(14) << left << METRIC_INFO[m].name << " │ "
+                     << setw(6) << right << histogram.count << " │ "
+                     << setw(8) << right << formatNanos(histogram.meanNanos()) << " │ "
+                     << setw(8) << right << formatNanos(double(histogram.percentile(0.50))) << " │ "
+                     << setw(8) << right << formatNanos(double(histogram.percentile(0.99))) << " │ "
+                     << setw(8) << right << formatNanos(double(histogram.maxNanos)) << " │\n";
+            }
+            out << "└────────────────┴────────┴──────────┴──────────┴──────────┴──────────┘\n";
+            out << "Rolls: " << snap.counters[static_cast<size_t>(Counter::Rolls)]
+                 << " | Saved: " << snap.counters[static_cast<size_t>(Counter::SaveBytes)] << " B"
+                 << " | Loaded: " << snap.counters[static_cast<size_t>(Counter::LoadBytes)] << " B"
+                 << " | Drawn: " << snap.counters[static_cast<size_t>(Counter::FrameBytes)] << " B\n";
+            if (!metricsPath.empty()) {
+                out << "Exported to " << metricsPath << " on exit and on SIGUSR1\n";
+            }
+        }
+
+        out << "\nPress Enter to continue...";
+        waitForEnter();
+    }
+
+    // Exact per-round and whole-game odds next to what has happened so far.
+    // Rounds lose a seat at a time in Elimination, so the per-round odds
+    // only hold while everyone is still in.
+    void showExactOdds() {
+        int played = currentRound - 1;
+        int n = static_cast<int>(players.size());
+        const RuleSet& ruleSet = getRules();
+        if (!OddsEngine::supports(n, diceSides) || getAliveCount() < n) return;
+        RoundOdds round = OddsEngine::round(n, diceSides);
+
+        out << BOLD << YELLOW << "\nExact Odds vs Observed:\n" << RESET;
+        out << fixed << setprecision(1);
+        out << "Round win chance per player: " << 100.0 * round.win << "% | Tie chance: "
+             << 100.0 * round.tie << "%\n";
+        if (played > 0) {
+            int decided = 0;
+            for (const auto& player : players) {
+                out << "  " << setw(13) << left << player.getName() << right << " won "
+                     << player.getWins() << "/" << played << " rounds ("
+                     << 100.0 * player.getWins() / played << "%, expected "
+                     << round.win * played << ")\n";
+                decided += player.getWins();
+            }
+            out << "  Tied rounds: " << played - decided << "/" << played
+                 << " (expected " << round.tie * played << ")\n";
+        }
+        // Totals only follow the exact distributions when every roll scores
+        // its face; who survives an Elimination game does not depend on them.
+        GameOdds game;
+        bool plain = ruleSet.plainScoring();
+        if (plain && ruleSet.mode == GameMode::Classic && OddsEngine::instance().classic(n, diceSides, ruleSet.rounds, game)) {
+            out << "Chance to finish with the top score after " << ruleSet.rounds << " rounds: "
+                 << 100.0 * game.win << "% each, " << 100.0 * game.tie << "% shared\n";
+        } else if (plain && ruleSet.mode == GameMode::Target &&
+                   OddsEngine::instance().target(n, diceSides, ruleSet.target, game)) {
+            out << "Chance to lead alone once someone reaches " << ruleSet.target << ": "
+                 << 100.0 * game.win << "% each, " << 100.0 * game.tie << "% shared\n";
+        } else if (ruleSet.mode == GameMode::Elimination &&
+                   OddsEngine::instance().elimination(n, diceSides, game)) {
+            out << "Chance to be the last one in: " << 100.0 * game.win << "% each, expected length "
+                 << game.expectedRounds << " rounds\n";
+        }
+    }
+
+    void showFinalResults() {
+        displayHeader("FINAL RESULTS");
+        
+        vector<size_t> order = rankPlayers(players, gameWinner());
+        
+        out << BOLD << YELLOW << "\n🏆 FINAL STANDINGS 🏆\n" << RESET;
+        out << "┌──────┬───────────────┬────────┬────────┐\n";
+        out << "│ Rank │ Player        │ Score  │ Wins   │\n";
+        out << "├──────┼───────────────┼────────┼────────┤\n";
+        
+        for (size_t i = 0; i < players.size(); ++i) {
+            string medal;
+            if (i == 0) medal = "🥇";
+            else if (i == 1) medal = "🥈";
+            else if (i == 2) medal = "🥉";
+            
+            const Player& player = players[order[i]];
+            out << "│ " << setw(4) << left << to_string(i+1) + medal << " │ "
+                 << setw(13) << left << player.getName() << " │ "
+                 << setw(6) << right << player.getScore() << " │ "
+                 << setw(6) << right << player.getWins() << " │\n";
+        }
+        out << "└──────┴───────────────┴────────┴────────┘\n";
+        showBranches();
+        
+        out << BOLD << YELLOW << "\n🌟 SPECIAL ACHIEVEMENTS 🌟\n" << RESET;
+        
+        auto bestRoller = max_element(players.begin(), players.end(),
+            [](const Player& a, const Player& b) {
+                return a.getBestRoll() < b.getBestRoll();
+            });
+        
+        out << "Highest Roll: " << bestRoller->getName() << " with " 
+             << bestRoller->getBestRoll() << "\n";
+        
+        auto mostConsistent = min_element(players.begin(), players.end(),
+            [](const Player& a, const Player& b) {
+                if (a.getRollCount() == 0 || b.getRollCount() == 0) return false;
+                return a.steadierThan(b);
+            });
+        
+        out << "Most Consistent: " << mostConsistent->getName() 
+             << " (avg " << fixed << setprecision(1) << mostConsistent->getAverageRoll() << ")\n";
+        
+        GameAnalysis analysis = analyzePlayers(players, diceSides);
+        size_t streaker = 0;
+        for (size_t i = 1; i < players.size(); ++i) {
+            if (analysis.perPlayer[i].longestStreak > analysis.perPlayer[streaker].longestStreak) streaker = i;
+        }
+        if (!players.empty() && analysis.perPlayer[streaker].longestStreak > 1) {
+            out << "Longest Streak: " << players[streaker].getName() << " with "
+                 << analysis.perPlayer[streaker].longestStreak << " x "
+                 << analysis.perPlayer[streaker].streakFace << " in a row\n";
+        }
+        
+        out << "\nPress Enter to return to main menu...";
+        waitForEnter();
+    }
+
+    void showCareerStats() {
+        displayHeader("CAREER STATS");
+
+        if (!careers.isOpen()) {
+            out << RED << "Career stats are not available in this session.\n" << RESET;
+        } else {
+            out << BOLD << "Top Win Rates (" << careers.size() << " players)\n\n" << RESET;
+            printCareerLeaders(out, careers, 10);
+
+            out << "\nLook up a player (Enter to return): ";
+            in.ignore();
+            awaitInput();
+            string name;
+            getline(in, name);
+            if (name.empty()) return;
+            out << "\n";
+            CareerRecord record;
+            if (careers.lookup(name, record)) {
+                printCareerRecord(out, careers, record);
+            } else {
+                out << RED << "No career found for " << name << ".\n" << RESET;
+            }
+            out << "\nPress Enter to return to main menu...";
+            awaitInput();
+            in.get();  // getline already consumed the line the menu choice left behind
+            return;
+        }
+
+        out << "\nPress Enter to return to main menu...";
+        waitForEnter();
+    }
+
+    void showMainMenu() {
+        ifstream autosave(AUTOSAVE_FILE, ios::binary);
+        if (autosave && persistent) {
+            autosave.close();
+            displayHeader("RECOVERY");
+            out << BOLD << YELLOW << "An unfinished game was found. Recover it? (y/n): " << RESET;
+            char recoverChoice;
+            awaitInput();
+            in >> recoverChoice;
+            if (tolower(recoverChoice) == 'y' && recoverAutosave()) {
+                playGame();
+            } else {
+                discardAutosave();
+            }
+        }
+
+        while (true) {
+            displayHeader("MAIN MENU");
+            
+            out << BOLD << "1. New Game\n";
+            out << "2. Load Game\n";
+            out << "3. Game Rules\n";
+            out << "4. Exit\n";
+            out << "5. Career Stats\n" << RESET;
+            out << "Enter choice: ";
+            
+            int choice;
+            if (!readChoice(choice)) return;
+            
+            switch (choice) {
+                case 1:
+                    setupGame();
+                    playGame();
+                    break;
+                case 2:
+                    if (loadGame()) {
+                        playGame();
+                    }
+                    break;
+                case 3:
+                    showGameRules();
+                    break;
+                case 4:
+                    if (!gameSaved && !players.empty()) {
+                        out << "Save before exiting? (y/n): ";
+                        char saveChoice;
+                        awaitInput();
+                        in >> saveChoice;
+                        if (tolower(saveChoice) == 'y') {
+                            saveGame();
+                        }
+                    }
+                    discardAutosave();
+                    return;
+                case 5:
+                    showCareerStats();
+                    break;
+                default:
+                    out << RED << "Invalid choice!\n" << RESET;
+                    pause(chrono::seconds(1));
+            }
+        }
+    }
+};
+
+struct SimulationConfig {
+    RuleSet rules;  // plain scoring unless --rules adds bonuses
+    uint64_t games = 0;
+    int players = 2;
+    int sides = 6;
+    unsigned threads = 0;
+    uint64_t seed = 0;
+    RngEngine engine = RngEngine::Philox;
+    RollExporter* exporter = nullptr;  // receives every roll when set
+};
+
+struct SimulationResult {
+    uint64_t games = 0;
+    uint64_t ties = 0;
+    uint64_t rounds = 0;
+    vector<uint64_t> seatWins;
+    vector<uint64_t> scoreCounts;  // index = final score of one player
+
+    void merge(const SimulationResult& other) {
+        games += other.games;
+        ties += other.ties;
+        rounds += other.rounds;
+        if (seatWins.size() < other.seatWins.size()) seatWins.resize(other.seatWins.size());
+        for (size_t i = 0; i < other.seatWins.size(); ++i) seatWins[i] += other.seatWins[i];
+        if (scoreCounts.size() < other.scoreCounts.size()) scoreCounts.resize(other.scoreCounts.size());
+        for (size_t i = 0; i < other.scoreCounts.size(); ++i) scoreCounts[i] += other.scoreCounts[i];
+    }
+};
+
+const int SIM_BATCH_ROUNDS = 64;
+
+// Appends one round's rolls for export, skipping seats that are out; the
+// caller fills in the game id and timestamp.
+inline void exportRound(vector<RollRecord>* exported, const uint8_t* rolls, int players, uint64_t round) {
+    for (int i = 0; i < players; ++i) {
+        if (rolls[i] == 0) continue;
+        exported->push_back({0, static_cast<uint32_t>(round), static_cast<uint8_t>(i), rolls[i], 0});
+    }
+}
+
+// Per-worker buffers for playHeadlessGame, sized once for the table.
+struct HeadlessTable {
+    vector<int> scores;
+    vector<uint8_t> rolls;  // players * SIM_BATCH_ROUNDS faces
+    vector<int> bonus;
+    RuleState state;
+
+    explicit HeadlessTable(int players)
+        : scores(players), rolls(size_t(players) * SIM_BATCH_ROUNDS), bonus(players) {
+        state.reset(players);
+    }
+};
+
+// Plays one game with no I/O under the compiled rules, stopping as soon as
+// they say the game is over. Returns the winning seat, or -1 for a tie.
+// Games of known length draw their rolls in batches; the others draw one
+// round at a time, so a game never consumes rolls it does not play.
+int playHeadlessGame(const CompiledRules& rules, DiceRng& rng, const DieKernels& die, HeadlessTable& table,
+                     uint64_t& roundsPlayed, vector<RollRecord>* exported = nullptr) {
+    const int n = static_cast<int>(table.scores.size());
+    fill(table.scores.begin(), table.scores.end(), 0);
+    table.state.reset(n);
+    int fixedRounds = rules.getRules().mode == GameMode::Classic ? rules.getRules().rounds : 0;
+    bool scoresRounds = rules.scoresRounds();
+    int round = 0, topScore = 0;
+
+    while (!rules.finished(round, topScore, table.state)) {
+        int batch = fixedRounds ? min(SIM_BATCH_ROUNDS, fixedRounds - round) : 1;
+        uint8_t* rolls = table.rolls.data();
+        die.rollMany(rng, rolls, size_t(batch) * n);
+        for (int r = 0; r < batch; ++r, rolls += n) {
+            if (scoresRounds) {
+                for (int i = 0; i < n; ++i) rolls[i] *= table.state.alive[i];
+                rules.scoreRound(rolls, n, table.state, table.bonus.data());
+                for (int i = 0; i < n; ++i) table.scores[i] += rules.rollPoints(rolls[i]) + table.bonus[i];
+            } else {
+                for (int i = 0; i < n; ++i) table.scores[i] += rolls[i];  // plain: a roll is worth its face
+            }
+            if (exported) exportRound(exported, rolls, n, round + 1);
+            round++;
+        }
+        for (int i = 0; i < n; ++i) topScore = max(topScore, table.scores[i]);
+    }
+    roundsPlayed += round;
+    return rules.gameWinner(n, table.state, [&](size_t i) { return table.scores[i]; });
+}
+
+// Chunked game indices handed out per worker; idle workers steal half of
+// the largest remaining range from a victim.
+class WorkStealingQueue {
+private:
+    struct Range {
+        mutex lock;
+        uint64_t next = 0;
+        uint64_t end = 0;
+    };
+    vector<unique_ptr<Range>> ranges;
+
+public:
+    WorkStealingQueue(uint64_t chunks, unsigned workers) {
+        for (unsigned w = 0; w < workers; ++w) {
+            auto range = make_unique<Range>();
+            range->next = chunks * w / workers;
+            range->end = chunks * (w + 1) / workers;
+            ranges.push_back(move(range));
+        }
+    }
+
+    bool take(unsigned self, uint64_t& chunk) {
+        {
+            Range& own = *ranges[self];
+            lock_guard<mutex> guard(own.lock);
+            if (own.next < own.end) {
+                chunk = own.next++;
+                return true;
+            }
+        }
+
+        while (true) {
+            size_t victim = ranges.size();
+            uint64_t largest = 0;
+            for (size_t i = 0; i < ranges.size(); ++i) {
+                if (i == self) continue;
+                lock_guard<mutex> guard(ranges[i]->lock);
+                uint64_t left = ranges[i]->end - ranges[i]->next;
+                if (left > largest) {
+                    largest = left;
+                    victim = i;
+                }
+            }
+            if (victim == ranges.size()) return false;
+
+            uint64_t stolenBegin, stolenEnd;
+            {
+                Range& other = *ranges[victim];
+                lock_guard<mutex> guard(other.lock);
+                if (other.next >= other.end) continue;  // drained meanwhile, look again
+                uint64_t left = other.end - other.next;
+                stolenEnd = other.end;
+                stolenBegin = other.end - (left + 1) / 2;
+                other.end = stolenBegin;
+            }
+
+            Range& own = *ranges[self];
+            lock_guard<mutex> guard(own.lock);
+            own.next = stolenBegin + 1;
+            own.end = stolenEnd;
+            chunk = stolenBegin;
+            return true;
+        }
+    }
+};
+
+class SimulationEngine {
+private:
+    static const uint64_t GAMES_PER_CHUNK = 1024;
+    SimulationConfig config;
+
+    void runChunk(uint64_t chunk, SimulationResult& result, const CompiledRules& rules, HeadlessTable& table,
+                  vector<RollRecord>& exported) {
+        // One stream per chunk keeps results independent of the thread count.
+        DiceRng rng(config.engine, config.seed, chunk);
+        const DieKernels& die = *dieKernels(config.sides);
+
+        uint64_t first = chunk * GAMES_PER_CHUNK;
+        uint64_t last = min(config.games, first + GAMES_PER_CHUNK);
+        for (uint64_t g = first; g < last; ++g) {
+            size_t exportedBefore = exported.size();
+            int winner = playHeadlessGame(rules, rng, die, table, result.rounds,
+                                          config.exporter ? &exported : nullptr);
+            if (config.exporter) {
+                uint64_t timestamp = config.exporter->elapsedNanos();
+                for (size_t i = exportedBefore; i < exported.size(); ++i) {
+                    exported[i].game = g;
+                    exported[i].timestamp = timestamp;
+                }
+                // Hand over full chunks only; chunks may land out of game order.
+                if (exported.size() >= ROLL_EXPORT_CHUNK) {
+                    config.exporter->write(exported.data(), ROLL_EXPORT_CHUNK);
+                    exported.erase(exported.begin(), exported.begin() + ROLL_EXPORT_CHUNK);
+                }
+            }
+            result.games++;
+            if (winner < 0) {
+                result.ties++;
+            } else {
+                result.seatWins[winner]++;
+            }
+            for (int score : table.scores) {
+                if (static_cast<size_t>(score) >= result.scoreCounts.size()) {
+                    result.scoreCounts.resize(score + 1);
+                }
+                result.scoreCounts[score]++;
+            }
+        }
+    }
+
+public:
+    SimulationEngine(const SimulationConfig& simConfig) : config(simConfig) {
+        if (config.threads == 0) config.threads = max(1u, thread::hardware_concurrency());
+    }
+
+    const SimulationConfig& getConfig() const { return config; }
+
+    SimulationResult run() {
+        uint64_t chunks = (config.games + GAMES_PER_CHUNK - 1) / GAMES_PER_CHUNK;
+        unsigned workers = static_cast<unsigned>(min<uint64_t>(config.threads, max<uint64_t>(chunks, 1)));
+        WorkStealingQueue queue(chunks, workers);
+        vector<SimulationResult> partials(workers);
+
+        auto worker = [&](unsigned self) {
+            SimulationResult& local = partials[self];
+            local.seatWins.assign(config.players, 0);
+            CompiledRules rules(config.rules, config.sides);
+            HeadlessTable table(config.players);
+            vector<RollRecord> exported;
+            uint64_t chunk;
+            while (queue.take(self, chunk)) {
+                runChunk(chunk, local, rules, table, exported);
+            }
+            if (config.exporter) config.exporter->write(exported.data(), exported.size());
+        };
+
+        vector<thread> pool;
+        for (unsigned w = 1; w < workers; ++w) pool.emplace_back(worker, w);
+        worker(0);
+        for (auto& t : pool) t.join();
+
+        SimulationResult total;
+        total.seatWins.assign(config.players, 0);
+        for (const auto& partial : partials) total.merge(partial);
+        return total;
+    }
+};
+
+// Exact odds where they exist: totals follow the exact distributions only
+// under plain scoring, while who survives an Elimination game never
+// depends on the score.
+bool exactGameOdds(const SimulationConfig& config, GameOdds& odds) {
+    OddsEngine& engine = OddsEngine::instance();
+    const RuleSet& rules = config.rules;
+    switch (rules.mode) {
+        case GameMode::Target:
+            return rules.plainScoring() && engine.target(config.players, config.sides, rules.target, odds);
+        case GameMode::Elimination: return engine.elimination(config.players, config.sides, odds);
+        default: return rules.plainScoring() && engine.classic(config.players, config.sides, rules.rounds, odds);
+    }
+}
+
+void printSimulationReport(const SimulationConfig& config, const SimulationResult& result, double seconds) {
+    cout << BOLD << CYAN << "============================================\n";
+    cout << "          SIMULATION REPORT\n";
+    cout << "============================================\n" << RESET;
+    cout << "Mode: " << gameModeName(config.rules.mode) << " | Players: " << config.players
+         << " | Dice: " << config.sides << "-sided | RNG: " << rngEngineName(config.engine);
+    if (config.rules.mode == GameMode::Classic) cout << " | Rounds: " << config.rules.rounds;
+    if (config.rules.mode == GameMode::Target) cout << " | Target: " << config.rules.target;
+    if (!config.rules.plainScoring()) cout << "\nRules: " << formatRuleSpec(config.rules);
+    cout << "\nGames: " << result.games << " on " << config.threads << " thread(s) in "
+         << fixed << setprecision(2) << seconds << "s ("
+         << setprecision(0) << (seconds > 0 ? result.games / seconds : 0.0) << " games/s)\n";
+    if (result.games == 0) return;
+
+    GameOdds odds;
+    bool exact = exactGameOdds(config, odds);
+    auto exactNote = [&](double p) {
+        ostringstream note;
+        if (exact) note << "  (exact " << fixed << setprecision(3) << 100.0 * p << "%)";
+        return note.str();
+    };
+
+    // Largest deviation from the exact odds, in standard errors of the
+    // Monte Carlo estimate.
+    double worstZ = 0.0;
+    auto track = [&](double observed, double p) {
+        double error = sqrt(p * (1.0 - p) / result.games);
+        if (error > 0) worstZ = max(worstZ, fabs(observed - p) / error);
+    };
+
+    cout << BOLD << YELLOW << "\nWin Rates:\n" << RESET;
+    for (size_t i = 0; i < result.seatWins.size(); ++i) {
+        double observed = double(result.seatWins[i]) / result.games;
+        cout << "Player " << setw(2) << left << i + 1 << right << ": " << setw(7) << setprecision(3)
+             << 100.0 * observed << "%" << exactNote(odds.win) << "\n";
+        if (exact) track(observed, odds.win);
+    }
+    double tieRate = double(result.ties) / result.games;
+    cout << "Tie rate : " << setw(7) << 100.0 * tieRate << "%" << exactNote(odds.tie) << "\n";
+    if (exact) track(tieRate, odds.tie);
+    cout << "Avg rounds per game: " << setprecision(2) << double(result.rounds) / result.games;
+    if (exact) cout << "  (exact " << odds.expectedRounds << ")";
+    cout << "\n";
+    if (exact) {
+        const double Z_LIMIT = 4.5;
+        cout << (worstZ <= Z_LIMIT ? GREEN : RED) << "Monte Carlo vs exact odds: worst deviation "
+             << setprecision(2) << worstZ << " standard errors"
+             << (worstZ <= Z_LIMIT ? " (consistent)" : " (INCONSISTENT)") << RESET << "\n";
+    } else {
+        cout << "Exact odds: not computed for this configuration\n";
+    }
+
+    uint64_t samples = 0;
+    double sum = 0.0, sumSq = 0.0;
+    for (size_t s = 0; s < result.scoreCounts.size(); ++s) {
+        samples += result.scoreCounts[s];
+        sum += double(s) * result.scoreCounts[s];
+        sumSq += double(s) * s * result.scoreCounts[s];
+    }
+    double mean = sum / samples;
+    double stddev = sqrt(max(0.0, sumSq / samples - mean * mean));
+
+    auto percentile = [&](double p) {
+        uint64_t rank = static_cast<uint64_t>(ceil(p * samples));
+        uint64_t seen = 0;
+        for (size_t s = 0; s < result.scoreCounts.size(); ++s) {
+            seen += result.scoreCounts[s];
+            if (seen >= max<uint64_t>(rank, 1)) return s;
+        }
+        return result.scoreCounts.size() - 1;
+    };
+    size_t lowest = 0;
+    while (result.scoreCounts[lowest] == 0) lowest++;
+
+    cout << BOLD << YELLOW << "\nScore Distribution (per player):\n" << RESET;
+    cout << "Mean " << mean << " | StdDev " << stddev
+         << " | Min " << lowest << " | P50 " << percentile(0.5)
+         << " | P90 " << percentile(0.9) << " | P99 " << percentile(0.99)
+         << " | Max " << result.scoreCounts.size() - 1 << "\n";
+}
+
+struct WhatIfResult {
+    uint64_t branches = 0;
+    uint64_t ties = 0;
+    uint64_t heldWinner = 0;  // branches the base game's winner still won
+    vector<uint64_t> seatWins;
+    vector<double> scoreSums;
+
+    void merge(const WhatIfResult& other) {
+        branches += other.branches;
+        ties += other.ties;
+        heldWinner += other.heldWinner;
+        for (size_t i = 0; i < other.seatWins.size(); ++i) seatWins[i] += other.seatWins[i];
+        for (size_t i = 0; i < other.scoreSums.size(); ++i) scoreSums[i] += other.scoreSums[i];
+    }
+};
+
+// Plays one base game, then replays it from the start of an earlier round
+// many times over, each branch on its own RNG stream and scored by the
+// same compiled rules. Branches fork off the base game's timeline and only
+// ever hold standings, so none of them copies a player's history.
+class WhatIfRunner {
+private:
+    static const uint64_t BRANCHES_PER_CHUNK = 1024;
+    SimulationConfig config;
+    CompiledRules rules;
+    int fromRound;
+    uint64_t branchCount;
+    GameSession base;
+    const TimelineNode* fork;
+    int baseWinner;
+
+    // Plays a branch to the end; state is left as the branch finished.
+    const TimelineNode* playBranch(uint64_t branch, GameTimeline& arena, HeadlessTable& table) const {
+        DiceRng rng(config.engine, config.seed, branch + 1);  // stream 0 is the base game's
+        const DieKernels& die = *dieKernels(config.sides);
+        const size_t n = table.scores.size();
+        uint8_t* rolls = table.rolls.data();
+        arena.clear();
+        arena.restoreState(fork, table.state);
+        const TimelineNode* node = fork;
+        int topScore = 0;
+        for (size_t i = 0; i < n; ++i) topScore = max(topScore, fork->entries[i].score);
+        while (!rules.finished(node->round, topScore, table.state)) {
+            die.rollMany(rng, rolls, n);
+            for (size_t i = 0; i < n; ++i) rolls[i] *= table.state.alive[i];
+            RoundOutcome outcome = rules.scoreRound(rolls, n, table.state, table.bonus.data());
+            TimelineNode* next = arena.extend(node, outcome.winner);
+            for (size_t i = 0; i < n; ++i) {
+                int score = node->entries[i].score + rules.rollPoints(rolls[i]) + table.bonus[i];
+                next->entries[i] = {score, node->entries[i].wins + (outcome.winner == static_cast<int>(i) ? 1 : 0),
+                                    rolls[i], table.state.alive[i] != 0};
+                topScore = max(topScore, score);
+            }
+            node = next;
+        }
+        return node;
+    }
+
+public:
+    // forkRound 0 replays the second half of the base game.
+    WhatIfRunner(const SimulationConfig& simConfig, int forkRound, uint64_t branches)
+        : config(simConfig), rules(simConfig.rules, simConfig.sides), fromRound(forkRound), branchCount(branches),
+          base(simConfig.engine, simConfig.seed) {
+        if (config.threads == 0) config.threads = max(1u, thread::hardware_concurrency());
+        base.configure(config.sides, config.rules);
+        for (int i = 0; i < config.players; ++i) base.addPlayer("Player " + to_string(i + 1));
+        base.reserveRounds();
+        while (!base.isFinished()) {
+            for (int i = 0; i < config.players; ++i) {
+                if (base.isInGame(i)) base.rollFor(i);
+            }
+            base.resolveRound();
+        }
+        if (fromRound == 0) fromRound = (getBaseRounds() + 1) / 2;
+        fork = GameTimeline::ancestor(base.getTimeline().getHead(), fromRound - 1);
+        baseWinner = base.gameWinner();
+    }
+
+    const SimulationConfig& getConfig() const { return config; }
+    int getFromRound() const { return fromRound; }
+    int getBaseRounds() const { return base.getCurrentRound() - 1; }
+    const TimelineNode* getFork() const { return fork; }  // null when the base game was over by then
+    const TimelineNode* getBaseFinal() const { return base.getTimeline().getHead(); }
+    int getBaseWinner() const { return baseWinner; }
+
+    WhatIfResult run() const {
+        uint64_t chunks = (branchCount + BRANCHES_PER_CHUNK - 1) / BRANCHES_PER_CHUNK;
+        unsigned workers = static_cast<unsigned>(min<uint64_t>(config.threads, max<uint64_t>(chunks, 1)));
+        WorkStealingQueue queue(chunks, workers);
+        vector<WhatIfResult> partials(workers);
+
+        auto worker = [&](unsigned self) {
+            WhatIfResult& local = partials[self];
+            local.seatWins.assign(config.players, 0);
+            local.scoreSums.assign(config.players, 0.0);
+            GameTimeline arena(config.players);
+            arena.reserve(static_cast<size_t>(getBaseRounds() - fromRound + 1));
+            HeadlessTable table(config.players);
+            uint64_t chunk;
+            while (queue.take(self, chunk)) {
+                uint64_t last = min(branchCount, (chunk + 1) * BRANCHES_PER_CHUNK);
+                for (uint64_t b = chunk * BRANCHES_PER_CHUNK; b < last; ++b) {
+                    const TimelineNode* leaf = playBranch(b, arena, table);
+                    int winner = rules.gameWinner(table.scores.size(), table.state,
+                                                  [&](size_t i) { return leaf->entries[i].score; });
+                    local.branches++;
+                    if (winner < 0) {
+                        local.ties++;
+                    } else {
+                        local.seatWins[winner]++;
+                        if (winner == baseWinner) local.heldWinner++;
+                    }
+                    for (int i = 0; i < config.players; ++i) local.scoreSums[i] += leaf->entries[i].score;
+                }
+            }
+        };
+
+        vector<thread> pool;
+        for (unsigned w = 1; w < workers; ++w) pool.emplace_back(worker, w);
+        worker(0);
+        for (auto& t : pool) t.join();
+
+        WhatIfResult total;
+        total.seatWins.assign(config.players, 0);
+        total.scoreSums.assign(config.players, 0.0);
+        for (const auto& partial : partials) total.merge(partial);
+        return total;
+    }
+};
+
+void printWhatIfReport(const WhatIfRunner& runner, const WhatIfResult& result, double seconds) {
+    const SimulationConfig& config = runner.getConfig();
+    const TimelineNode* fork = runner.getFork();
+    const TimelineNode* final = runner.getBaseFinal();
+    cout << BOLD << CYAN << "============================================\n";
+    cout << "          WHAT-IF REPORT\n";
+    cout << "============================================\n" << RESET;
+    cout << "Mode: " << gameModeName(config.rules.mode) << " | Players: " << config.players << " | Dice: "
+         << config.sides << "-sided | Rounds: " << runner.getBaseRounds() << " | RNG: "
+         << rngEngineName(config.engine) << " | Seed: " << config.seed << "\n";
+    if (!config.rules.plainScoring()) cout << "Rules: " << formatRuleSpec(config.rules) << "\n";
+    cout << "Branches: " << result.branches << " replaying from round " << runner.getFromRound()
+         << " on " << config.threads << " thread(s) in " << fixed << setprecision(2) << seconds << "s ("
+         << setprecision(0) << (seconds > 0 ? result.branches / seconds : 0.0) << " branches/s)\n";
+
+    cout << BOLD << YELLOW << "\nBase Game:\n" << RESET;
+    for (int i = 0; i < config.players; ++i) {
+        cout << "Player " << setw(2) << left << i + 1 << right << ": " << setw(5) << fork->entries[i].score
+             << " after round " << fork->round << ", " << setw(5) << final->entries[i].score << " final"
+             << (runner.getBaseWinner() == i ? "  (winner)" : "") << "\n";
+    }
+    if (runner.getBaseWinner() < 0) cout << "The base game ended in a tie\n";
+    if (result.branches == 0) return;
+
+    cout << BOLD << YELLOW << "\nAcross Branches:\n" << RESET;
+    for (int i = 0; i < config.players; ++i) {
+        cout << "Player " << setw(2) << left << i + 1 << right << ": wins " << setw(7) << setprecision(3)
+             << 100.0 * result.seatWins[i] / result.branches << "% | mean final score " << setprecision(2)
+             << result.scoreSums[i] / result.branches << "\n";
+    }
+    cout << "Tie rate : " << setw(7) << setprecision(3) << 100.0 * result.ties / result.branches << "%\n";
+    if (runner.getBaseWinner() >= 0) {
+        cout << "Base winner held on in " << setprecision(3) << 100.0 * result.heldWinner / result.branches
+             << "% of branches\n";
+    }
+}
+
+const size_t FAIRNESS_BINS = 64;             // run and gap lengths at or past the last bin share it
+const uint64_t FAIRNESS_CHUNK = uint64_t(1) << 22;  // rolls per work item, one RNG stream each
+const double FAIRNESS_ALPHA = 1e-4;          // p-values below this are flagged
+
+// Everything the fairness tests need from a stream of rolls, in fixed-size
+// tables so threads can keep their own and merge at the end.
+struct FairnessTally {
+    uint64_t rolls = 0;
+    array<uint64_t, 16> faces{};
+    array<uint64_t, 256> pairs{};  // non-overlapping (first, second) pairs, first * 16 + second
+    array<uint64_t, FAIRNESS_BINS> runs{};  // index = length of a run of one face - 1
+    array<uint64_t, FAIRNESS_BINS> gaps{};  // index = rolls between two low faces
+
+    void merge(const FairnessTally& other) {
+        rolls += other.rolls;
+        for (size_t i = 0; i < faces.size(); ++i) faces[i] += other.faces[i];
+        for (size_t i = 0; i < pairs.size(); ++i) pairs[i] += other.pairs[i];
+        for (size_t i = 0; i < FAIRNESS_BINS; ++i) runs[i] += other.runs[i];
+        for (size_t i = 0; i < FAIRNESS_BINS; ++i) gaps[i] += other.gaps[i];
+    }
+};
+
+struct FairnessTest {
+    double statistic = 0.0;
+    int degrees = 0;
+    double pValue = 1.0;
+};
+
+struct FairnessReport {
+    int sides = 0;
+    uint64_t rolls = 0;
+    FairnessTest frequency, serial, runs, gaps;
+
+    bool passed() const {
+        return min(min(frequency.pValue, serial.pValue), min(runs.pValue, gaps.pValue)) >= FAIRNESS_ALPHA;
+    }
+};
+
+FairnessTest chiSquare(const vector<double>& observed, const vector<double>& expected) {
+    FairnessTest test;
+    for (size_t i = 0; i < observed.size(); ++i) {
+        double difference = observed[i] - expected[i];
+        test.statistic += difference * difference / expected[i];
+    }
+    test.degrees = static_cast<int>(observed.size()) - 1;
+    test.pValue = chiSquarePValue(test.statistic, test.degrees);
+    return test;
+}
+
+// Chi-square of a geometric length histogram: P(length index i) =
+// (1 - q) q^i. Bins stop where the tail would expect fewer than five
+// counts, and everything past that point is pooled into the tail.
+FairnessTest geometricChiSquare(const array<uint64_t, FAIRNESS_BINS>& counts, double q) {
+    uint64_t total = accumulate(counts.begin(), counts.end(), uint64_t(0));
+    size_t bins = 1;
+    while (bins < FAIRNESS_BINS - 1 && total * realPower(q, static_cast<int>(bins + 1)) >= 5.0) bins++;
+
+    vector<double> observed, expected;
+    for (size_t i = 0; i < bins; ++i) {
+        observed.push_back(double(counts[i]));
+        expected.push_back(total * (1.0 - q) * realPower(q, static_cast<int>(i)));
+    }
+    observed.push_back(double(accumulate(counts.begin() + bins, counts.end(), uint64_t(0))));
+    expected.push_back(total * realPower(q, static_cast<int>(bins)));
+    return chiSquare(observed, expected);
+}
+
+FairnessReport evaluateFairness(int sides, const FairnessTally& tally) {
+    FairnessReport report;
+    report.sides = sides;
+    report.rolls = tally.rolls;
+
+    vector<double> observed, expected;
+    for (int face = 1; face <= sides; ++face) {
+        observed.push_back(double(tally.faces[face]));
+        expected.push_back(double(tally.rolls) / sides);
+    }
+    report.frequency = chiSquare(observed, expected);
+
+    observed.clear();
+    expected.clear();
+    uint64_t pairs = 0;
+    for (int first = 1; first <= sides; ++first) {
+        for (int second = 1; second <= sides; ++second) pairs += tally.pairs[first * 16 + second];
+    }
+    for (int first = 1; first <= sides; ++first) {
+        for (int second = 1; second <= sides; ++second) {
+            observed.push_back(double(tally.pairs[first * 16 + second]));
+            expected.push_back(double(pairs) / (sides * sides));
+        }
+    }
+    report.serial = chiSquare(observed, expected);
+
+    // A run continues with probability 1/s; a gap between low faces
+    // (1..s/2) continues with the chance of a high face.
+    report.runs = geometricChiSquare(tally.runs, 1.0 / sides);
+    report.gaps = geometricChiSquare(tally.gaps, double(sides - sides / 2) / sides);
+    return report;
+}
+
+// Streams rolls through the game's own Die<Sides> kernels and tallies
+// them without keeping any. Each chunk of FAIRNESS_CHUNK rolls draws from
+// its own RNG stream, so the result does not depend on the thread count.
+class FairnessHarness {
+private:
+    RngEngine engine;
+    uint64_t seed;
+    uint64_t rollsPerDie;
+    unsigned threads;
+
+    void tallyChunk(const DieKernels& die, uint64_t chunk, FairnessTally& tally, vector<uint8_t>& block) const {
+        DiceRng rng(engine, seed ^ (uint64_t(die.sides) << 56), chunk);
+        uint64_t first = chunk * FAIRNESS_CHUNK;
+        uint64_t count = min(FAIRNESS_CHUNK, rollsPerDie - first);
+        const int low = die.sides / 2;
+
+        // Runs and gaps carry across blocks but not across chunks: the
+        // last, unfinished run or gap of a chunk is dropped, and so is the
+        // stretch before its first low face.
+        int previous = -1;
+        size_t run = 0, gap = 0;
+        bool seenLow = false;
+        for (uint64_t done = 0; done < count; done += block.size()) {
+            size_t n = static_cast<size_t>(min<uint64_t>(block.size(), count - done));
+            die.rollMany(rng, block.data(), n);
+            for (size_t i = 0; i < n; ++i) {
+                int face = block[i];
+                tally.faces[face]++;
+                if (i & 1) tally.pairs[block[i - 1] * 16 + face]++;
+                if (face == previous) {
+                    run++;
+                } else {
+                    if (run > 0) tally.runs[min(run - 1, FAIRNESS_BINS - 1)]++;
+                    run = 1;
+                    previous = face;
+                }
+                if (face <= low) {
+                    if (seenLow) tally.gaps[min(gap, FAIRNESS_BINS - 1)]++;
+                    seenLow = true;
+                    gap = 0;
+                } else {
+                    gap++;
+                }
+            }
+        }
+        tally.rolls += count;
+    }
+
+public:
+    FairnessHarness(RngEngine rngEngine, uint64_t rngSeed, uint64_t rolls, unsigned threadCount)
+        : engine(rngEngine), seed(rngSeed), rollsPerDie(rolls),
+          threads(threadCount ? threadCount : max(1u, thread::hardware_concurrency())) {}
+
+    unsigned getThreads() const { return threads; }
+
+    FairnessReport run(int sides) const {
+        const DieKernels& die = *dieKernels(sides);
+        uint64_t chunks = (rollsPerDie + FAIRNESS_CHUNK - 1) / FAIRNESS_CHUNK;
+        unsigned workers = static_cast<unsigned>(min<uint64_t>(threads, max<uint64_t>(chunks, 1)));
+        WorkStealingQueue queue(chunks, workers);
+        vector<FairnessTally> partials(workers);
+
+        auto worker = [&](unsigned self) {
+            vector<uint8_t> block(ROLL_EXPORT_CHUNK);  // even, so pairs never straddle blocks
+            uint64_t chunk;
+            while (queue.take(self, chunk)) tallyChunk(die, chunk, partials[self], block);
+        };
+        vector<thread> pool;
+        for (unsigned w = 1; w < workers; ++w) pool.emplace_back(worker, w);
+        worker(0);
+        for (auto& t : pool) t.join();
+
+        FairnessTally total;
+        for (const auto& partial : partials) total.merge(partial);
+        return evaluateFairness(sides, total);
+    }
+};
+
+void printFairnessHeader(RngEngine engine, uint64_t rolls, unsigned threads) {
+    cout << BOLD << CYAN << "============================================\n";
+    cout << "          FAIRNESS REPORT\n";
+    cout << "============================================\n" << RESET;
+    cout << "RNG: " << rngEngineName(engine) << " | Rolls per die: " << rolls << " | Threads: " << threads << "\n";
+    cout << "Tests: chi-square frequency, serial pairs, runs of one face, gaps between low faces\n";
+    cout << "p-values below " << FAIRNESS_ALPHA << " are flagged\n\n";
+    cout << BOLD << setw(6) << "Sides" << setw(12) << "Frequency" << setw(12) << "Serial" << setw(12) << "Runs"
+         << setw(12) << "Gaps" << setw(10) << "Verdict" << RESET << "\n";
+}
+
+void printFairnessRow(const FairnessReport& report) {
+    cout << setw(6) << report.sides << defaultfloat << setprecision(4);
+    for (const FairnessTest* test : {&report.frequency, &report.serial, &report.runs, &report.gaps}) {
+        if (test->pValue < FAIRNESS_ALPHA) cout << RED << setw(12) << test->pValue << RESET;
+        else cout << setw(12) << test->pValue;
+    }
+    cout << setw(10) << (report.passed() ? "pass" : "FAIL") << "\n";
+}
+
+enum class TournamentFormat { League = 1, Bracket = 2 };
+
+const char* tournamentFormatName(TournamentFormat format) {
+    return format == TournamentFormat::Bracket ? "Bracket" : "League";
+}
+
+struct TournamentConfig {
+    TournamentFormat format = TournamentFormat::League;
+    uint32_t entrants = 0;
+    int tableSize = 4;   // league entrants per table
+    int rounds = 10;     // league rounds; a bracket runs until one entrant is left
+    int sides = 6;
+    unsigned threads = 0;
+    uint64_t seed = 0;
+    RngEngine engine = RngEngine::Philox;
+    size_t top = 10;
+};
+
+// Entrant state as parallel arrays indexed by entrant ID, so a round touches
+// a few dense columns instead of whole player objects and names.
+struct TournamentStore {
+    vector<int64_t> scores;
+    vector<uint32_t> wins;
+    vector<uint8_t> best;
+    vector<uint32_t> survived;  // bracket rounds won
+
+    explicit TournamentStore(uint32_t entrants)
+        : scores(entrants, 0), wins(entrants, 0), best(entrants, 0), survived(entrants, 0) {}
+
+    size_t size() const { return scores.size(); }
+};
+
+struct LeaderboardEntry {
+    uint32_t id;
+    uint32_t rank;  // wins in a league, rounds survived in a bracket
+    int64_t score;
+};
+
+// Bounded top-k kept as a heap whose front is the weakest entry, so offering
+// an entrant costs O(log k) and most offers are rejected after one compare.
+class Leaderboard {
+private:
+    size_t capacity;
+    vector<LeaderboardEntry> heap;
+
+    static bool better(const LeaderboardEntry& a, const LeaderboardEntry& b) {
+        if (a.rank != b.rank) return a.rank > b.rank;
+        if (a.score != b.score) return a.score > b.score;
+        return a.id < b.id;
+    }
+
+public:
+    explicit Leaderboard(size_t k = 10) : capacity(k) { heap.reserve(k); }
+
+    void offer(const LeaderboardEntry& entry) {
+        if (heap.size() < capacity) {
+            heap.push_back(entry);
+            push_heap(heap.begin(), heap.end(), better);
+        } else if (capacity > 0 && better(entry, heap.front())) {
+            pop_heap(heap.begin(), heap.end(), better);
+            heap.back() = entry;
+            push_heap(heap.begin(), heap.end(), better);
+        }
+    }
+
+    void merge(const Leaderboard& other) {
+        for (const auto& entry : other.heap) offer(entry);
+    }
+
+    const vector<LeaderboardEntry>& entries() const { return heap; }
+
+    vector<LeaderboardEntry> ranked() const {
+        vector<LeaderboardEntry> order = heap;
+        sort(order.begin(), order.end(), better);
+        return order;
+    }
+};
+
+struct TournamentRound {
+    uint32_t entrants;
+    double seconds;
+    LeaderboardEntry leader;
+};
+
+// Runs a league or single-elimination bracket. Each round is split into
+// fixed chunks of tables or matches with their own RNG stream, so results
+// depend only on the seed, never on the thread count; worker threads pull
+// chunks from a work-stealing queue and keep a local top-k that is merged
+// once the round is done.
+class Tournament {
+private:
+    static const uint32_t TABLES_PER_CHUNK = 4096;
+
+    TournamentConfig config;
+    TournamentStore store;
+    const DieKernels& die;
+    vector<uint32_t> seating;  // league table order, or bracket entrants still in
+    Leaderboard leaders;
+    vector<TournamentRound> history;
+    uint64_t rolls;
+
+    DiceRng streamFor(uint32_t round, uint64_t chunk) const {
+        return DiceRng(config.engine, config.seed, (uint64_t(round) << 32) | chunk);
+    }
+
+    LeaderboardEntry entryFor(uint32_t id) const {
+        uint32_t rank = config.format == TournamentFormat::League ? store.wins[id] : store.survived[id];
+        return {id, rank, store.scores[id]};
+    }
+
+    void record(uint32_t id, int roll) {
+        store.scores[id] += roll;
+        store.best[id] = max<uint8_t>(store.best[id], static_cast<uint8_t>(roll));
+    }
+
+    template <typename ResolveChunk>
+    Leaderboard runParallel(uint64_t chunks, const ResolveChunk& resolve) {
+        unsigned workers = static_cast<unsigned>(min<uint64_t>(config.threads, max<uint64_t>(chunks, 1)));
+        WorkStealingQueue queue(chunks, workers);
+        vector<Leaderboard> local(workers, Leaderboard(config.top));
+        vector<uint64_t> drawn(workers, 0);
+        auto worker = [&](unsigned self) {
+            vector<uint8_t> faces;
+            uint64_t chunk;
+            while (queue.take(self, chunk)) drawn[self] += resolve(chunk, faces, local[self]);
+        };
+        vector<thread> pool;
+        for (unsigned w = 1; w < workers; ++w) pool.emplace_back(worker, w);
+        worker(0);
+        for (auto& t : pool) t.join();
+
+        Leaderboard merged(config.top);
+        for (unsigned w = 0; w < workers; ++w) {
+            merged.merge(local[w]);
+            rolls += drawn[w];
+        }
+        return merged;
+    }
+
+    // Reseats everyone, then every table rolls once: the single highest roll
+    // takes the table, a shared highest roll means no winner.
+    void playLeagueRound(uint32_t round) {
+        DiceRng shuffler = streamFor(round, ~uint32_t(0));
+        for (uint32_t i = static_cast<uint32_t>(seating.size()) - 1; i > 0; --i) {
+            swap(seating[i], seating[shuffler.roll(static_cast<int>(i + 1)) - 1]);
+        }
+        const uint32_t seats = static_cast<uint32_t>(seating.size());
+        const uint32_t tableSize = static_cast<uint32_t>(config.tableSize);
+        const uint64_t tables = (seats + tableSize - 1) / tableSize;
+        const uint64_t chunks = (tables + TABLES_PER_CHUNK - 1) / TABLES_PER_CHUNK;
+
+        leaders = runParallel(chunks, [&](uint64_t chunk, vector<uint8_t>& faces, Leaderboard& board) {
+            uint64_t first = chunk * TABLES_PER_CHUNK * tableSize;
+            uint64_t last = min<uint64_t>(seats, first + uint64_t(TABLES_PER_CHUNK) * tableSize);
+            faces.resize(last - first);
+            DiceRng rng = streamFor(round, chunk);
+            die.rollMany(rng, faces.data(), faces.size());
+            for (uint64_t table = first; table < last; table += tableSize) {
+                uint64_t end = min<uint64_t>(last, table + tableSize);
+                int highest = 0, holders = 0;
+                uint32_t winner = 0;
+                for (uint64_t seat = table; seat < end; ++seat) {
+                    int roll = faces[seat - first];
+                    record(seating[seat], roll);
+                    if (roll > highest) {
+                        highest = roll;
+                        holders = 1;
+                        winner = seating[seat];
+                    } else if (roll == highest) {
+                        holders++;
+                    }
+                }
+                if (holders == 1 && end - table > 1) store.wins[winner]++;
+                for (uint64_t seat = table; seat < end; ++seat) board.offer(entryFor(seating[seat]));
+            }
+            return uint64_t(last - first);
+        });
+    }
+
+    // Pairs neighbours in the bracket; ties are rolled again. An odd entrant
+    // out gets a bye and moves to the front, so the same seat is not handed
+    // byes round after round; the winner of match m takes the slot after it.
+    void playBracketRound(uint32_t round) {
+        const uint64_t matches = seating.size() / 2;
+        const uint64_t chunks = max<uint64_t>(1, (matches + TABLES_PER_CHUNK - 1) / TABLES_PER_CHUNK);
+        const uint64_t byes = seating.size() % 2;
+        vector<uint32_t> next(matches + byes);
+        if (byes) {
+            uint32_t bye = seating.back();
+            store.survived[bye]++;
+            next.front() = bye;
+        }
+
+        Leaderboard board = runParallel(chunks, [&](uint64_t chunk, vector<uint8_t>& faces, Leaderboard& local) {
+            uint64_t first = chunk * TABLES_PER_CHUNK;
+            uint64_t last = min<uint64_t>(matches, first + TABLES_PER_CHUNK);
+            faces.resize(2 * (last - first));
+            DiceRng rng = streamFor(round, chunk);
+            die.rollMany(rng, faces.data(), faces.size());
+            uint64_t drawn = faces.size();
+            for (uint64_t m = first; m < last; ++m) {
+                uint32_t a = seating[2 * m], b = seating[2 * m + 1];
+                int rollA = faces[2 * (m - first)], rollB = faces[2 * (m - first) + 1];
+                record(a, rollA);
+                record(b, rollB);
+                while (rollA == rollB) {
+                    rollA = die.roll(rng);
+                    rollB = die.roll(rng);
+                    record(a, rollA);
+                    record(b, rollB);
+                    drawn += 2;
+                }
+                uint32_t winner = rollA > rollB ? a : b;
+                store.wins[winner]++;
+                store.survived[winner]++;
+                next[m + byes] = winner;
+                local.offer(entryFor(a));
+                local.offer(entryFor(b));
+            }
+            return drawn;
+        });
+        if (byes) board.offer(entryFor(seating.back()));
+
+        // Entrants knocked out earlier did not change; carry them over from
+        // the previous board instead of rescanning everyone.
+        for (const auto& entry : leaders.entries()) {
+            if (store.survived[entry.id] < round - 1) board.offer(entry);
+        }
+        leaders = board;
+        seating.swap(next);
+    }
+
+public:
+    explicit Tournament(const TournamentConfig& tournamentConfig)
+        : config(tournamentConfig), store(tournamentConfig.entrants), die(*dieKernels(tournamentConfig.sides)),
+          leaders(tournamentConfig.top), rolls(0) {
+        if (config.threads == 0) config.threads = max(1u, thread::hardware_concurrency());
+        seating.resize(config.entrants);
+        iota(seating.begin(), seating.end(), 0u);
+    }
+
+    void run() {
+        uint32_t round = 1;
+        while (config.format == TournamentFormat::League ? round <= static_cast<uint32_t>(config.rounds)
+                                                          : seating.size() > 1) {
+            uint32_t playing = static_cast<uint32_t>(seating.size());
+            auto start = chrono::steady_clock::now();
+            if (config.format == TournamentFormat::League) {
+                playLeagueRound(round);
+            } else {
+                playBracketRound(round);
+            }
+            double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            vector<LeaderboardEntry> order = leaders.ranked();
+            history.push_back({playing, seconds, order.empty() ? LeaderboardEntry{0, 0, 0} : order.front()});
+            round++;
+        }
+    }
+
+    const TournamentConfig& getConfig() const { return config; }
+    const TournamentStore& getStore() const { return store; }
+    const vector<TournamentRound>& getHistory() const { return history; }
+    vector<LeaderboardEntry> standings() const { return leaders.ranked(); }
+    uint64_t getRolls() const { return rolls; }
+};
+
+void printTournamentReport(const Tournament& tournament, double seconds) {
+    const TournamentConfig& config = tournament.getConfig();
+    const TournamentStore& store = tournament.getStore();
+    bool league = config.format == TournamentFormat::League;
+    cout << BOLD << CYAN << "============================================\n";
+    cout << "          TOURNAMENT REPORT\n";
+    cout << "============================================\n" << RESET;
+    cout << "Format: " << tournamentFormatName(config.format) << " | Entrants: " << config.entrants
+         << " | Dice: " << config.sides << "-sided | RNG: " << rngEngineName(config.engine);
+    if (league) cout << " | Tables of " << config.tableSize;
+    cout << "\nPlayed " << tournament.getHistory().size() << " round(s) on " << config.threads << " thread(s) in "
+         << fixed << setprecision(2) << seconds << "s (" << setprecision(0)
+         << (seconds > 0 ? tournament.getRolls() / seconds : 0.0) << " rolls/s)\n";
+
+    cout << BOLD << YELLOW << "\nRounds:\n" << RESET;
+    uint32_t round = 1;
+    for (const auto& r : tournament.getHistory()) {
+        cout << "Round " << setw(3) << round++ << ": " << setw(8) << r.entrants << " entrants, "
+             << setprecision(1) << setw(8) << r.seconds * 1000.0 << " ms | leader #" << r.leader.id + 1
+             << " (" << r.leader.rank << (league ? " wins, " : " rounds won, ") << r.leader.score << " pts)\n";
+    }
+
+    vector<LeaderboardEntry> standings = tournament.standings();
+    if (!league && !standings.empty()) {
+        cout << BOLD << GREEN << "\nChampion: Entrant #" << standings.front().id + 1 << "\n" << RESET;
+    }
+    cout << BOLD << YELLOW << "\nTop " << standings.size() << ":\n" << RESET;
+    cout << "┌──────┬────────────────┬────────┬──────────┬──────┐\n";
+    cout << "│ Rank │ Entrant        │ " << (league ? "Wins  " : "Rounds") << " │ Score    │ Best │\n";
+    cout << "├──────┼────────────────┼────────┼──────────┼──────┤\n";
+    for (size_t i = 0; i < standings.size(); ++i) {
+        const LeaderboardEntry& entry = standings[i];
+        cout << "│ " << setw(4) << right << i + 1 << " │ "
+             << setw(14) << left << "Entrant #" + to_string(entry.id + 1) << " │ "
+             << setw(6) << right << entry.rank << " │ "
+             << setw(8) << right << entry.score << " │ "
+             << setw(4) << right << int(store.best[entry.id]) << " │\n";
+    }
+    cout << "└──────┴────────────────┴────────┴──────────┴──────┘\n";
 }
-    void showGameRules() {
-        displayHeader("GAME RULES");
-        
-        cout << BOLD << YELLOW << "🌟 Game Modes 🌟\n" << RESET;
-        cout << "1. " << BOLD << "Classic Mode:" << RESET << " Highest roll each round wins\n";
-        cout << "2. " << BOLD << "Target Mode:" << RESET << " First to reach target score wins\n";
-        cout << "3. " << BOLD << "Elimination:" << RESET << " Players with lowest rolls are eliminated\n\n";
-        
-        cout << BOLD << YELLOW << "🎲 Dice Mechanics 🎲\n" << RESET;
-        cout << "- Dice can have 4-12 sides\n";
-        cout << "- Special dice rolls (doubles, triples) may trigger bonuses\n";
-        cout << "- Consecutive wins grant multiplier bonuses\n\n";
-        
-        cout << BOLD << YELLOW << "🏆 Scoring System 🏆\n" << RESET;
-        cout << "- Round winner gets points equal to their roll\n";
-        cout << "- 2x points for back-to-back wins\n";
-        cout << "- 5x bonus for rolling the maximum possible value\n\n";
-        
-        cout << "Press Enter to continue...";
-        cin.ignore();
-        cin.get();
+
+#ifdef __linux__
+// Line protocol spoken by --server:
+//   NEW <sides> <rounds>   -> OK <session>
+//   JOIN <session> <name>  -> OK <seat>      (name: one word, no ':')
+//   ROLL <session> <seat>  -> ROLL <value> [ROUND <n> WINNER <seat|-1>] [END]
+//   STATE <session>        -> STATE <round> <rounds> <next seat> <players> [<name>:<score>:<wins> ...]
+//   QUIT
+// Errors come back as "ERR <reason>". Requests may be pipelined. A session
+// is freed once its last roll has been answered with END, when the
+// connection that opened it closes, or after it sits idle for too long.
+const size_t SESSIONS_PER_SHARD = 4096;
+const chrono::steady_clock::duration SESSION_IDLE_TIMEOUT = chrono::minutes(10);
+
+class SessionTable {
+private:
+    struct Hosted {
+        unique_ptr<GameSession> session;
+        chrono::steady_clock::time_point lastUsed;
+    };
+    struct Shard {
+        mutex lock;
+        unordered_map<uint64_t, Hosted> sessions;
+        chrono::steady_clock::time_point lastSweep;
+    };
+    vector<Shard> shards;
+    atomic<uint64_t> nextId;
+    RngEngine engine;
+    uint64_t seed;
+    size_t shardCapacity;
+    chrono::steady_clock::duration idleTimeout;
+
+    // Drops the shard's sessions that have not been used for idleTimeout.
+    void expire(Shard& shard, chrono::steady_clock::time_point now) {
+        for (auto it = shard.sessions.begin(); it != shard.sessions.end();) {
+            if (now - it->second.lastUsed >= idleTimeout) it = shard.sessions.erase(it);
+            else ++it;
+        }
+        shard.lastSweep = now;
     }
 
 public:
-    DiceGame() : rounds(0), currentRound(0), diceSides(6), gameSaved(false) {
-        rng.seed(random_device()());
+    SessionTable(size_t shardCount, RngEngine rngEngine, uint64_t baseSeed,
+                 size_t sessionsPerShard = SESSIONS_PER_SHARD,
+                 chrono::steady_clock::duration idleLimit = SESSION_IDLE_TIMEOUT)
+        : shards(shardCount), nextId(1), engine(rngEngine), seed(baseSeed), shardCapacity(sessionsPerShard),
+          idleTimeout(idleLimit) {}
+
+    // Runs fn on the session under its shard lock; false if it does not exist.
+    template <typename Fn>
+    bool with(uint64_t id, Fn&& fn) {
+        Shard& shard = shards[id % shards.size()];
+        lock_guard<mutex> guard(shard.lock);
+        auto it = shard.sessions.find(id);
+        if (it == shard.sessions.end()) return false;
+        it->second.lastUsed = chrono::steady_clock::now();
+        fn(*it->second.session);
+        return true;
     }
 
-    void setupGame() {
-        displayHeader("GAME SETUP");
-        
-        cout << BOLD << "Select Game Mode:\n" << RESET;
-        cout << "1. Classic Mode (Highest roll wins)\n";
-        cout << "2. Target Score Mode\n";
-        cout << "3. Elimination Mode\n";
-        cout << "Enter choice: ";
-        
-        int mode;
-        while (!(cin >> mode) || mode < 1 || mode > 3) {
-            cin.clear();
-            cin.ignore(numeric_limits<streamsize>::max(), '\n');
-            cout << RED << "Invalid choice! Enter 1-3: " << RESET;
+    // Opens a session, or returns 0 when its shard is still full after the
+    // idle sessions in it have expired. Shards are swept at most every
+    // quarter of the idle timeout, so a full table costs no scan per NEW.
+    uint64_t create(int sides, int rounds) {
+        uint64_t id = nextId++;
+        Shard& shard = shards[id % shards.size()];
+        auto now = chrono::steady_clock::now();
+        lock_guard<mutex> guard(shard.lock);
+        if (now - shard.lastSweep >= idleTimeout / 4) expire(shard, now);
+        if (shard.sessions.size() >= shardCapacity) return 0;
+        auto session = make_unique<GameSession>(engine, seed, id, false);
+        session->configure(sides, rounds);
+        shard.sessions.emplace(id, Hosted{move(session), now});
+        return id;
+    }
+
+    void erase(uint64_t id) {
+        Shard& shard = shards[id % shards.size()];
+        lock_guard<mutex> guard(shard.lock);
+        shard.sessions.erase(id);
+    }
+
+    size_t size() {
+        size_t total = 0;
+        for (auto& shard : shards) {
+            lock_guard<mutex> guard(shard.lock);
+            total += shard.sessions.size();
         }
-        
-        int numPlayers;
-        cout << "\n" << BOLD << "Number of Players (2-4): " << RESET;
-        while (!(cin >> numPlayers) || numPlayers < 2 || numPlayers > 4) {
-            cin.clear();
-            cin.ignore(numeric_limits<streamsize>::max(), '\n');
-            cout << RED << "Invalid input! Enter 2-4: " << RESET;
+        return total;
+    }
+};
+
+// Answers one request line. owned lists the sessions this connection opened,
+// which the server frees when the connection closes.
+void handleRequest(SessionTable& table, const string& line, string& reply, vector<uint64_t>& owned) {
+    ScopedTimer timer(Metric::ServerRequest);
+    istringstream request(line);
+    string command;
+    request >> command;
+    long long id = 0, a = 0, b = 0;
+
+    if (command == "NEW" && (request >> a >> b) && a >= 4 && a <= 12 && b >= 1 && b <= 1000000000) {
+        uint64_t session = table.create(static_cast<int>(a), static_cast<int>(b));
+        if (session == 0) {
+            reply += "ERR too many sessions\n";
+            return;
         }
-        
-        cin.ignore();
-        players.clear();
-        for (int i = 0; i < numPlayers; ++i) {
-            cout << "Player " << i+1 << " name: ";
-            string name;
-            getline(cin, name);
-            if (name.empty()) name = "Player " + to_string(i+1);
-            players.emplace_back(name);
+        owned.push_back(session);
+        reply += "OK " + to_string(session) + "\n";
+    } else if (command == "JOIN" && (request >> id)) {
+        string name;
+        request >> name;
+        if (name.empty() || name.size() > 32 || name.find(':') != string::npos) {
+            reply += "ERR bad name\n";
+            return;
         }
-        
-        cout << "\n" << BOLD << "Dice Sides (4-12): " << RESET;
-        while (!(cin >> diceSides) || diceSides < 4 || diceSides > 12) {
-            cin.clear();
-            cin.ignore(numeric_limits<streamsize>::max(), '\n');
-            cout << RED << "Invalid input! Enter 4-12: " << RESET;
+        bool found = table.with(id, [&](GameSession& session) {
+            if (session.getCurrentRound() != 1 || session.getNextSeat() != 0) {
+                reply += "ERR game already started\n";
+            } else if (session.getPlayers().size() >= 64) {
+                reply += "ERR table full\n";
+            } else {
+                reply += "OK " + to_string(session.addPlayer(name)) + "\n";
+            }
+        });
+        if (!found) reply += "ERR no such session\n";
+    } else if (command == "ROLL" && (request >> id >> a)) {
+        bool ended = false;
+        bool found = table.with(id, [&](GameSession& session) {
+            if (session.isFinished()) {
+                reply += "ERR game over\n";
+            } else if (session.getPlayers().size() < 2) {
+                reply += "ERR need 2 players\n";
+            } else if (a < 0 || static_cast<size_t>(a) != session.getNextSeat()) {
+                reply += "ERR not your turn\n";
+            } else {
+                reply += "ROLL " + to_string(session.rollFor(static_cast<size_t>(a)));
+                if (session.roundComplete()) {
+                    int round = session.getCurrentRound();
+                    RoundOutcome outcome = session.resolveRound();
+                    reply += " ROUND " + to_string(round) + " WINNER " + to_string(outcome.winner);
+                    ended = session.isFinished();
+                    if (ended) reply += " END";
+                }
+                reply += "\n";
+            }
+        });
+        if (!found) reply += "ERR no such session\n";
+        if (ended) {
+            table.erase(id);
+            owned.erase(remove(owned.begin(), owned.end(), static_cast<uint64_t>(id)), owned.end());
         }
-        
-        if (mode == 2) {  
-            int target;
-            cout << "\n" << BOLD << "Target Score (50-500): " << RESET;
-            while (!(cin >> target) || target < 50 || target > 500) {
-                cin.clear();
-                cin.ignore(numeric_limits<streamsize>::max(), '\n');
-                cout << RED << "Invalid input! Enter 50-500: " << RESET;
-            }
-            rounds = target;
-        } else {
-            cout << "\n" << BOLD << "Number of Rounds (3-20): " << RESET;
-            while (!(cin >> rounds) || rounds < 3 || rounds > 20) {
-                cin.clear();
-                cin.ignore(numeric_limits<streamsize>::max(), '\n');
-                cout << RED << "Invalid input! Enter 3-20: " << RESET;
+    } else if (command == "STATE" && (request >> id)) {
+        bool found = table.with(id, [&](GameSession& session) {
+            reply += "STATE " + to_string(session.getCurrentRound()) + " " + to_string(session.getRounds()) +
+                     " " + to_string(session.getNextSeat()) + " " + to_string(session.getPlayers().size());
+            for (const auto& player : session.getPlayers()) {
+                reply += " " + player.getName() + ":" + to_string(player.getScore()) + ":" +
+                         to_string(player.getWins());
             }
+            reply += "\n";
+        });
+        if (!found) reply += "ERR no such session\n";
+    } else {
+        reply += "ERR bad request\n";
+    }
+}
+
+struct Endpoint {
+    bool unixSocket = false;
+    string path;
+    string host = "127.0.0.1";
+    int port = 0;
+};
+
+bool parseEndpoint(const string& text, Endpoint& endpoint) {
+    long long port = 0;
+    if (text.compare(0, 5, "unix:") == 0 && text.size() > 5 && text.size() - 5 < sizeof(sockaddr_un::sun_path)) {
+        endpoint.unixSocket = true;
+        endpoint.path = text.substr(5);
+        return true;
+    }
+    if (text.compare(0, 4, "tcp:") == 0 && parseNumber(text.c_str() + 4, 1, 65535, port)) {
+        endpoint.port = static_cast<int>(port);
+        return true;
+    }
+    return false;
+}
+
+int openSocket(const Endpoint& endpoint, bool listening) {
+    int fd = socket(endpoint.unixSocket ? AF_UNIX : AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    int ok;
+    if (endpoint.unixSocket) {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        strncpy(address.sun_path, endpoint.path.c_str(), sizeof(address.sun_path) - 1);
+        if (listening) unlink(endpoint.path.c_str());
+        ok = listening ? ::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address))
+                       : connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+    } else {
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(static_cast<uint16_t>(endpoint.port));
+        inet_pton(AF_INET, endpoint.host.c_str(), &address.sin_addr);
+        int one = 1;
+        if (listening) setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        ok = listening ? ::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address))
+                       : connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+        if (ok == 0) setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+    if (ok != 0 || (listening && listen(fd, SOMAXCONN) != 0)) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// One epoll loop per worker thread. All workers wait on the shared listening
+// socket with EPOLLEXCLUSIVE, so each new connection wakes one worker and
+// stays on that worker for its lifetime.
+class DiceServer {
+private:
+    struct Connection {
+        string input;
+        string output;
+        vector<uint64_t> sessions;  // opened by this connection
+    };
+
+    SessionTable table;
+    int listener;
+    unsigned workers;
+
+    static void setNonBlocking(int fd) {
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    }
+
+    static bool flush(int fd, Connection& connection) {
+        while (!connection.output.empty()) {
+            ssize_t sent = send(fd, connection.output.data(), connection.output.size(), MSG_NOSIGNAL);
+            if (sent < 0) return errno == EAGAIN || errno == EWOULDBLOCK;
+            connection.output.erase(0, static_cast<size_t>(sent));
         }
-        
-        currentRound = 1;
+        return true;
     }
 
-    void playGame() {
-        while (currentRound <= rounds) {
-            displayHeader("ROUND " + to_string(currentRound));
-            displayScores();
-            
-            cout << BOLD << "\nRound Options:\n" << RESET;
-            cout << "1. Play Round\n";
-            cout << "2. Save Game\n";
-            cout << "3. Show Statistics\n";
-            cout << "4. Main Menu\n";
-            cout << "Enter choice: ";
-            
-            int choice;
-            cin >> choice;
-            
-            switch (choice) {
-                case 1: {
-                    vector<pair<string, int>> roundResults;
-                    
-                    for (auto& player : players) {
-                        displayHeader(player.getName() + "'s Turn");
-                        displayScores();
-                        
-                        cout << BOLD << player.getName() << ", ready to roll? (Press Enter)" << RESET;
-                        cin.ignore();
-                        cin.get();
-                        
-                        int roll = rollDiceWithAnimation();
-                        player.addToScore(roll);
-                        player.addToHistory(roll);
-                        roundResults.emplace_back(player.getName(), roll);
+    void serve() {
+        int epoll = epoll_create1(EPOLL_CLOEXEC);
+        epoll_event listen{};
+        listen.events = EPOLLIN | EPOLLEXCLUSIVE;
+        listen.data.fd = listener;
+        epoll_ctl(epoll, EPOLL_CTL_ADD, listener, &listen);
+
+        unordered_map<int, Connection> connections;
+        vector<epoll_event> events(256);
+        char buffer[16384];
+
+        while (true) {
+            int ready = epoll_wait(epoll, events.data(), static_cast<int>(events.size()), -1);
+            for (int e = 0; e < ready; ++e) {
+                int fd = events[e].data.fd;
+                if (fd == listener) {
+                    int client;
+                    while ((client = accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+                        int one = 1;
+                        setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+                        epoll_event event{};
+                        event.events = EPOLLIN | EPOLLRDHUP;
+                        event.data.fd = client;
+                        epoll_ctl(epoll, EPOLL_CTL_ADD, client, &event);
+                        connections[client];
                     }
-                    
-                    auto winner = max_element(roundResults.begin(), roundResults.end(),
-                        [](const pair<string, int>& a, const pair<string, int>& b) {
-                            return a.second < b.second;
-                        });
-                
-                    int tieCount = count_if(roundResults.begin(), roundResults.end(),
-                        [winner](const pair<string, int>& p) {
-                            return p.second == winner->second;
-                        });
-                    
-                    if (tieCount > 1) {
-                        cout << BOLD << YELLOW << "\nThis round is a tie!\n" << RESET;
+                    continue;
+                }
+
+                Connection& connection = connections[fd];
+                bool open = (events[e].events & (EPOLLERR | EPOLLHUP)) == 0;
+                while (open) {
+                    ssize_t received = recv(fd, buffer, sizeof(buffer), 0);
+                    if (received > 0) {
+                        connection.input.append(buffer, static_cast<size_t>(received));
                     } else {
-                        announceRoundWinner(winner->first, winner->second);
+                        open = received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+                        break;
                     }
-                    
-                    currentRound++;
-                    break;
                 }
-                case 2:
-                    saveGame();
-                    break;
-                case 3:
-                    showStatistics();
-                    break;
-                case 4:
-                    return;
-                default:
-                    cout << RED << "Invalid choice!\n" << RESET;
-                    this_thread::sleep_for(chrono::seconds(1));
+
+                size_t start = 0, end;
+                while ((end = connection.input.find('\n', start)) != string::npos) {
+                    string line = connection.input.substr(start, end - start);
+                    if (!line.empty() && line.back() == '\r') line.pop_back();
+                    start = end + 1;
+                    if (line == "QUIT") {
+                        open = false;
+                        break;
+                    }
+                    handleRequest(table, line, connection.output, connection.sessions);
+                }
+                connection.input.erase(0, start);
+                if (connection.input.size() > 4096) open = false;
+
+                if (open && flush(fd, connection)) {
+                    epoll_event event{};
+                    event.events = EPOLLIN | EPOLLRDHUP | (connection.output.empty() ? 0u : uint32_t(EPOLLOUT));
+                    event.data.fd = fd;
+                    epoll_ctl(epoll, EPOLL_CTL_MOD, fd, &event);
+                } else {
+                    flush(fd, connection);
+                    epoll_ctl(epoll, EPOLL_CTL_DEL, fd, nullptr);
+                    ::close(fd);
+                    for (uint64_t session : connection.sessions) table.erase(session);
+                    connections.erase(fd);
+                }
             }
         }
-        
-        showFinalResults();
     }
 
-    void showStatistics() {
-        displayHeader("GAME STATISTICS");
-        
-        if (players.empty()) {
-            cout << RED << "No game data available.\n" << RESET;
+public:
+    DiceServer(unsigned threadCount, RngEngine engine, uint64_t seed)
+        : table(max(threadCount, 1u) * 8, engine, seed), listener(-1), workers(max(threadCount, 1u)) {}
+
+    bool start(const Endpoint& endpoint) {
+        signal(SIGPIPE, SIG_IGN);
+        listener = openSocket(endpoint, true);
+        if (listener < 0) return false;
+        setNonBlocking(listener);
+        return true;
+    }
+
+    void run() {
+        vector<thread> pool;
+        for (unsigned w = 1; w < workers; ++w) pool.emplace_back([this]() { serve(); });
+        serve();
+    }
+};
+
+struct LoadResult {
+    vector<uint32_t> latencies;  // microseconds per ROLL round trip
+    uint64_t errors = 0;
+};
+
+bool sendLine(int fd, const string& line) {
+    size_t sent = 0;
+    while (sent < line.size()) {
+        ssize_t n = send(fd, line.data() + sent, line.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) return false;
+        sent += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool receiveLine(int fd, string& pending, string& line) {
+    char buffer[4096];
+    size_t end;
+    while ((end = pending.find('\n')) == string::npos) {
+        ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+        if (n <= 0) return false;
+        pending.append(buffer, static_cast<size_t>(n));
+    }
+    line = pending.substr(0, end);
+    pending.erase(0, end + 1);
+    return true;
+}
+
+// Each connection opens its own session with two seats and then rolls in
+// turn, timing every ROLL round trip.
+void runLoadClient(const Endpoint& endpoint, uint64_t rolls, LoadResult& result) {
+    int fd = openSocket(endpoint, false);
+    string pending, reply;
+    if (fd < 0 || !sendLine(fd, "NEW 6 1000000000\n") || !receiveLine(fd, pending, reply) ||
+        reply.compare(0, 3, "OK ") != 0) {
+        result.errors += rolls;
+        if (fd >= 0) ::close(fd);
+        return;
+    }
+    string session = reply.substr(3);
+    sendLine(fd, "JOIN " + session + " alpha\nJOIN " + session + " beta\n");
+    receiveLine(fd, pending, reply);
+    receiveLine(fd, pending, reply);
+
+    result.latencies.reserve(rolls);
+    for (uint64_t r = 0; r < rolls; ++r) {
+        auto start = chrono::steady_clock::now();
+        if (!sendLine(fd, "ROLL " + session + " " + to_string(r % 2) + "\n") || !receiveLine(fd, pending, reply)) {
+            result.errors += rolls - r;
+            break;
+        }
+        auto elapsed = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count();
+        if (reply.compare(0, 5, "ROLL ") != 0) result.errors++;
+        result.latencies.push_back(static_cast<uint32_t>(elapsed));
+    }
+    sendLine(fd, "QUIT\n");
+    ::close(fd);
+}
+
+int runLoadGenerator(const Endpoint& endpoint, unsigned connections, uint64_t rollsPerConnection) {
+    vector<LoadResult> results(connections);
+    auto start = chrono::steady_clock::now();
+    vector<thread> clients;
+    for (unsigned c = 0; c < connections; ++c) {
+        clients.emplace_back(runLoadClient, cref(endpoint), rollsPerConnection, ref(results[c]));
+    }
+    for (auto& client : clients) client.join();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    vector<uint32_t> all;
+    uint64_t errors = 0;
+    for (auto& result : results) {
+        all.insert(all.end(), result.latencies.begin(), result.latencies.end());
+        errors += result.errors;
+    }
+    cout << BOLD << CYAN << "Load test: " << connections << " connection(s), " << all.size() << " rolls in "
+         << fixed << setprecision(2) << seconds << "s (" << setprecision(0) << all.size() / seconds
+         << " rolls/s), " << errors << " error(s)\n" << RESET;
+    if (all.empty()) return 1;
+
+    auto percentile = [&](double p) {
+        size_t rank = min(all.size() - 1, static_cast<size_t>(p * (all.size() - 1)));
+        nth_element(all.begin(), all.begin() + rank, all.end());
+        return all[rank];
+    };
+    cout << "Roll latency: p50 " << percentile(0.50) << " us | p99 " << percentile(0.99)
+         << " us | max " << *max_element(all.begin(), all.end()) << " us\n";
+    return errors == 0 ? 0 : 1;
+}
+#endif
+
+// Plays an interactive session while writing its seed, input and draws to a
+// trace file that --replay can run back without a terminal.
+int runRecordedSession(GameOptions options, const string& tracePath) {
+    SessionTrace trace;
+    if (!options.hasSeed) {
+        options.hasSeed = true;
+        options.seed = randomSeed();
+    }
+    if (!trace.startRecording(tracePath, options.rngEngine, options.seed, options.rules)) {
+        cerr << RED << "Cannot write trace " << tracePath << ": " << strerror(errno) << RESET << "\n";
+        return 1;
+    }
+    RecordingStreambuf recorder(cin.rdbuf(), trace);
+    istream recordedInput(&recorder);
+    options.input = &recordedInput;
+    options.trace = &trace;
+    options.reproducible = true;
+    DiceGame game(options);
+    game.showMainMenu();
+    return 0;
+}
+
+// Replays a recorded trace headlessly: the recorded input is fed back, every
+// die draw is checked against the recording and the rendered screens are
+// either written out or compared with a golden transcript.
+int runReplay(GameOptions options, const string& tracePath, const string& transcriptPath,
+              const string& goldenPath) {
+    SessionTrace trace;
+    if (!trace.load(tracePath, options.rngEngine, options.seed, options.rules)) {
+        cerr << RED << "Cannot read trace " << tracePath << RESET << "\n";
+        return 1;
+    }
+    istringstream input(trace.getReplayInput());
+    ostringstream transcript;
+    options.hasSeed = true;
+    options.input = &input;
+    options.output = &transcript;
+    options.trace = &trace;
+    options.reproducible = true;
+    options.plainOutput = true;
+    options.animationSpeed = 0.0;
+
+    auto start = chrono::steady_clock::now();
+    {
+        DiceGame game(options);
+        game.showMainMenu();
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    int status = 0;
+    if (trace.getMismatches() > 0 || !trace.drawsExhausted()) {
+        cerr << RED << "Replay diverged: " << trace.getMismatches() << " mismatched draw(s)";
+        if (trace.getMismatches() > 0) cerr << ", first at draw " << trace.getFirstMismatch() + 1;
+        if (!trace.drawsExhausted()) cerr << ", draw count differs from the recording";
+        cerr << RESET << "\n";
+        status = 1;
+    }
+    if (!transcriptPath.empty()) {
+        ofstream file(transcriptPath, ios::trunc);
+        if (!(file << transcript.str())) {
+            cerr << RED << "Cannot write transcript " << transcriptPath << RESET << "\n";
+            status = 1;
+        }
+    }
+    if (!goldenPath.empty()) {
+        ifstream golden(goldenPath);
+        ostringstream expected;
+        expected << golden.rdbuf();
+        if (!golden || expected.str() != transcript.str()) {
+            const string& actual = transcript.str();
+            const string& wanted = expected.str();
+            size_t at = mismatch(actual.begin(), actual.begin() + min(actual.size(), wanted.size()),
+                                 wanted.begin()).first - actual.begin();
+            size_t line = count(actual.begin(), actual.begin() + at, '\n') + 1;
+            cerr << RED << "Transcript differs from " << goldenPath << " at line " << line << RESET << "\n";
+            status = 1;
+        }
+    }
+    cout << "Replayed " << trace.getReplayInput().size() << " input byte(s) and "
+         << trace.getDrawCount() << " draw(s) in " << fixed << setprecision(3)
+         << seconds * 1000.0 << " ms" << (status == 0 ? "" : " with differences") << "\n";
+    return status;
+}
+
+void printUsage(const char* program) {
+    cout << "Usage: " << program << " [--rng mt19937|xoshiro256|pcg64|philox] [--plain]\n"
+         << "       [--speed FACTOR] [--no-animation] [--rules SPEC]\n"
+         << "       [--journal-sync RECORDS] [--compact-every ROUNDS] [--seed SEED] [--record TRACE]\n"
+         << "       [--metrics FILE.prom|FILE.json]  (written on exit and on SIGUSR1)\n"
+         << "       [--export FILE.dgr|FILE.csv]  (every roll, chunked columnar or CSV)\n"
+         << "       " << program << " [--careers N] [--career NAME]\n"
+         << "       " << program << " --scan FILE.dgr [--games FIRST-LAST]\n"
+         << "       " << program << " --replay TRACE [--transcript FILE] [--golden FILE]\n"
+         << "       " << program << " --simulate N [--players P] [--sides S] [--threads T]\n"
+         << "       [--mode classic|target|elimination] [--rounds R] [--target X] [--rules SPEC]\n"
+         << "       [--seed SEED]\n"
+         << "       [--rng mt19937|xoshiro256|pcg64|philox] [--export FILE.dgr|FILE.csv]\n"
+         << "       " << program << " --tournament league|bracket --entrants N [--table-size T] [--rounds R]\n"
+         << "       [--top K] [--sides S] [--threads T] [--seed SEED] [--rng ENGINE]\n"
+         << "       " << program << " --what-if BRANCHES [--from-round R] [--players P] [--sides S] [--rounds R]\n"
+         << "       [--mode MODE] [--target X] [--rules SPEC] [--threads T] [--seed SEED] [--rng ENGINE]\n"
+         << "       " << program << " --fairness ROLLS [--sides S] [--threads T] [--seed SEED] [--rng ENGINE]\n"
+         << "       " << program << " --server tcp:PORT|unix:PATH [--threads T] [--rng ENGINE]\n"
+         << "       " << program << " --loadgen tcp:PORT|unix:PATH [--connections C] [--requests R]\n"
+         << "SPEC is comma-separated: plain or house, then key=value for mode, rounds, target,\n"
+         << "max-roll, streak, doubles or triples (e.g. house,mode=target,target=200)\n";
+}
+
+#ifndef DICE_GAME_NO_MAIN
+int main(int argc, char* argv[]) {
+    GameOptions options;
+    SimulationConfig config;
+    config.seed = randomSeed();
+    bool simulate = false;
+    bool tournamentMode = false;
+    TournamentConfig tournament;
+    string serverAddress, loadgenAddress;
+    string recordPath, replayPath, transcriptPath, goldenPath;
+    string metricsOutput;
+    long long loadConnections = 4, loadRolls = 10000;
+    long long careerTop = 0;
+    long long fairnessRolls = 0;
+    long long whatIfBranches = 0, whatIfRound = 0;
+    bool sidesGiven = false;
+    string careerName;
+    string exportPath, scanPath;
+    long long scanFirst = 0, scanLast = numeric_limits<long long>::max();
+
+    for (int i = 1; i < argc; ++i) {
+        string flag = argv[i];
+        long long value = 0;
+        const char* arg = "";
+        auto nextValue = [&]() {
+            if (i + 1 >= argc) return false;
+            arg = argv[++i];
+            return true;
+        };
+        bool ok;
+
+        if (flag == "--simulate") {
+            ok = nextValue() && parseNumber(arg, 1, numeric_limits<long long>::max(), value);
+            config.games = value;
+            simulate = true;
+        } else if (flag == "--players") {
+            ok = nextValue() && parseNumber(arg, 2, 64, value);
+            config.players = static_cast<int>(value);
+        } else if (flag == "--sides") {
+            ok = nextValue() && parseNumber(arg, 4, 12, value);
+            config.sides = static_cast<int>(value);
+            sidesGiven = true;
+        } else if (flag == "--threads") {
+            ok = nextValue() && parseNumber(arg, 1, 1024, value);
+            config.threads = static_cast<unsigned>(value);
+        } else if (flag == "--rounds") {
+            ok = nextValue() && parseNumber(arg, 1, 100000, value);
+            config.rules.rounds = static_cast<int>(value);
+        } else if (flag == "--target") {
+            ok = nextValue() && parseNumber(arg, 1, 1000000, value);
+            config.rules.target = static_cast<int>(value);
+        } else if (flag == "--seed") {
+            ok = nextValue() && parseNumber(arg, 0, numeric_limits<long long>::max(), value);
+            config.seed = static_cast<uint64_t>(value);
+            options.hasSeed = true;
+            options.seed = config.seed;
+        } else if (flag == "--record") {
+            ok = nextValue();
+            recordPath = arg;
+        } else if (flag == "--replay") {
+            ok = nextValue();
+            replayPath = arg;
+        } else if (flag == "--transcript") {
+            ok = nextValue();
+            transcriptPath = arg;
+        } else if (flag == "--golden") {
+            ok = nextValue();
+            goldenPath = arg;
+        } else if (flag == "--tournament") {
+            ok = nextValue();
+            string format = arg;
+            if (format == "league") tournament.format = TournamentFormat::League;
+            else if (format == "bracket") tournament.format = TournamentFormat::Bracket;
+            else ok = false;
+            tournamentMode = true;
+        } else if (flag == "--entrants") {
+            ok = nextValue() && parseNumber(arg, 2, 100000000, value);
+            tournament.entrants = static_cast<uint32_t>(value);
+        } else if (flag == "--table-size") {
+            ok = nextValue() && parseNumber(arg, 2, 16, value);
+            tournament.tableSize = static_cast<int>(value);
+        } else if (flag == "--top") {
+            ok = nextValue() && parseNumber(arg, 1, 10000, value);
+            tournament.top = static_cast<size_t>(value);
+        } else if (flag == "--mode") {
+            ok = nextValue() && parseGameMode(arg, config.rules.mode);
+        } else if (flag == "--rules") {
+            // Interactive games start from the house rules, simulations from plain ones.
+            ok = nextValue() && parseRuleSpec(arg, config.rules) && parseRuleSpec(arg, options.rules);
+        } else if (flag == "--rng") {
+            ok = nextValue() && parseRngEngine(arg, options.rngEngine);
+            config.engine = options.rngEngine;
+        } else if (flag == "--plain") {
+            ok = true;
+            options.plainOutput = true;
+        } else if (flag == "--speed") {
+            char* end = nullptr;
+            ok = nextValue();
+            options.animationSpeed = ok ? strtod(arg, &end) : 0.0;
+            ok = ok && end != arg && *end == '\0' && options.animationSpeed > 0.0;
+        } else if (flag == "--no-animation") {
+            ok = true;
+            options.animationSpeed = 0.0;
+        } else if (flag == "--server") {
+            ok = nextValue();
+            serverAddress = arg;
+        } else if (flag == "--loadgen") {
+            ok = nextValue();
+            loadgenAddress = arg;
+        } else if (flag == "--connections") {
+            ok = nextValue() && parseNumber(arg, 1, 10000, loadConnections);
+        } else if (flag == "--requests") {
+            ok = nextValue() && parseNumber(arg, 1, 1000000000, loadRolls);
+        } else if (flag == "--journal-sync") {
+            ok = nextValue() && parseNumber(arg, 1, 1000000, value);
+            options.journalSyncInterval = static_cast<int>(value);
+        } else if (flag == "--metrics") {
+            ok = nextValue();
+            metricsOutput = arg;
+        } else if (flag == "--careers") {
+            ok = nextValue() && parseNumber(arg, 1, 1000000, careerTop);
+        } else if (flag == "--career") {
+            ok = nextValue() && *arg;
+            careerName = arg;
+        } else if (flag == "--what-if") {
+            ok = nextValue() && parseNumber(arg, 1, numeric_limits<long long>::max(), whatIfBranches);
+        } else if (flag == "--from-round") {
+            ok = nextValue() && parseNumber(arg, 1, 100000, whatIfRound);
+        } else if (flag == "--fairness") {
+            ok = nextValue() && parseNumber(arg, 1, numeric_limits<long long>::max(), fairnessRolls);
+        } else if (flag == "--export") {
+            ok = nextValue() && *arg;
+            exportPath = arg;
+        } else if (flag == "--scan") {
+            ok = nextValue() && *arg;
+            scanPath = arg;
+        } else if (flag == "--games") {
+            ok = nextValue();
+            string range = arg;
+            size_t dash = range.find('-');
+            ok = ok && dash != string::npos &&
+                 parseNumber(range.substr(0, dash).c_str(), 0, numeric_limits<long long>::max(), scanFirst) &&
+                 parseNumber(range.substr(dash + 1).c_str(), scanFirst, numeric_limits<long long>::max(), scanLast);
+        } else if (flag == "--compact-every") {
+            ok = nextValue() && parseNumber(arg, 1, 1000000, value);
+            options.compactInterval = static_cast<int>(value);
         } else {
-            cout << BOLD << YELLOW << "Player Stats:\n" << RESET;
-            displayScores(true);
-        
-            cout << BOLD << YELLOW << "\nGame Analysis:\n" << RESET;
-            
-            map<int, int> rollFrequency;
-            for (const auto& player : players) {
-                for (int roll : player.getDiceHistory()) {
-                    rollFrequency[roll]++;
-                }
-            }
-            
-            if (!rollFrequency.empty()) {
-                auto mostFrequent = max_element(rollFrequency.begin(), rollFrequency.end(),
-                    [](const pair<int, int>& a, const pair<int, int>& b) {
-                        return a.second < b.second;
-                    });
-                
-                cout << "Most frequent roll: " << mostFrequent->first 
-                     << " (rolled " << mostFrequent->second << " times)\n";
-            }
-            
-            auto luckiest = max_element(players.begin(), players.end(),
-                [](const Player& a, const Player& b) {
-                    return a.getAverageRoll() < b.getAverageRoll();
-                });
-            
-            cout << "Luckiest player: " << luckiest->getName() 
-                 << " (avg " << fixed << setprecision(1) << luckiest->getAverageRoll() << ")\n";
+            ok = false;
+        }
+
+        if (!ok) {
+            cerr << RED << "Invalid argument: " << flag << (*arg ? string(" ") + arg : "") << RESET << "\n";
+            printUsage(argv[0]);
+            return 1;
         }
-        
-        cout << "\nPress Enter to continue...";
-        cin.ignore();
-        cin.get();
     }
 
-    void showFinalResults() {
-        displayHeader("FINAL RESULTS");
-        
-        sort(players.begin(), players.end(),
-            [](const Player& a, const Player& b) {
-                return a.getScore() > b.getScore();
-            });
-        
-        cout << BOLD << YELLOW << "\n🏆 FINAL STANDINGS 🏆\n" << RESET;
-        cout << "┌──────┬───────────────┬────────┬────────┐\n";
-        cout << "│ Rank │ Player        │ Score  │ Wins   │\n";
-        cout << "├──────┼───────────────┼────────┼────────┤\n";
-        
-        for (size_t i = 0; i < players.size(); ++i) {
-            string medal;
-            if (i == 0) medal = "🥇";
-            else if (i == 1) medal = "🥈";
-            else if (i == 2) medal = "🥉";
-            
-            cout << "│ " << setw(4) << left << to_string(i+1) + medal << " │ "
-                 << setw(13) << left << players[i].getName() << " │ "
-                 << setw(6) << right << players[i].getScore() << " │ "
-                 << setw(6) << right << players[i].getWins() << " │\n";
+    if (!metricsOutput.empty()) {
+        startMetricsExport(metricsOutput);
+    }
+
+    if (!serverAddress.empty() || !loadgenAddress.empty()) {
+#ifdef __linux__
+        Endpoint endpoint;
+        if (!parseEndpoint(serverAddress.empty() ? loadgenAddress : serverAddress, endpoint)) {
+            cerr << RED << "Address must be tcp:PORT or unix:PATH" << RESET << "\n";
+            return 1;
         }
-        cout << "└──────┴───────────────┴────────┴────────┘\n";
-        
-        cout << BOLD << YELLOW << "\n🌟 SPECIAL ACHIEVEMENTS 🌟\n" << RESET;
-        
-        auto bestRoller = max_element(players.begin(), players.end(),
-            [](const Player& a, const Player& b) {
-                return a.getBestRoll() < b.getBestRoll();
-            });
-        
-        cout << "Highest Roll: " << bestRoller->getName() << " with " 
-             << bestRoller->getBestRoll() << "\n";
-        
-        auto mostConsistent = min_element(players.begin(), players.end(),
-            [](const Player& a, const Player& b) {
-                const auto& histA = a.getDiceHistory();
-                const auto& histB = b.getDiceHistory();
-                
-                if (histA.empty() || histB.empty()) return false;
-                
-                double meanA = accumulate(histA.begin(), histA.end(), 0.0) / histA.size();
-                double varianceA = 0.0;
-                for (int x : histA) varianceA += pow(x - meanA, 2);
-                
-                double meanB = accumulate(histB.begin(), histB.end(), 0.0) / histB.size();
-                double varianceB = 0.0;
-                for (int x : histB) varianceB += pow(x - meanB, 2);
-                
-                return varianceA < varianceB;
-            });
-        
-        cout << "Most Consistent: " << mostConsistent->getName() 
-             << " (avg " << fixed << setprecision(1) << mostConsistent->getAverageRoll() << ")\n";
-        
-        cout << "\nPress Enter to return to main menu...";
-        cin.ignore();
-        cin.get();
+        if (!loadgenAddress.empty()) {
+            return runLoadGenerator(endpoint, static_cast<unsigned>(loadConnections), loadRolls);
+        }
+        unsigned threads = config.threads ? config.threads : max(1u, thread::hardware_concurrency());
+        DiceServer server(threads, options.rngEngine, config.seed);
+        if (!server.start(endpoint)) {
+            cerr << RED << "Cannot listen on " << serverAddress << ": " << strerror(errno) << RESET << "\n";
+            return 1;
+        }
+        cout << "Dice server listening on " << serverAddress << " with " << threads << " worker(s)\n";
+        cout.flush();
+        server.run();
+        return 0;
+#else
+        cerr << RED << "Server mode is only available on Linux" << RESET << "\n";
+        return 1;
+#endif
     }
 
-    void showMainMenu() {
-        while (true) {
-            displayHeader("MAIN MENU");
-            
-            cout << BOLD << "1. New Game\n";
-            cout << "2. Load Game\n";
-            cout << "3. Game Rules\n";
-            cout << "4. Exit\n" << RESET;
-            cout << "Enter choice: ";
-            
-            int choice;
-            cin >> choice;
-            
-            switch (choice) {
-                case 1:
-                    setupGame();
-                    playGame();
-                    break;
-                case 2:
-                    if (loadGame()) {
-                        playGame();
-                    }
-                    break;
-                case 3:
-                    showGameRules();
-                    break;
-                case 4:
-                    if (!gameSaved && !players.empty()) {
-                        cout << "Save before exiting? (y/n): ";
-                        char saveChoice;
-                        cin >> saveChoice;
-                        if (tolower(saveChoice) == 'y') {
-                            saveGame();
-                        }
-                    }
-                    return;
-                default:
-                    cout << RED << "Invalid choice!\n" << RESET;
-                    this_thread::sleep_for(chrono::seconds(1));
+    if (fairnessRolls > 0) {
+        FairnessHarness harness(options.rngEngine, config.seed, static_cast<uint64_t>(fairnessRolls), config.threads);
+        printFairnessHeader(options.rngEngine, static_cast<uint64_t>(fairnessRolls), harness.getThreads());
+        int first = sidesGiven ? config.sides : MIN_DICE_SIDES, last = sidesGiven ? config.sides : MAX_DICE_SIDES;
+        bool passed = true;
+        auto start = chrono::steady_clock::now();
+        for (int sides = first; sides <= last; ++sides) {
+            FairnessReport report = harness.run(sides);
+            printFairnessRow(report);
+            passed = passed && report.passed();
+        }
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        uint64_t total = static_cast<uint64_t>(fairnessRolls) * static_cast<uint64_t>(last - first + 1);
+        cout << "\n" << total << " rolls in " << fixed << setprecision(2) << seconds << "s ("
+             << setprecision(0) << (seconds > 0 ? total / seconds * 60.0 : 0.0) << " rolls/min)\n";
+        cout << (passed ? GREEN : RED) << (passed ? "No test rejected fairness" : "Fairness rejected; see flagged p-values")
+             << RESET << "\n";
+        return passed ? 0 : 1;
+    }
+
+    if (whatIfBranches > 0) {
+        WhatIfRunner runner(config, static_cast<int>(whatIfRound), static_cast<uint64_t>(whatIfBranches));
+        if (!runner.getFork() || runner.getFromRound() > runner.getBaseRounds()) {
+            cerr << RED << "--from-round must be within the base game's " << runner.getBaseRounds() << " rounds"
+                 << RESET << "\n";
+            return 1;
+        }
+        auto start = chrono::steady_clock::now();
+        WhatIfResult result = runner.run();
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        printWhatIfReport(runner, result, seconds);
+        return 0;
+    }
+
+    if (!scanPath.empty()) {
+        RollExportSummary summary;
+        auto start = chrono::steady_clock::now();
+        if (!scanRollExport(scanPath, static_cast<uint64_t>(scanFirst), static_cast<uint64_t>(scanLast), summary)) {
+            cerr << RED << "Cannot read roll export " << scanPath << RESET << "\n";
+            return 1;
+        }
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        printRollExportSummary(scanPath, summary, seconds);
+        return summary.complete ? 0 : 1;
+    }
+
+    RollExporter exporter;
+    if (!exportPath.empty()) {
+        if (!exporter.open(exportPath)) {
+            cerr << RED << "Cannot write " << exportPath << ": " << strerror(errno) << RESET << "\n";
+            return 1;
+        }
+        options.exporter = &exporter;
+        config.exporter = &exporter;
+    }
+
+    if (!replayPath.empty()) {
+        return runReplay(options, replayPath, transcriptPath, goldenPath);
+    }
+
+    if (tournamentMode) {
+        if (tournament.entrants == 0) {
+            cerr << RED << "--tournament needs --entrants N" << RESET << "\n";
+            return 1;
+        }
+        tournament.rounds = config.rules.rounds;
+        tournament.sides = config.sides;
+        tournament.threads = config.threads;
+        tournament.seed = config.seed;
+        tournament.engine = config.engine;
+        Tournament play(tournament);
+        auto start = chrono::steady_clock::now();
+        play.run();
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        printTournamentReport(play, seconds);
+        return 0;
+    }
+
+    if (careerTop > 0 || !careerName.empty()) {
+        CareerStore careers;
+        if (!careers.open()) {
+            cerr << RED << "Cannot open " << CAREER_FILE << RESET << "\n";
+            return 1;
+        }
+        if (careerTop > 0) printCareerLeaders(cout, careers, static_cast<size_t>(careerTop));
+        if (!careerName.empty()) {
+            CareerRecord record;
+            if (!careers.lookup(careerName, record)) {
+                cerr << RED << "No career found for " << careerName << RESET << "\n";
+                return 1;
             }
+            if (careerTop > 0) cout << "\n";
+            printCareerRecord(cout, careers, record);
         }
+        return 0;
     }
-};
 
-int main() {
-    DiceGame game;
-    game.showMainMenu();
+    if (!simulate && !recordPath.empty()) {
+        return runRecordedSession(options, recordPath);
+    }
+
+    if (!simulate) {
+        DiceGame game(options);
+        game.showMainMenu();
+        return 0;
+    }
+
+    SimulationEngine engine(config);
+    auto start = chrono::steady_clock::now();
+    SimulationResult result = engine.run();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    printSimulationReport(engine.getConfig(), result, seconds);
+    if (exporter.isOpen()) {
+        uint64_t rolls = exporter.rollsWritten();
+        if (!exporter.close()) {
+            cerr << RED << "Writing " << exportPath << " failed" << RESET << "\n";
+            return 1;
+        }
+        cout << "Exported " << rolls << " rolls to " << exportPath << "\n";
+    }
     return 0;
 }
+#endif
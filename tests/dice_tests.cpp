@@ -0,0 +1,1174 @@
+// Regression tests for the game's core types. Builds against the game
+// sources with DICE_GAME_NO_MAIN defined; each test is registered with
+// CTest by name, and running with no arguments runs them all.
+#include "../main.cpp"
+
+int failures = 0;
+
+// Heap allocations made while counting is on, from any thread. Replacing the
+// global operator new lets a test check that a path does not allocate.
+atomic<bool> countingAllocations(false);
+atomic<uint64_t> allocationCount(0);
+
+void* operator new(size_t size) {
+    if (countingAllocations.load(memory_order_relaxed)) allocationCount.fetch_add(1, memory_order_relaxed);
+    if (void* block = malloc(size > 0 ? size : 1)) return block;
+    throw bad_alloc();
+}
+
+// Kept out of line: inlined into a caller, free() on a pointer from new
+// trips GCC's mismatched allocation warning.
+#if defined(__GNUC__) || defined(__clang__)
+__attribute__((noinline))
+#endif
+void operator delete(void* block) noexcept { free(block); }
+
+void operator delete(void* block, size_t) noexcept { ::operator delete(block); }
+
+// Answers every "press Enter" prompt.
+class EnterKeys : public streambuf {
+private:
+    char key = '\n';
+
+protected:
+    int_type underflow() override {
+        setg(&key, &key, &key + 1);
+        return traits_type::to_int_type(key);
+    }
+};
+
+class DiscardBuffer : public streambuf {
+protected:
+    int_type overflow(int_type ch) override { return traits_type::not_eof(ch); }
+    streamsize xsputn(const char*, streamsize count) override { return count; }
+};
+
+void check(bool condition, const string& what) {
+    if (!condition) {
+        cerr << RED << "FAILED: " << what << RESET << "\n";
+        failures++;
+    }
+}
+
+// The statistics Player computed by rescanning its whole history before it
+// kept running aggregates; the new ones must agree with them.
+double rescanAverage(const vector<int>& history) {
+    return accumulate(history.begin(), history.end(), 0.0) / history.size();
+}
+
+double rescanDeviation(const vector<int>& history) {
+    double mean = rescanAverage(history);
+    double deviation = 0.0;
+    for (int x : history) deviation += pow(x - mean, 2);
+    return deviation;
+}
+
+void testPlayerAggregates() {
+    mt19937_64 rng(20240611);
+    for (int trial = 0; trial < 2000; ++trial) {
+        int sides = uniform_int_distribution<int>(4, 12)(rng);
+        size_t length = uniform_int_distribution<size_t>(1, trial % 10 == 0 ? 20000 : 200)(rng);
+        vector<int> history(length);
+        Player player("P");
+        for (int& roll : history) {
+            roll = uniform_int_distribution<int>(1, sides)(rng);
+            player.addToHistory(roll);
+        }
+
+        string label = "trial " + to_string(trial);
+        check(player.getRollCount() == history.size(), label + ": roll count");
+        check(player.getRollSum() == accumulate(history.begin(), history.end(), int64_t(0)), label + ": roll sum");
+        check(player.getBestRoll() == *max_element(history.begin(), history.end()), label + ": best roll");
+        check(player.getWorstRoll() == *min_element(history.begin(), history.end()), label + ": worst roll");
+        check(player.getAverageRoll() == rescanAverage(history), label + ": average roll");
+        double deviation = rescanDeviation(history);
+        check(fabs(player.getRollDeviation() - deviation) <= 1e-9 * max(1.0, deviation), label + ": deviation");
+    }
+}
+
+// Most Consistent picks the lowest spread; equal spreads must stay equal
+// however the rolls were ordered, and distinct ones must order as the
+// rescan ordered them.
+void testConsistencyOrder() {
+    mt19937_64 rng(777);
+    for (int trial = 0; trial < 5000; ++trial) {
+        int sides = uniform_int_distribution<int>(4, 12)(rng);
+        vector<int> first(uniform_int_distribution<size_t>(1, 60)(rng));
+        vector<int> second(trial % 3 == 0 ? first.size() : uniform_int_distribution<size_t>(1, 60)(rng));
+        for (int& roll : first) roll = uniform_int_distribution<int>(1, sides)(rng);
+        if (trial % 3 == 0) {
+            second = first;
+            shuffle(second.begin(), second.end(), rng);
+        } else {
+            for (int& roll : second) roll = uniform_int_distribution<int>(1, sides)(rng);
+        }
+
+        Player a("A"), b("B");
+        for (int roll : first) a.addToHistory(roll);
+        for (int roll : second) b.addToHistory(roll);
+
+        string label = "trial " + to_string(trial);
+        if (trial % 3 == 0) {
+            check(!a.steadierThan(b) && !b.steadierThan(a), label + ": reordered rolls compare equal");
+            continue;
+        }
+        double spreadA = rescanDeviation(first), spreadB = rescanDeviation(second);
+        if (fabs(spreadA - spreadB) <= 1e-9 * max(1.0, max(spreadA, spreadB))) continue;
+        check(a.steadierThan(b) == (spreadA < spreadB), label + ": spread order");
+        check(b.steadierThan(a) == (spreadB < spreadA), label + ": reverse spread order");
+    }
+}
+
+// Values past the 8-bit packing are refused, not stored as something else.
+void testRollHistoryRange() {
+    RollHistory history;
+    check(history.push_back(6) && history.push_back(MAX_PACKED_ROLL), "in-range rolls are stored");
+    check(!history.push_back(MAX_PACKED_ROLL + 1) && !history.push_back(-1), "out-of-range rolls are refused");
+    check(history.size() == 2 && history[0] == 6 && history[1] == MAX_PACKED_ROLL, "stored rolls keep their values");
+    check(history.faceCount(0) == 0, "a refused roll is not counted as a wrapped-around value");
+
+    Player player("P");
+    check(!player.addToHistory(MAX_PACKED_ROLL + 1), "Player refuses an unstorable roll");
+    check(player.getRollCount() == 0 && player.getRollSum() == 0, "a refused roll leaves the aggregates alone");
+}
+
+vector<uint8_t> legacySave(int rounds, int currentRound, int diceSides) {
+    vector<uint8_t> bytes;
+    auto put = [&](const auto& value) {
+        const uint8_t* raw = reinterpret_cast<const uint8_t*>(&value);
+        bytes.insert(bytes.end(), raw, raw + sizeof(value));
+    };
+    put(rounds);
+    put(currentRound);
+    put(diceSides);
+    put(size_t(0));
+    return bytes;
+}
+
+// Histories longer than a chunk read, scan, copy, save and widen the same
+// as the plain list of rolls they hold.
+void testHistoryChunks() {
+    mt19937_64 rng(99);
+    vector<int> rolls;
+    RollHistory history;
+    for (int i = 0; i < 30000; ++i) {
+        int roll = uniform_int_distribution<int>(1, 6)(rng);
+        if (i >= 8180 && i < 8200) roll = 4;  // a streak across the first chunk boundary
+        rolls.push_back(roll);
+        history.push_back(roll);
+    }
+    check(history.size() == rolls.size() && equal(rolls.begin(), rolls.end(), history.begin()), "rolls read back");
+
+    RollStatistics stats = analyzeHistory(history, 6);
+    uint64_t longest = 1, current = 1;
+    for (size_t i = 1; i < rolls.size(); ++i) {
+        current = rolls[i] == rolls[i - 1] ? current + 1 : 1;
+        longest = max(longest, current);
+    }
+    check(stats.longestStreak == longest, "longest streak across chunks");
+    for (int face = 1; face <= 6; ++face) {
+        uint64_t expected = static_cast<uint64_t>(count(rolls.begin(), rolls.end(), face));
+        check(stats.faces[face] == expected && history.faceCount(face) == expected, "face counts across chunks");
+    }
+
+    RollHistory copy = history;
+    check(copy.sealedChunks() && copy.sealedChunks() == history.sealedChunks(), "copies share sealed chunks");
+    copy.push_back(2);
+    check(history.size() == rolls.size() && copy[rolls.size()] == 2, "appending to a copy leaves the original alone");
+
+    vector<Player> players;
+    players.emplace_back("Ann");
+    for (int roll : rolls) players.back().addToHistory(roll);
+    vector<uint8_t> bytes = encodeSaveGame(RuleSet(), 1, 6, players);
+    SavedGame saved;
+    check(decodeSaveGame(bytes.data(), bytes.size(), saved), "a long history saves and loads");
+    const RollHistory& loaded = saved.players.at(0).getDiceHistory();
+    check(loaded.size() == rolls.size() && equal(rolls.begin(), rolls.end(), loaded.begin()), "loaded rolls");
+
+    history.push_back(200);
+    check(history.bitsPerRoll() == 8 && history[rolls.size()] == 200, "a wide roll widens the history");
+    check(equal(rolls.begin(), rolls.end(), history.begin()), "widening keeps every earlier roll");
+}
+
+// Saves must bound the round counter by the rules they carry.
+void testSaveValidation() {
+    vector<Player> players;
+    players.emplace_back("Ann");
+    players.back().addToHistory(3);
+    RuleSet rules;
+    rules.rounds = 5;
+    SavedGame saved;
+
+    auto decodes = [&](const vector<uint8_t>& bytes) { return decodeSaveGame(bytes.data(), bytes.size(), saved); };
+    check(decodes(encodeSaveGame(rules, 3, 6, players)), "a game in progress loads");
+
+    for (int roll : {6, 1, 4, 4}) players.back().addToHistory(roll);
+    check(decodes(encodeSaveGame(rules, 3, 6, players)) && saved.players.size() == 1, "rolls round-trip");
+    const Player& loaded = saved.players[0];
+    check(loaded.getRollCount() == 5 && loaded.getRollSum() == 18 && loaded.getRollSumSquares() == 78 &&
+              loaded.getBestRoll() == 6 && loaded.getWorstRoll() == 1 && loaded.getAverageRoll() == 3.6,
+          "aggregates are rebuilt from the saved rolls");
+    vector<uint8_t> bytes = encodeSaveGame(rules, 3, 6, players);
+    bytes[4]++;
+    uint64_t checksum = fnv1a64(bytes.data(), bytes.size() - 8);
+    for (int i = 0; i < 8; ++i) bytes[bytes.size() - 8 + i] = static_cast<uint8_t>(checksum >> (8 * i));
+    check(!decodes(bytes), "an unknown save version is refused");
+    check(decodes(encodeSaveGame(rules, 6, 6, players)), "a finished classic game loads");
+    check(!decodes(encodeSaveGame(rules, 7, 6, players)), "a round past the game's end is refused");
+    check(!decodes(encodeSaveGame(rules, -1, 6, players)), "a negative round is refused");
+    rules.rounds = -4;
+    check(!decodes(encodeSaveGame(rules, 0, 6, players)), "negative rounds are refused");
+    rules.rounds = 5;
+    rules.mode = GameMode::Target;
+    check(decodes(encodeSaveGame(rules, 40, 6, players)), "a target game may run past the rounds field");
+
+    check(decodes(legacySave(10, 4, 6)), "a legacy game in progress loads");
+    check(!decodes(legacySave(-3, 0, 6)), "legacy negative rounds are refused");
+    check(!decodes(legacySave(10, -2, 6)), "a legacy negative round is refused");
+    check(!decodes(legacySave(10, 12, 6)), "a legacy round past the game's end is refused");
+}
+
+bool loadTrace(const string& body) {
+    const string path = "dice_tests.trace";
+    {
+        ofstream file(path, ios::trunc);
+        file << TRACE_HEADER << "\n" << body;
+    }
+    SessionTrace trace;
+    RngEngine engine;
+    uint64_t seed = 0;
+    RuleSet rules;
+    bool loaded = trace.load(path, engine, seed, rules);
+    remove(path.c_str());
+    return loaded;
+}
+
+// A damaged trace must fail to load, not replay a different game.
+void testTraceLoad() {
+    const string good = "engine mt19937\nseed 18446744073709551615\nrules mode=target\ninput 1\\n\ndraw 4\n";
+    check(loadTrace(good), "a well-formed trace loads");
+    check(loadTrace("engine mt19937\nseed 7\ndraw 3\n"), "a trace without a rules line loads");
+    check(!loadTrace("engine mt19937\nseed 7x\n"), "a seed with trailing junk is refused");
+    check(!loadTrace("engine mt19937\nseed\n"), "an empty seed is refused");
+    check(!loadTrace("engine mt19937\nseed -1\n"), "a negative seed is refused");
+    check(!loadTrace("engine mt19937\nseed 18446744073709551616\n"), "an overflowing seed is refused");
+    check(!loadTrace("engine mt19937\nseed 7\ndraw\n"), "an empty draw is refused");
+    check(!loadTrace("engine mt19937\nseed 7\ndraw 0\n"), "a draw no die can show is refused");
+    check(!loadTrace("engine mt19937\nseed 7\nrules bogus\n"), "bad rules are refused");
+    check(!loadTrace("engine mt19937\nseed 7\nround 3\n"), "an unknown line is refused");
+    check(!loadTrace("engine nope\nseed 7\n"), "an unknown engine is refused");
+}
+
+// Once a game's buffers are warmed up, a full interactive round, rendering
+// and event delivery included, must not touch the heap in any mode.
+void testRoundAllocations() {
+    const int WARMUP_ROUNDS = 4, ROUNDS = 300;
+    for (const char* spec : {"plain", "house", "house,mode=target,target=100000", "house,mode=elimination"}) {
+        for (int playerCount : {2, 4}) {
+            EnterKeys keys;
+            istream input(&keys);
+            DiscardBuffer discard;
+            ostream sink(&discard);
+            GameOptions options;
+            options.animationSpeed = 0.0;
+            options.reproducible = true;
+            options.hasSeed = true;
+            options.seed = 42;
+            options.input = &input;
+            options.output = &sink;
+
+            RuleSet rules;
+            parseRuleSpec(spec, rules);
+            rules.rounds = WARMUP_ROUNDS + ROUNDS;
+            DiceGame game(options);
+            game.configure(6, rules);
+            for (int p = 0; p < playerCount; ++p) game.addPlayer("Player" + to_string(p + 1));
+            game.reserveRounds();
+            for (int i = 0; i < WARMUP_ROUNDS; ++i) game.playRound(0);
+            game.drainEvents();  // consumer threads set up on their first batch
+
+            allocationCount = 0;
+            countingAllocations = true;
+            for (int i = 0; i < ROUNDS && !game.isFinished(); ++i) game.playRound(0);
+            game.drainEvents();
+            countingAllocations = false;
+            check(allocationCount.load() == 0, string(spec) + " with " + to_string(playerCount) + " players: " +
+                                                   to_string(allocationCount.load()) + " heap allocations");
+        }
+    }
+}
+
+vector<vector<int>> rollsOf(const vector<Player>& players) {
+    vector<vector<int>> rolls;
+    for (const auto& player : players) {
+        rolls.emplace_back(player.getDiceHistory().begin(), player.getDiceHistory().end());
+    }
+    return rolls;
+}
+
+bool sameAggregates(const Player& player, const vector<int>& rolls) {
+    Player rebuilt("R");
+    for (int roll : rolls) rebuilt.addToHistory(roll);
+    return player.getRollCount() == rebuilt.getRollCount() && player.getRollSum() == rebuilt.getRollSum() &&
+           player.getRollSumSquares() == rebuilt.getRollSumSquares() &&
+           player.getBestRoll() == rebuilt.getBestRoll() && player.getWorstRoll() == rebuilt.getWorstRoll() &&
+           player.getDiceHistory().getFaceCounts() == rebuilt.getDiceHistory().getFaceCounts();
+}
+
+const HistoryChunk* firstChunk(const Player& player) {
+    const HistoryChunk* chunk = player.getDiceHistory().sealedChunks().get();
+    while (chunk && chunk->previous) chunk = chunk->previous.get();
+    return chunk;
+}
+
+void playRounds(GameSession& session, int rounds) {
+    for (int r = 0; r < rounds; ++r) {
+        for (size_t i = 0; i < session.getPlayers().size(); ++i) session.rollFor(i);
+        session.resolveRound();
+    }
+}
+
+// Rewinding relinks the history chunks a round's snapshot shares, across
+// chunk boundaries and from a timeline started partway into a game, and
+// leaves every roll and aggregate as it was at that round.
+void testTimelineRewind() {
+    const int ROUNDS = 20000;
+    GameSession session(RngEngine::Pcg64, 5);
+    session.configure(6, ROUNDS + 500);
+    session.addPlayer("Ann");
+    session.addPlayer("Bob");
+    session.reserveRounds();
+
+    map<int, vector<vector<int>>> checkpoints;
+    for (int round = 1; round <= ROUNDS; ++round) {
+        playRounds(session, 1);
+        if (round % 997 == 0 || round == 8192 || round == 8193) checkpoints[round] = rollsOf(session.getPlayers());
+    }
+    const HistoryChunk* shared = firstChunk(session.getPlayers()[0]);
+    check(shared != nullptr, "a long game seals history chunks");
+    vector<vector<int>> finalRolls = rollsOf(session.getPlayers());
+    const TimelineNode* finalHead = session.getTimeline().getHead();
+
+    for (auto it = checkpoints.rbegin(); it != checkpoints.rend(); ++it) {
+        check(session.rewindTo(it->first + 1), "rewind to after round " + to_string(it->first));
+        check(rollsOf(session.getPlayers()) == it->second, "rolls after rewinding to round " + to_string(it->first));
+        for (size_t i = 0; i < 2; ++i) {
+            check(sameAggregates(session.getPlayers()[i], it->second[i]),
+                  "aggregates after rewinding to round " + to_string(it->first));
+        }
+        if (it->first > 8192) {
+            check(firstChunk(session.getPlayers()[0]) == shared, "rewinding relinks chunks instead of copying them");
+        }
+    }
+
+    // A new branch from the earliest checkpoint, then the abandoned head
+    // restored from the side.
+    playRounds(session, 50);
+    vector<Player> players = session.getPlayers();
+    session.getTimeline().restorePlayers(finalHead, players);
+    check(rollsOf(players) == finalRolls, "an abandoned branch restores in full");
+
+    // A timeline started partway, as after loading a save: the root holds
+    // rolls from before it, sealed and unsealed.
+    playRounds(session, 9000);
+    session.restartTimeline();
+    vector<vector<int>> atRoot = rollsOf(session.getPlayers());
+    int rootRound = session.getCurrentRound();
+    playRounds(session, 300);
+    check(session.rewindTo(rootRound + 120), "rewind within a timeline started mid-game");
+    vector<vector<int>> expected = rollsOf(session.getPlayers());
+    check(expected.size() == 2 && expected[0].size() == atRoot[0].size() + 120, "rolls since the root are kept");
+    check(equal(atRoot[0].begin(), atRoot[0].end(), expected[0].begin()), "rolls before the root are kept");
+    check(session.rewindTo(rootRound), "rewind to the root");
+    check(rollsOf(session.getPlayers()) == atRoot, "rolls at the root");
+}
+
+vector<uint8_t> readBytes(const string& path) {
+    ifstream file(path, ios::binary);
+    return vector<uint8_t>(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+}
+
+void writeBytes(const string& path, const vector<uint8_t>& bytes) {
+    ofstream file(path, ios::binary | ios::trunc);
+    file.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+}
+
+// What CareerStore should hold, kept the obvious way: a map per name and a
+// map per ordered pair of names.
+struct CareerModel {
+    map<string, CareerRecord> records;
+    map<pair<string, string>, HeadToHead> rivals;
+
+    void recordGame(const vector<Player>& players, int winner) {
+        int topScore = numeric_limits<int>::min();
+        for (const auto& player : players) topScore = max(topScore, player.getScore());
+        for (size_t seat = 0; seat < players.size(); ++seat) {
+            const Player& player = players[seat];
+            CareerRecord& record = records[player.getName()];
+            record.name = player.getName();
+            record.games++;
+            if (winner >= 0 && seat == static_cast<size_t>(winner)) record.wins++;
+            if (winner < 0 && player.getScore() == topScore) record.ties++;
+            record.rolls += player.getRollCount();
+            record.rollSum += player.getRollSum();
+            record.bestRoll = max<uint32_t>(record.bestRoll, player.getBestRoll());
+            for (int roll : player.getDiceHistory()) record.faces[roll]++;
+        }
+        // The declared winner beats everyone; otherwise the higher score wins.
+        for (size_t i = 0; i < players.size(); ++i) {
+            for (size_t j = 0; j < players.size(); ++j) {
+                if (i == j) continue;
+                HeadToHead& result = rivals[{players[i].getName(), players[j].getName()}];
+                int a = players[i].getScore(), b = players[j].getScore();
+                if (static_cast<int>(i) == winner || (static_cast<int>(j) != winner && a > b)) result.wins++;
+                else if (static_cast<int>(j) == winner || a < b) result.losses++;
+                else result.ties++;
+                result.games++;
+            }
+        }
+    }
+};
+
+bool sameCareer(const CareerRecord& stored, const CareerRecord& expected) {
+    return stored.name == expected.name && stored.games == expected.games && stored.wins == expected.wins &&
+           stored.ties == expected.ties && stored.rolls == expected.rolls && stored.rollSum == expected.rollSum &&
+           stored.bestRoll == expected.bestRoll && equal(begin(stored.faces), end(stored.faces), begin(expected.faces));
+}
+
+// Every record, every rivalry and the top of the leaderboard agree with the model.
+void checkCareers(const CareerStore& store, const CareerModel& model, const string& label) {
+    check(store.size() == model.records.size(), label + ": player count");
+    map<string, uint64_t> ids;
+    for (const auto& entry : model.records) {
+        CareerRecord record;
+        if (!store.lookup(entry.first, record)) {
+            check(false, label + ": " + entry.first + " is missing");
+            continue;
+        }
+        check(sameCareer(record, entry.second), label + ": record of " + entry.first);
+        ids[entry.first] = record.id;
+        map<string, HeadToHead> rivals;
+        for (const auto& rival : store.rivalsOf(record, numeric_limits<size_t>::max())) {
+            rivals[rival.first.name] = rival.second;
+        }
+        auto it = model.rivals.lower_bound({entry.first, string()});
+        size_t expected = 0;
+        for (; it != model.rivals.end() && it->first.first == entry.first; ++it, ++expected) {
+            const HeadToHead& stored = rivals[it->first.second];
+            check(stored.wins == it->second.wins && stored.losses == it->second.losses &&
+                      stored.ties == it->second.ties && stored.games == it->second.games,
+                  label + ": " + entry.first + " against " + it->first.second);
+        }
+        check(rivals.size() == expected, label + ": rivals of " + entry.first);
+    }
+
+    // Best win rate first, then more games, then the older career.
+    vector<const CareerRecord*> ranked;
+    for (const auto& entry : model.records) ranked.push_back(&entry.second);
+    sort(ranked.begin(), ranked.end(), [&](const CareerRecord* a, const CareerRecord* b) {
+        uint64_t left = a->wins * b->games, right = b->wins * a->games;
+        if (left != right) return left > right;
+        if (a->games != b->games) return a->games > b->games;
+        return ids[a->name] < ids[b->name];
+    });
+    vector<CareerRecord> leaders = store.topWinRates(50);
+    bool sameOrder = leaders.size() == min<size_t>(50, ranked.size());
+    for (size_t i = 0; sameOrder && i < leaders.size(); ++i) sameOrder = leaders[i].name == ranked[i]->name;
+    check(sameOrder, label + ": top 50 by win rate");
+}
+
+// Random games over more players than the page cache holds, checked against
+// the model after every batch, across a reopen, and through a crash that
+// left a complete or a torn write-ahead log.
+void testCareerStore() {
+    const string path = "dice_tests_careers.db", walPath = "dice_tests_careers.wal";
+    remove(path.c_str());
+    remove(walPath.c_str());
+    mt19937_64 rng(4242);
+    CareerModel model;
+    auto randomGame = [&](vector<Player>& players) -> int {
+        players.clear();
+        int seats = uniform_int_distribution<int>(2, 4)(rng), sides = uniform_int_distribution<int>(4, 12)(rng);
+        while (static_cast<int>(players.size()) < seats) {
+            string name = "Player " + to_string(uniform_int_distribution<int>(1, 1500)(rng));
+            bool taken = false;
+            for (const auto& player : players) taken = taken || player.getName() == name;
+            if (taken) continue;
+            players.emplace_back(name);
+            int rolls = uniform_int_distribution<int>(1, 12)(rng);
+            for (int r = 0; r < rolls; ++r) players.back().addToHistory(uniform_int_distribution<int>(1, sides)(rng));
+            players.back().addToScore(uniform_int_distribution<int>(0, 6)(rng));
+        }
+        // A declared winner need not hold the top score, as in Elimination.
+        return uniform_int_distribution<int>(0, 2)(rng) == 0 ? -1 : uniform_int_distribution<int>(0, seats - 1)(rng);
+    };
+
+    {
+        CareerStore store;
+        check(store.open(path, walPath), "a new career store opens");
+        vector<Player> players;
+        for (int game = 1; game <= 3000; ++game) {
+            int winner = randomGame(players);
+            check(store.recordGame(players, winner), "game " + to_string(game) + " is recorded");
+            model.recordGame(players, winner);
+            if (game % 1000 == 0) checkCareers(store, model, "after " + to_string(game) + " games");
+        }
+        check(store.cacheMisses() > CAREER_CACHE_PAGES, "the store outgrows its page cache");
+
+        // Names are kept whole: a long shared prefix stays two careers, and a
+        // name too long for a record is refused without touching the store.
+        vector<Player> longNames;
+        longNames.emplace_back(string(CAREER_NAME_BYTES - 1, 'x') + "a");
+        longNames.emplace_back(string(CAREER_NAME_BYTES - 1, 'x') + "b");
+        longNames[0].addToHistory(3);
+        longNames[1].addToHistory(5);
+        check(store.recordGame(longNames, 1), "names of the full length are recorded");
+        model.recordGame(longNames, 1);
+        longNames.emplace_back(string(CAREER_NAME_BYTES + 1, 'x'));
+        check(!store.recordGame(longNames, 0), "a name too long for a record is refused");
+        CareerRecord record;
+        check(!store.lookup(string(CAREER_NAME_BYTES + 1, 'x'), record), "a name too long is never found");
+        checkCareers(store, model, "after the long names");
+    }
+    {
+        CareerStore store;
+        check(store.open(path, walPath), "the store reopens");
+        checkCareers(store, model, "after reopening");
+    }
+
+    // A crash after the log synced but before the pages landed: rebuild that
+    // log from the pages one more game changes, and put the old pages back.
+    vector<uint8_t> before = readBytes(path);
+    vector<Player> players;
+    int winner = randomGame(players);
+    CareerModel previous = model;
+    {
+        CareerStore store;
+        store.open(path, walPath);
+        check(store.recordGame(players, winner), "the last game is recorded");
+        model.recordGame(players, winner);
+    }
+    vector<uint8_t> after = readBytes(path);
+    SaveWriter wal;
+    vector<uint32_t> changed;
+    for (size_t page = 0; page * CAREER_PAGE_SIZE < after.size(); ++page) {
+        size_t offset = page * CAREER_PAGE_SIZE;
+        if (offset >= before.size() || memcmp(&before[offset], &after[offset], CAREER_PAGE_SIZE) != 0) {
+            changed.push_back(static_cast<uint32_t>(page));
+        }
+    }
+    wal.putU32(CAREER_WAL_MAGIC);
+    wal.putU16(CAREER_VERSION);
+    wal.putU16(0);
+    wal.putU32(static_cast<uint32_t>(after.size() / CAREER_PAGE_SIZE));
+    wal.putU32(static_cast<uint32_t>(changed.size()));
+    for (uint32_t page : changed) {
+        wal.putU32(page);
+        wal.putBytes(&after[page * CAREER_PAGE_SIZE], CAREER_PAGE_SIZE);
+    }
+    wal.putU64(fnv1a64(wal.data(), wal.size()));
+    vector<uint8_t> log(wal.data(), wal.data() + wal.size());
+    check(!changed.empty(), "a game changes pages");
+
+    writeBytes(path, before);
+    writeBytes(walPath, vector<uint8_t>(log.begin(), log.end() - 100));
+    {
+        CareerStore store;
+        check(store.open(path, walPath), "the store opens past a torn log");
+        checkCareers(store, previous, "after a torn log");
+    }
+    check(!ifstream(walPath), "a torn log is discarded");
+
+    writeBytes(path, before);
+    writeBytes(walPath, log);
+    {
+        CareerStore store;
+        check(store.open(path, walPath), "the store opens with a complete log");
+        checkCareers(store, model, "after redoing a complete log");
+    }
+    check(!ifstream(walPath), "a redone log is removed");
+    check(readBytes(path) == after, "redoing the log restores the pages byte for byte");
+    remove(path.c_str());
+    remove(walPath.c_str());
+}
+
+bool sameRolls(const RollColumns& columns, const RollRecord* rolls, size_t count) {
+    if (columns.size() != count) return false;
+    for (size_t i = 0; i < count; ++i) {
+        if (columns.games[i] != rolls[i].game || columns.rounds[i] != rolls[i].round ||
+            columns.players[i] != rolls[i].player || columns.faces[i] != rolls[i].face ||
+            columns.times[i] != rolls[i].timestamp) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Chunks decode to exactly the rolls encoded, whatever shape the columns
+// take, and a range scan skips every chunk its footer rules out while
+// counting the same rolls as a plain filter.
+void testExportRoundTrip() {
+    mt19937_64 rng(31337);
+    RollColumns columns;
+
+    // Single chunks at the edges of the encoding: one roll, seat 0 only
+    // (zero-bit players), every seat width up to 8 bits, ids that jump
+    // back and forth, and timestamps near the top of the range.
+    for (int trial = 0; trial < 300; ++trial) {
+        size_t count = trial == 0 ? 1 : uniform_int_distribution<size_t>(1, 3000)(rng);
+        int playerBits = trial % 9;
+        vector<RollRecord> rolls(count);
+        uint64_t game = trial % 2 ? numeric_limits<uint64_t>::max() - 5000 : 7;
+        for (size_t i = 0; i < count; ++i) {
+            if (trial % 3 == 0) game = rng();
+            else if (i % 17 == 0) game += uniform_int_distribution<int>(-3, 3)(rng);
+            rolls[i].game = game;
+            rolls[i].round = trial % 4 == 0 ? static_cast<uint32_t>(rng()) : static_cast<uint32_t>(i / 4 + 1);
+            rolls[i].player = static_cast<uint8_t>(playerBits == 0 ? 0 : rng() & ((1u << playerBits) - 1));
+            rolls[i].face = static_cast<uint8_t>(uniform_int_distribution<int>(1, 12)(rng));
+            rolls[i].timestamp = trial % 5 == 0 ? rng() : numeric_limits<uint64_t>::max() - 100000 + 10 * i;
+        }
+        SaveWriter out;
+        encodeRollChunk(rolls.data(), count, out);
+        RollChunkFooter footer;
+        bool decoded = footer.decode(out.data() + out.size() - ROLL_CHUNK_FOOTER_SIZE) &&
+                       decodeRollChunk(out.data() + 4, footer, columns);
+        check(decoded && sameRolls(columns, rolls.data(), count), "chunk round trip, trial " + to_string(trial));
+    }
+
+    // A file of classic games, four seats each, written partly through
+    // append() and partly through batched write().
+    const string path = "dice_tests_export.bin";
+    const uint64_t GAMES = 12000;
+    const int ROUNDS = 5, SEATS = 4;
+    vector<RollRecord> rolls;
+    uint64_t time = 0;
+    for (uint64_t game = 1; game <= GAMES; ++game) {
+        for (int round = 1; round <= ROUNDS; ++round) {
+            for (int seat = 0; seat < SEATS; ++seat) {
+                time += uniform_int_distribution<uint64_t>(1, 900)(rng);
+                rolls.push_back({game, static_cast<uint32_t>(round), static_cast<uint8_t>(seat),
+                                 static_cast<uint8_t>(uniform_int_distribution<int>(1, 6)(rng)), time});
+            }
+        }
+    }
+    {
+        RollExporter exporter;
+        check(exporter.open(path), "the export opens");
+        size_t half = rolls.size() / 2 + 12345;
+        for (size_t i = 0; i < half; ++i) exporter.append(rolls[i]);
+        exporter.flush();
+        for (size_t first = half; first < rolls.size(); first += 50000) {
+            exporter.write(rolls.data() + first, min<size_t>(50000, rolls.size() - first));
+        }
+        check(exporter.close() && exporter.rollsWritten() == rolls.size(), "every roll is written");
+    }
+
+    RollExportReader reader;
+    check(reader.open(path), "the export reads back");
+    RollChunkFooter footer;
+    size_t read = 0;
+    vector<pair<uint64_t, uint64_t>> chunkGames;
+    while (reader.nextChunk(footer)) {
+        bool decoded = reader.readColumns(columns);
+        check(decoded && read + columns.size() <= rolls.size() && sameRolls(columns, &rolls[read], columns.size()),
+              "chunk " + to_string(chunkGames.size()) + " decodes to the rolls written");
+        check(footer.minGame == *min_element(columns.games.begin(), columns.games.end()) &&
+                  footer.maxGame == *max_element(columns.games.begin(), columns.games.end()) &&
+                  footer.maxFace == *max_element(columns.faces.begin(), columns.faces.end()),
+              "chunk " + to_string(chunkGames.size()) + " footer ranges");
+        chunkGames.push_back({footer.minGame, footer.maxGame});
+        read += columns.size();
+    }
+    reader.close();
+    check(read == rolls.size(), "the whole export reads back");
+    check(chunkGames.size() > 3, "the export spans several chunks");
+
+    auto scanMatches = [&](uint64_t firstGame, uint64_t lastGame) {
+        RollExportSummary summary;
+        if (!scanRollExport(path, firstGame, lastGame, summary) || !summary.complete) return false;
+        uint64_t expected = 0, faces[16] = {}, skipped = 0;
+        for (const auto& roll : rolls) {
+            if (roll.game < firstGame || roll.game > lastGame) continue;
+            expected++;
+            faces[roll.face]++;
+        }
+        for (const auto& range : chunkGames) skipped += range.second < firstGame || range.first > lastGame;
+        return summary.rolls == expected && equal(begin(faces), end(faces), begin(summary.faces)) &&
+               summary.chunks == chunkGames.size() && summary.skipped == skipped;
+    };
+    check(scanMatches(1, GAMES), "a full scan counts every roll");
+    check(scanMatches(5000, 5010), "a narrow scan skips the chunks around it");
+    check(scanMatches(chunkGames[1].first, chunkGames[2].second), "a scan over whole chunks");
+    check(scanMatches(GAMES + 1, GAMES + 10), "a scan past the last game skips everything");
+
+    // A damaged payload ends the scan at that chunk, with the totals so far.
+    vector<uint8_t> bytes = readBytes(path);
+    size_t firstChunk = ROLL_EXPORT_HEADER_SIZE + 4 + loadLE32(&bytes[ROLL_EXPORT_HEADER_SIZE]) +
+                        ROLL_CHUNK_FOOTER_SIZE;
+    bytes[firstChunk + 10] ^= 0x40;
+    writeBytes(path, bytes);
+    RollExportSummary summary;
+    check(scanRollExport(path, 1, GAMES, summary) && !summary.complete && summary.rolls == ROLL_EXPORT_CHUNK,
+          "a damaged chunk stops the scan");
+    remove(path.c_str());
+}
+
+// The state a journal of plain-scored rounds should replay to, kept by hand:
+// every roll scores its face and a single highest roll takes the round.
+bool replayedTo(const SavedGame& game, const vector<vector<int>>& rounds, size_t completed) {
+    if (game.currentRound != static_cast<int>(completed) + 1) return false;
+    for (size_t seat = 0; seat < game.players.size(); ++seat) {
+        int score = 0, wins = 0;
+        vector<int> history;
+        for (size_t r = 0; r < completed; ++r) {
+            const vector<int>& rolls = rounds[r];
+            int top = *max_element(rolls.begin(), rolls.end());
+            score += rolls[seat];
+            wins += rolls[seat] == top && count(rolls.begin(), rolls.end(), top) == 1;
+            history.push_back(rolls[seat]);
+        }
+        const Player& player = game.players[seat];
+        vector<int> replayed(player.getDiceHistory().begin(), player.getDiceHistory().end());
+        if (player.getScore() != score || player.getWins() != wins || replayed != history) return false;
+    }
+    return true;
+}
+
+// Replay recovers exactly the whole rounds a journal holds: a tail torn at
+// any byte or a damaged record drops what follows, a half-written round is
+// left out, and a journal from another snapshot generation is refused.
+void testJournalReplay() {
+    const string path = "dice_tests.journal";
+    const uint64_t GENERATION = 9;
+    const size_t SEATS = 3, ROUNDS = 12;
+    SavedGame base;
+    base.generation = GENERATION;
+    base.currentRound = 1;
+    base.rules.rounds = 100;
+    base.state.reset(SEATS);
+    for (const char* name : {"Ann", "Bob", "Cid"}) base.players.emplace_back(name);
+
+    mt19937_64 rng(99);
+    vector<vector<int>> rounds(ROUNDS + 1, vector<int>(SEATS));
+    for (auto& rolls : rounds) {
+        for (int& roll : rolls) roll = uniform_int_distribution<int>(1, 6)(rng);
+    }
+    rounds[2] = {5, 5, 2};  // a tied round has no winner
+
+    auto winnerOf = [](const vector<int>& rolls) {
+        auto top = max_element(rolls.begin(), rolls.end());
+        return count(rolls.begin(), rolls.end(), *top) == 1 ? static_cast<int>(top - rolls.begin()) : -1;
+    };
+
+    RollJournal journal;
+    check(journal.start(path, GENERATION), "the journal starts");
+    for (size_t r = 0; r < ROUNDS; ++r) {
+        for (size_t seat = 0; seat < SEATS; ++seat) journal.appendRoll(seat, rounds[r][seat], static_cast<int>(r + 1));
+        journal.appendRoundEnd(winnerOf(rounds[r]), static_cast<int>(r + 1));
+    }
+    journal.appendRoll(0, rounds[ROUNDS][0], static_cast<int>(ROUNDS + 1));  // a round cut short
+    check(journal.commit(), "the journal commits");
+    vector<uint8_t> bytes = readBytes(path);
+    check(bytes.size() == JOURNAL_HEADER_SIZE + (ROUNDS * (SEATS + 1) + 1) * JOURNAL_RECORD_SIZE,
+          "every record reached the file");
+
+    for (size_t size = 0; size <= bytes.size(); ++size) {
+        SavedGame game = base;
+        int recovered = replayJournal(bytes.data(), size, game);
+        string label = "journal torn at byte " + to_string(size);
+        if (size < JOURNAL_HEADER_SIZE) {
+            check(recovered == -1, label + " has no header");
+            continue;
+        }
+        size_t whole = (size - JOURNAL_HEADER_SIZE) / JOURNAL_RECORD_SIZE / (SEATS + 1);
+        check(recovered == static_cast<int>(whole) && replayedTo(game, rounds, whole), label);
+    }
+
+    vector<uint8_t> damaged = bytes;
+    damaged[JOURNAL_HEADER_SIZE + 9 * JOURNAL_RECORD_SIZE + 2] ^= 0x01;  // round 3, second roll
+    SavedGame game = base;
+    check(replayJournal(damaged.data(), damaged.size(), game) == 2 && replayedTo(game, rounds, 2),
+          "a damaged record ends the replay");
+
+    game = base;
+    game.generation = GENERATION + 1;
+    check(replayJournal(bytes.data(), bytes.size(), game) == -1 && replayedTo(game, rounds, 0),
+          "a journal from another generation is refused");
+
+    // A journal that cannot be replaced stays open and keeps logging.
+    check(!journal.start("dice_tests_missing_dir/dice_tests.journal", GENERATION + 1),
+          "a journal in a missing directory does not start");
+    check(journal.isOpen(), "the old journal stays open");
+    for (size_t seat = 1; seat < SEATS; ++seat) journal.appendRoll(seat, rounds[ROUNDS][seat], ROUNDS + 1);
+    journal.appendRoundEnd(winnerOf(rounds[ROUNDS]), ROUNDS + 1);
+    journal.close();
+    bytes = readBytes(path);
+    game = base;
+    check(replayJournal(bytes.data(), bytes.size(), game) == static_cast<int>(ROUNDS) + 1 &&
+              replayedTo(game, rounds, ROUNDS + 1),
+          "the old journal logged the round after the failed start");
+    remove(path.c_str());
+}
+
+// Calls visit with every way dice dice of the given sides can land.
+void forEachRoll(size_t dice, int sides, const function<void(const vector<int>&)>& visit) {
+    vector<int> rolls(dice, 1);
+    while (true) {
+        visit(rolls);
+        size_t d = 0;
+        while (d < dice && rolls[d] == sides) rolls[d++] = 1;
+        if (d == dice) return;
+        rolls[d]++;
+    }
+}
+
+bool uniqueTop(const vector<int>& totals, size_t seat) {
+    for (size_t i = 0; i < totals.size(); ++i) {
+        if (i != seat && totals[i] >= totals[seat]) return false;
+    }
+    return true;
+}
+
+bool near(double a, double b) { return fabs(a - b) <= 1e-12; }
+
+// Exact odds summed term by term; long double keeps millions of tiny terms
+// from drifting past the tolerance.
+struct EnumeratedOdds {
+    long double win = 0.0L;
+    vector<long double> lengths = vector<long double>(1, 0.0L);
+};
+
+bool sameLengths(const GameOdds& odds, const vector<long double>& lengths) {
+    size_t size = max(odds.lengths.size(), lengths.size());
+    long double expected = 0.0L;
+    for (size_t r = 0; r < size; ++r) {
+        double a = r < odds.lengths.size() ? odds.lengths[r] : 0.0;
+        double b = r < lengths.size() ? double(lengths[r]) : 0.0;
+        if (!near(a, b)) return false;
+        expected += r * (r < lengths.size() ? lengths[r] : 0.0L);
+    }
+    return fabs(odds.expectedRounds - double(expected)) <= 1e-9;
+}
+
+// Plays out every Target game from the given totals, weighting each by its
+// probability, and books who won and how long it took.
+void enumerateTarget(const vector<int>& totals, int sides, int target, size_t round, long double chance,
+                     EnumeratedOdds& odds) {
+    long double each = chance / powl(sides, totals.size());
+    forEachRoll(totals.size(), sides, [&](const vector<int>& rolls) {
+        vector<int> next(totals);
+        for (size_t i = 0; i < next.size(); ++i) next[i] += rolls[i];
+        if (*max_element(next.begin(), next.end()) < target) {
+            enumerateTarget(next, sides, target, round + 1, each, odds);
+            return;
+        }
+        if (odds.lengths.size() <= round) odds.lengths.resize(round + 1, 0.0L);
+        odds.lengths[round] += each;
+        if (uniqueTop(next, 0)) odds.win += each;
+    });
+}
+
+// Every roll of every round enumerated outright, against the closed forms,
+// tables and recurrences the odds engine uses. Elimination can run forever,
+// so its rounds are played over sets of seats still in until what is left
+// is negligible.
+void testOddsEnumeration() {
+    OddsEngine& engine = OddsEngine::instance();
+
+    for (int players = 2; players <= 9; ++players) {
+        for (int sides = MIN_DICE_SIDES; sides <= MAX_DICE_SIDES; ++sides) {
+            if (pow(double(sides), players) > 3e5) continue;
+            uint64_t wins = 0, ties = 0, outcomes = 0;
+            forEachRoll(players, sides, [&](const vector<int>& rolls) {
+                outcomes++;
+                wins += uniqueTop(rolls, 0);
+                bool anyTop = false;
+                for (size_t i = 0; i < rolls.size(); ++i) anyTop = anyTop || uniqueTop(rolls, i);
+                ties += !anyTop;
+            });
+            RoundOdds odds = OddsEngine::round(players, sides);
+            string label = to_string(players) + " players, d" + to_string(sides);
+            check(near(odds.win, double(wins) / outcomes) && near(odds.tie, double(ties) / outcomes),
+                  "round odds for " + label);
+        }
+    }
+
+    // Table entries (up to 4 players and 20 rounds) and computed ones.
+    const int classicCases[][3] = {{2, 4, 1}, {2, 4, 5}, {2, 6, 3}, {2, 12, 2}, {3, 4, 3}, {3, 6, 2},
+                                   {4, 4, 2}, {4, 5, 2}, {5, 4, 2}, {5, 6, 1}, {6, 4, 1}};
+    for (const auto& c : classicCases) {
+        int players = c[0], sides = c[1], rounds = c[2];
+        uint64_t wins = 0, outcomes = 0;
+        vector<int> totals(players);
+        forEachRoll(players * rounds, sides, [&](const vector<int>& rolls) {
+            fill(totals.begin(), totals.end(), 0);
+            for (size_t d = 0; d < rolls.size(); ++d) totals[d % players] += rolls[d];
+            outcomes++;
+            wins += uniqueTop(totals, 0);
+        });
+        GameOdds odds;
+        string label = to_string(players) + " players, d" + to_string(sides) + ", " + to_string(rounds) + " rounds";
+        check(engine.classic(players, sides, rounds, odds) && near(odds.win, double(wins) / outcomes) &&
+                  near(odds.tie, 1.0 - players * double(wins) / outcomes),
+              "classic odds for " + label);
+    }
+
+    const int targetCases[][3] = {{2, 4, 1}, {2, 4, 6}, {2, 6, 8}, {2, 12, 9}, {3, 4, 5}, {3, 6, 6}, {4, 4, 4}};
+    for (const auto& c : targetCases) {
+        int players = c[0], sides = c[1], target = c[2];
+        EnumeratedOdds expected;
+        GameOdds odds;
+        enumerateTarget(vector<int>(players, 0), sides, target, 1, 1.0L, expected);
+        string label = to_string(players) + " players, d" + to_string(sides) + ", target " + to_string(target);
+        check(engine.target(players, sides, target, odds) && near(odds.win, double(expected.win)) &&
+                  near(odds.tie, double(1.0L - players * expected.win)) && sameLengths(odds, expected.lengths),
+              "target odds for " + label);
+    }
+
+    for (int players = 2; players <= 4; ++players) {
+        for (int sides : {4, 6, 12}) {
+            // in[mask]: chance the seats in mask are the ones still in.
+            vector<long double> in(size_t(1) << players, 0.0L), next(in.size());
+            in.back() = 1.0L;
+            EnumeratedOdds expected;
+            vector<long double> winner(players, 0.0L);
+            while (accumulate(in.begin(), in.end(), 0.0L) > 1e-18L) {
+                fill(next.begin(), next.end(), 0.0L);
+                for (size_t mask = 0; mask < in.size(); ++mask) {
+                    if (in[mask] == 0.0L) continue;
+                    vector<size_t> seats;
+                    for (int i = 0; i < players; ++i) {
+                        if (mask >> i & 1) seats.push_back(i);
+                    }
+                    long double each = in[mask] / powl(sides, seats.size());
+                    forEachRoll(seats.size(), sides, [&](const vector<int>& rolls) {
+                        int low = *min_element(rolls.begin(), rolls.end());
+                        size_t left = mask;
+                        if (low != *max_element(rolls.begin(), rolls.end())) {
+                            for (size_t i = 0; i < seats.size(); ++i) {
+                                if (rolls[i] == low) left &= ~(size_t(1) << seats[i]);
+                            }
+                        }
+                        next[left] += each;
+                    });
+                }
+                expected.lengths.push_back(0.0L);
+                for (int i = 0; i < players; ++i) {
+                    winner[i] += next[size_t(1) << i];
+                    expected.lengths.back() += next[size_t(1) << i];
+                    next[size_t(1) << i] = 0.0L;
+                }
+                in.swap(next);
+            }
+            GameOdds odds;
+            string label = to_string(players) + " players, d" + to_string(sides);
+            check(engine.elimination(players, sides, odds) && near(odds.win, double(winner[0])) &&
+                      sameLengths(odds, expected.lengths),
+                  "elimination odds for " + label);
+        }
+    }
+}
+
+#ifdef __linux__
+string ask(SessionTable& table, vector<uint64_t>& owned, const string& line) {
+    string reply;
+    handleRequest(table, line, reply, owned);
+    return reply;
+}
+#endif
+
+// The server's line protocol, request by request: replies, every error, the
+// end of a game, and sessions freed at END, on disconnect, when idle, and
+// refused once a shard is full.
+void testServerProtocol() {
+#ifdef __linux__
+    SessionTable table(4, RngEngine::Pcg64, 11);
+    vector<uint64_t> owned;
+    for (const char* bad : {"NEW 3 5", "NEW 13 5", "NEW 6 0", "NEW 6", "NEW six 5", "", "HELLO", "ROLL", "STATE"}) {
+        check(ask(table, owned, bad) == "ERR bad request\n", string("\"") + bad + "\" is a bad request");
+    }
+    check(ask(table, owned, "NEW 6 2") == "OK 1\n" && owned == vector<uint64_t>{1}, "NEW opens session 1");
+    check(ask(table, owned, "JOIN 1 ann") == "OK 0\n", "the first JOIN takes seat 0");
+    check(ask(table, owned, "ROLL 1 0") == "ERR need 2 players\n", "one player cannot roll");
+    check(ask(table, owned, "JOIN 1 bob") == "OK 1\n", "the second JOIN takes seat 1");
+    for (const char* bad : {"JOIN 1", "JOIN 1 a:b", "JOIN 1 abcdefghijklmnopqrstuvwxyz0123456"}) {
+        check(ask(table, owned, bad) == "ERR bad name\n", string("\"") + bad + "\" has a bad name");
+    }
+    check(ask(table, owned, "JOIN 9 cid") == "ERR no such session\n", "JOIN to an unknown session");
+    check(ask(table, owned, "STATE 1") == "STATE 1 2 0 2 ann:0:0 bob:0:0\n", "STATE before the first roll");
+    check(ask(table, owned, "ROLL 1 1") == "ERR not your turn\n", "rolling out of turn");
+    check(ask(table, owned, "ROLL 1 -1") == "ERR not your turn\n", "rolling for a negative seat");
+    check(ask(table, owned, "ROLL 9 0") == "ERR no such session\n", "ROLL in an unknown session");
+
+    // Requests may be pipelined: replies append in order.
+    string replies;
+    handleRequest(table, "ROLL 1 0", replies, owned);
+    check(ask(table, owned, "JOIN 1 cid") == "ERR game already started\n", "JOIN once rolling has started");
+    handleRequest(table, "ROLL 1 1", replies, owned);
+    int first, second, round, winner;
+    char rest[8] = {};
+    int fields = sscanf(replies.c_str(), "ROLL %d\nROLL %d ROUND %d WINNER %d%7s", &first, &second, &round, &winner,
+                        rest);
+    check(fields == 4 && first >= 1 && first <= 6 && second >= 1 && second <= 6 && round == 1 &&
+              winner == (first > second ? 0 : first < second ? 1 : -1),
+          "a complete round reports its winner: " + replies);
+    check(ask(table, owned, "STATE 1") == "STATE 2 2 0 2 ann:" + to_string(first) + ":" + to_string(winner == 0) +
+                                              " bob:" + to_string(second) + ":" + to_string(winner == 1) + "\n",
+          "STATE after a round");
+
+    ask(table, owned, "ROLL 1 0");
+    string last = ask(table, owned, "ROLL 1 1");
+    check(last.size() > 5 && last.compare(last.size() - 5, 5, " END\n") == 0, "the last roll ends the game");
+    check(ask(table, owned, "STATE 1") == "ERR no such session\n" && owned.empty() && table.size() == 0,
+          "a finished session is freed");
+
+    // A table of 64 seats is full.
+    check(ask(table, owned, "NEW 4 1") == "OK 2\n", "a second session opens");
+    for (int seat = 0; seat < 64; ++seat) ask(table, owned, "JOIN 2 p" + to_string(seat));
+    check(ask(table, owned, "JOIN 2 late") == "ERR table full\n", "a 65th seat is refused");
+
+    // The server frees what a connection opened when it closes.
+    vector<uint64_t> other;
+    check(ask(table, other, "NEW 6 3") == "OK 3\n" && table.size() == 2, "another connection opens a session");
+    for (uint64_t session : owned) table.erase(session);
+    check(table.size() == 1 && ask(table, other, "STATE 3").compare(0, 6, "STATE ") == 0,
+          "closing a connection frees only its own sessions");
+
+    // One shard of two sessions: NEW is refused while both are live and
+    // answered again once one ends.
+    SessionTable small(1, RngEngine::Pcg64, 11, 2, chrono::hours(1));
+    owned.clear();
+    check(ask(small, owned, "NEW 6 1") == "OK 1\n" && ask(small, owned, "NEW 6 1") == "OK 2\n", "a full shard");
+    check(ask(small, owned, "NEW 6 1") == "ERR too many sessions\n", "NEW on a full shard is refused");
+    ask(small, owned, "JOIN 1 ann");
+    ask(small, owned, "JOIN 1 bob");
+    ask(small, owned, "ROLL 1 0");
+    ask(small, owned, "ROLL 1 1");
+    check(ask(small, owned, "NEW 6 1") == "OK 4\n", "an ended session makes room");
+
+    // With no idle allowance every untouched session expires on the next NEW.
+    SessionTable idle(1, RngEngine::Pcg64, 11, 2, chrono::steady_clock::duration::zero());
+    owned.clear();
+    ask(idle, owned, "NEW 6 1");
+    ask(idle, owned, "NEW 6 1");
+    check(ask(idle, owned, "NEW 6 1") == "OK 3\n" && idle.size() == 1, "idle sessions expire");
+    check(ask(idle, owned, "STATE 1") == "ERR no such session\n", "an expired session is gone");
+#endif
+}
+
+// Tallies a stream the way FairnessHarness does for a single chunk.
+FairnessTally tallyStream(const vector<int>& faces, int sides) {
+    FairnessTally tally;
+    int previous = -1;
+    size_t run = 0, gap = 0;
+    bool seenLow = false;
+    for (size_t i = 0; i < faces.size(); ++i) {
+        int face = faces[i];
+        tally.faces[face]++;
+        if (i & 1) tally.pairs[faces[i - 1] * 16 + face]++;
+        if (face == previous) {
+            run++;
+        } else {
+            if (run > 0) tally.runs[min(run - 1, FAIRNESS_BINS - 1)]++;
+            run = 1;
+            previous = face;
+        }
+        if (face <= sides / 2) {
+            if (seenLow) tally.gaps[min(gap, FAIRNESS_BINS - 1)]++;
+            seenLow = true;
+            gap = 0;
+        } else {
+            gap++;
+        }
+    }
+    tally.rolls = faces.size();
+    return tally;
+}
+
+// The fairness harness passes the game's own dice and flags streams that
+// are biased in ways each of its four tests is meant to catch.
+void testFairnessRejectsBias() {
+    for (int sides : {4, 6, 12}) {
+        FairnessReport one = FairnessHarness(RngEngine::Pcg64, 3, 3 * FAIRNESS_CHUNK, 1).run(sides);
+        FairnessReport four = FairnessHarness(RngEngine::Pcg64, 3, 3 * FAIRNESS_CHUNK, 4).run(sides);
+        check(one.passed() && one.rolls == 3 * FAIRNESS_CHUNK, "a fair d" + to_string(sides) + " passes");
+        check(one.frequency.statistic == four.frequency.statistic && one.serial.statistic == four.serial.statistic &&
+                  one.runs.statistic == four.runs.statistic && one.gaps.statistic == four.gaps.statistic,
+              "the report does not depend on the thread count");
+    }
+
+    const int sides = 6;
+    const size_t count = 600000;
+    mt19937_64 rng(2718);
+    uniform_int_distribution<int> face(1, sides), low(1, sides / 2), high(sides / 2 + 1, sides);
+    uniform_real_distribution<double> chance(0.0, 1.0);
+    vector<int> fair, modulo, sticky, clumped;
+    for (size_t i = 0; i < count; ++i) {
+        fair.push_back(face(rng));
+        // Reducing a 3-bit draw mod 6 makes 1 and 2 twice as likely.
+        modulo.push_back(int(rng() % 8) % sides + 1);
+        // Repeats the last face one time in twenty.
+        sticky.push_back(i > 0 && chance(rng) < 0.05 ? sticky.back() : face(rng));
+        // A low face is followed by another low face 55% of the time, which
+        // leaves each face equally likely but shortens the gaps.
+        bool wasLow = i > 0 && clumped.back() <= sides / 2;
+        bool isLow = i > 0 ? chance(rng) < (wasLow ? 0.55 : 0.45) : chance(rng) < 0.5;
+        clumped.push_back(isLow ? low(rng) : high(rng));
+    }
+
+    FairnessReport report = evaluateFairness(sides, tallyStream(fair, sides));
+    check(report.passed(), "a fair stream tallied in the test passes");
+
+    report = evaluateFairness(sides, tallyStream(modulo, sides));
+    check(report.frequency.pValue < FAIRNESS_ALPHA && !report.passed(), "modulo bias fails the frequency test");
+
+    report = evaluateFairness(sides, tallyStream(sticky, sides));
+    check(report.frequency.pValue >= FAIRNESS_ALPHA, "a sticky die still shows each face equally often");
+    check(report.runs.pValue < FAIRNESS_ALPHA && report.serial.pValue < FAIRNESS_ALPHA,
+          "a sticky die fails the runs and serial tests");
+
+    report = evaluateFairness(sides, tallyStream(clumped, sides));
+    check(report.frequency.pValue >= FAIRNESS_ALPHA, "clumped low faces still show each face equally often");
+    check(report.gaps.pValue < FAIRNESS_ALPHA, "clumped low faces fail the gap test");
+}
+
+struct TestCase {
+    const char* name;
+    void (*run)();
+};
+
+const TestCase TESTS[] = {
+    {"player_aggregates", testPlayerAggregates},
+    {"consistency_order", testConsistencyOrder},
+    {"roll_history_range", testRollHistoryRange},
+    {"history_chunks", testHistoryChunks},
+    {"save_validation", testSaveValidation},
+    {"trace_load", testTraceLoad},
+    {"round_allocations", testRoundAllocations},
+    {"timeline_rewind", testTimelineRewind},
+    {"career_store", testCareerStore},
+    {"export_roundtrip", testExportRoundTrip},
+    {"journal_replay", testJournalReplay},
+    {"odds_enumeration", testOddsEnumeration},
+    {"server_protocol", testServerProtocol},
+    {"fairness_rejects_bias", testFairnessRejectsBias},
+};
+
+int main(int argc, char* argv[]) {
+    int ran = 0;
+    for (const auto& test : TESTS) {
+        bool wanted = argc < 2;
+        for (int i = 1; i < argc; ++i) wanted = wanted || strcmp(argv[i], test.name) == 0;
+        if (!wanted) continue;
+        int before = failures;
+        test.run();
+        cout << (failures == before ? "PASS " : "FAIL ") << test.name << "\n";
+        ran++;
+    }
+    if (ran == 0) {
+        cerr << RED << "No test matches the given names" << RESET << "\n";
+        return 2;
+    }
+    return failures == 0 ? 0 : 1;
+}